@@ -335,6 +335,32 @@ void thread_stop(struct thread_Settings* thread) {
 #endif
 } // end Stop
 
+/* -------------------------------------------------------------------
+ * A --worker-pool server stream has no thread of its own, count it
+ * as a server traffic thread so joinall, -1 and -P on the server
+ * behave as they do for thread per connection.
+ * ------------------------------------------------------------------- */
+void thread_pooled_start(struct thread_Settings* thread) {
+    Condition_Lock(thread_sNum_cond);
+    thread_sNum++;
+    thread_trfc_sNum++;
+    Condition_Unlock(thread_sNum_cond);
+#if HAVE_THREAD_DEBUG
+    thread_debug("Pooled stream start(%p) thread counts tot/trfc=%d/%d", (void *)thread, thread_sNum, thread_trfc_sNum);
+#endif
+}
+
+void thread_pooled_stop(struct thread_Settings* thread) {
+    Condition_Lock(thread_sNum_cond);
+    thread_sNum--;
+    thread_trfc_sNum--;
+    Condition_Signal(&thread_sNum_cond);
+    Condition_Unlock(thread_sNum_cond);
+    Settings_Destroy(thread);
+    // signal the reporter thread now that thread state has changed
+    Condition_Signal(&ReportCond);
+}
+
 /* -------------------------------------------------------------------
  * This function is the entry point for new threads created in
  * thread_start.
@@ -377,6 +403,14 @@ thread_run_wrapper(void* paramPtr) {
                 // Decrement the non-terminating thread count
                 thread_unregister_nonterm();
             } break;
+        case kMode_ServerWorker:
+            {
+                // Like the listener, joinall waits on the worker's
+                // streams rather than the worker itself
+                thread_register_nonterm();
+                server_worker_spawn(thread);
+                thread_unregister_nonterm();
+            } break;
         default:
             {
                 FAIL(1, "Unknown Thread Type!\n", thread);
@@ -87,8 +87,11 @@ public:
 
 private:
     inline void WritePacketID(intmax_t);
+    inline void WritePacketID(char *, intmax_t);
     inline void WriteTcpTxHdr(struct ReportStruct *, int, int);
     inline double get_delay_target(void);
+    void udp_vary_load(double &);
+    void udp_running_delay(double &, double, int);
     void InitTrafficLoop(void);
     void SetReportStartTime(void);
     inline void SetFullDuplexReportStartTime(void);
@@ -114,14 +117,27 @@ private:
     // TCP version which supports rate limiting per -b
     void RunRateLimitedTCP(void);
     void RunNearCongestionTCP(void);
+#if HAVE_IO_URING
+    // TCP on io_uring, --io-uring
+    void RunTCPUring(void);
+#endif
 #if HAVE_DECL_TCP_NOTSENT_LOWAT
+    long WriteEventTimeout(void);
     bool AwaitWriteSelectEventTCP(void);
     void RunWriteEventsTCP(void);
+#if HAVE_IO_URING
+    // --tcp-write-prefetch on io_uring
+    void RunWriteEventsTCPUring(void);
+#endif
 #endif
     // UDP traffic with isochronous and vbr support
     void RunUDPIsochronous(void);
     // UDP plain
     void RunUDP(void);
+#if defined(__linux__)
+    // UDP with batched writes, sendmmsg() or UDP GSO
+    void RunUDPBatch(void);
+#endif
     // client connect
     void PeerXchange(void);
     thread_Settings *mSettings;
@@ -133,6 +149,7 @@ private:
     struct ReporterData *myReport;
     Timestamp mEndTime;
     Timestamp lastPacketTime;
+    Timestamp varyload_time;
     Timestamp now;
     char* readAt;
     Timestamp connect_done, connect_start;
@@ -143,7 +160,72 @@ private:
     Timestamp drain_end;
     // OpenSSL support
     ssize_t sendTCP(int fd, const void *buffer, size_t len, int flags );
+    inline ssize_t sendUDP(int fd, const void *buffer, size_t len);
+    bool TLSHandshake(void);
+    void TLSShutdown(void);
+    inline bool isTLSHandshakeDeferred(void);
+    void PostConnectionReport(double connecttime);
+    void TLSKernelOffload(void);
     SSL *conn;
+    SSL_SESSION *tls_session;
+    // kTLS, the kernel owns the record layer after the handshake
+    bool ktls_tx;
+    bool tls_sendfile;
+    off_t sendfile_offset;
+    off_t sendfile_size;
+    // --sendfile, the kernel moves the -F/-I input to the socket
+    bool file_sendfile;
+    bool file_splice;
+    // --tls-coalesce, stage the writes into full size records
+    ssize_t TLSWriteRecords(const void *buffer, size_t len);
+    bool TLSWriteAll(const char *buffer, size_t len);
+    inline int TLSRecordCount(size_t len);
+    char *tls_coalesce_buf;
+    size_t tls_coalesce_size;
+    size_t tls_coalesce_fill;
+    // --tls-rekey, rotate the traffic keys every N bytes or seconds
+    inline bool TLSRekeyDue(void);
+    void TLSRekey(void);
+    intmax_t tls_rekey_mark;
+    Timestamp tls_rekey_next;
+    // --zerocopy, MSG_ZEROCOPY sends from a pool of buffers which are
+    // pinned by the kernel until their completions are reaped
+    char *zc_pool;
+    bool *zc_busy;
+    int zc_poolsize;
+    uint32_t zc_sendid;
+#if HAVE_MSG_ZEROCOPY
+    void ZeroCopyInit(void);
+    ssize_t ZeroCopySend(int fd, const void *buffer, size_t len, int flags, size_t hdrlen);
+    int ZeroCopyReap(int timeout_ms);
+    bool ZeroCopyAwait(int slot);
+    void ZeroCopyDrain(void);
+    void ZeroCopyFree(void);
+#endif
+    // --txtime, each datagram carries its SO_TXTIME launch time and the
+    // ring holds those per timestamp id to match the tx stamps against
+    uint64_t *txt_launch;
+    uint32_t txt_sendid;
+    uint32_t txt_reapid;
+    uint64_t txt_last;
+    int64_t txt_offset;
+    bool txt_stamping;
+#if HAVE_SO_TXTIME
+    void RunUDPTxTime(void);
+    bool TxTimeInit(void);
+    inline uint64_t TxTimeNow(void);
+    void TxTimeWait(uint64_t until);
+    ssize_t TxTimeSend(int fd, const void *buffer, size_t len, uint64_t launch);
+    int TxTimeReap(int timeout_ms);
+    void TxTimeDrain(void);
+    void TxTimeFree(void);
+#endif
+    // --af-xdp, the datagrams go out as frames of an AF_XDP socket
+    struct xdpsock *xdp;
+#if HAVE_AF_XDP
+    bool XdpInit(void);
+    void RunUDPXdp(void);
+#endif
 }; // end class Client
 
 #endif // CLIENT_H
@@ -91,6 +91,12 @@ private:
     bool tap_setup(thread_Settings *server, int sockfd);
     void UDPSingleServer(thread_Settings *server);
     bool test_permit_key(uint32_t flags, thread_Settings *server, int keyoffset);
+#if HAVE_LISTEN_SHARDS
+    int ShardAffinity(void);
+    void ShardListenOptions(void);
+    void ShardSteering(void);
+    int shard_cpu;
+#endif
 #if WIN32
     SOCKET ListenSocket;
 #else
@@ -307,6 +307,24 @@ extern const char report_l2statistics[];
 
 extern const char report_sum_outoforder[];
 
+extern const char report_counters[];
+
+extern const char report_sumcnt_counters[];
+
+extern const char report_sum_counters[];
+
+extern const char report_cpustats[];
+
+extern const char report_tlsrecords[];
+
+extern const char report_zerocopy[];
+
+extern const char report_txtime[];
+
+extern const char report_busypoll[];
+
+extern const char report_tlsrekeys[];
+
 extern const char report_peer[];
 
 extern const char report_peer_dev[];
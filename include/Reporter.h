@@ -134,6 +134,24 @@ struct WriteStats {
     int WriteErr;
     int totWriteCnt;
     int totWriteErr;
+    int TLSRecords;
+    int totTLSRecords;
+    int TLSRekeys;
+    int totTLSRekeys;
+    double TLSRekeyStall;
+    double totTLSRekeyStall;
+    int ZCZeroCopy;
+    int totZCZeroCopy;
+    int ZCCopied;
+    int totZCCopied;
+    int TxTStamps;
+    int totTxTStamps;
+    int TxTMissed;
+    int totTxTMissed;
+    double TxTDev;
+    double totTxTDev;
+    double TxTDevMax;
+    double totTxTDevMax;
 #if (HAVE_TCP_STATS)
     int TCPretry;
     int totTCPretry;
@@ -205,6 +223,7 @@ struct ReportCommon {
     int flags;
     int flags_extend;
     int flags_extend2;
+    int flags_extend3;
     int threads;
     unsigned short Port;
     unsigned short PortLast;
@@ -227,6 +246,15 @@ struct ReportCommon {
     int WritePrefetch;
 #endif
     int winsize_requested;
+    int TLSPipelines;
+    int UDPBatch;
+    int IOUringDepth;
+    int Workers;
+    int ListenShards;
+    int TxTimeLead;
+    int BusyPoll;
+    int XdpQueue;
+    int ReporterThreads;
     unsigned int FQPacingRate;
     int HistBins;
     int HistBinsize;
@@ -268,6 +296,13 @@ struct ConnectionInfo {
     int winsize;
     char peerversion[PEERVERBUFSIZE];
     struct MeanMinMaxStats connect_times;
+    double tlshandshaketime;
+    int tlshandshakeflags;
+    struct MeanMinMaxStats tlshandshake_times;
+    int tlsresumed_cnt;
+    int tlsearlydata_cnt;
+    double tlshandshake_first; // unix time in secs
+    double tlshandshake_last;
     int MSS;
 };
 
@@ -289,6 +324,21 @@ struct ShiftCounters {
     struct ShiftIntCounter IPG;
 };
 
+struct CPUStats {
+    int cycles_fd; // perf counter, owned by the traffic thread
+    bool hasCycles;
+    struct reportstruct_cpustats start;
+    struct reportstruct_cpustats prev;
+    struct reportstruct_cpustats current;
+    struct reportstruct_cpustats cnt; // values for the report being output
+};
+
+struct BusyPollStats {
+    struct reportstruct_busypoll prev;
+    struct reportstruct_busypoll current;
+    struct reportstruct_busypoll cnt; // values for the report being output
+};
+
 struct IsochStats {
     double mFPS; //frames per second
     double mMean; //variable bit rate mean
@@ -337,6 +387,7 @@ struct ReportTimeStamps {
     struct timeval intervalTime;
     struct timeval IPGstart;
     struct timeval nextTCPStampleTime;
+    struct timeval nextCPUSampleTime;
 };
 
 struct TransferInfo {
@@ -370,6 +421,9 @@ struct TransferInfo {
     bool final;
     bool burstid_transition;
     bool isEnableTcpInfo;
+    bool isEnableCPUStats;
+    struct CPUStats cpustats;
+    struct BusyPollStats busypoll;
 #if HAVE_DECL_TCP_NOTSENT_LOWAT
     struct DrainStats drain_mmm;
     struct histogram *drain_histogram;
@@ -379,12 +433,24 @@ struct TransferInfo {
 struct SumReport {
     struct ReferenceMutex reference;
     int threads;
+    int intervals; // sum interval reports output
     struct TransferInfo info;
     void (*transfer_protocol_sum_handler) (struct TransferInfo *stats, int final);
     struct BarrierMutex fullduplex_barrier;
     int sum_fd_set;
 };
 
+// Plain TCP throughput tests, the traffic thread folds its writes
+// (or reads) into this block and only enqueues it on an interval
+// crossing or an event which needs its own packet (see ReportPacket).
+// It's written only by the traffic thread, so it's its own cache line
+// aligned allocation and its size rounds up to whole cache lines.
+struct ReportAggregate {
+    struct ReportStruct packet;
+    int count;
+    struct timeval nextTime;
+} __attribute__((aligned(PACKETRING_CACHELINE)));
+
 struct ReporterData {
     // function pointer for per packet processing
     void (*packet_handler_pre_report) (struct ReporterData *data, struct ReportStruct *packet);
@@ -399,6 +465,26 @@ struct ReporterData {
     struct SumReport *GroupSumReport;
     struct SumReport *FullDuplexReport;
     struct TransferInfo info;
+
+    // --reporter-threads, the owning shard (zero is the reporter
+    // thread) and the handoff state between the two
+    int shard;
+    int shardstate;
+    struct ReporterData *shardnext;
+    // packet time of the last packet the shard drained, and the
+    // sum intervals this report has folded into (see the SumReport's intervals)
+    struct timeval shardpacketTime;
+    int sumfolds;
+    int fullduplexfolds;
+    // packet ring depth per consumer pass and the wakeups this
+    // report's traffic thread sent to a sleeping reporter
+    int ringdepth_max;
+    intmax_t ringdepth_sum;
+    intmax_t ringdepth_samples;
+    int wakeups_ring;
+    int wakeups_interval;
+    struct timeval nextWakeTime; // traffic thread owned
+    struct ReportAggregate *aggregate;
 };
 
 struct ServerRelay {
@@ -430,6 +516,7 @@ struct ReportHeader *InitSettingsReport(struct thread_Settings *inSettings);
 struct ReportHeader* InitServerRelayUDPReport(struct thread_Settings *inSettings, struct server_hdr *server);
 void PostReport(struct ReportHeader *reporthdr);
 bool ReportPacket (struct ReporterData* data, struct ReportStruct *packet);
+void InitCPUStats(struct ReporterData *data);
 int EndJob(struct ReportHeader *reporthdr,  struct ReportStruct *packet);
 void FreeReport(struct ReportHeader *reporthdr);
 void FreeSumReport (struct SumReport *sumreport);
@@ -443,6 +530,14 @@ int DecrSumReportRefCounter(struct SumReport *sumreport);
 extern struct AwaitMutex reporter_state;
 extern struct AwaitMutex threads_start;
 
+// Totals of the final TCP client transfer reports, e.g. for --tls-cipher-sweep.
+// Only the reporter thread writes these so read them after the threads are joined
+struct FinalTally {
+    intmax_t bytes;
+    double seconds;
+};
+extern struct FinalTally reporter_final_tally;
+
 extern report_connection connection_reports[];
 extern report_settings settings_reports[];
 extern report_statistics statistics_reports[];
@@ -554,8 +649,9 @@ void reporter_peerversion (struct ConnectionInfo *report, uint32_t upper, uint32
 void PrintMSS(struct ReporterData *data);
 void reporter_default_heading_flags(int);
 void reporter_connect_printf_tcp_final(struct ConnectionInfo *report);
+void reporter_print_ring_stats(struct ReporterData *data);
 
-void write_UDP_AckFIN(struct TransferInfo *stats, int len);
+void write_UDP_AckFIN(struct TransferInfo *stats, void *conn, int len);
 
 int reporter_process_transfer_report (struct ReporterData *this_ireport);
 int reporter_process_report (struct ReportHeader *reporthdr);
@@ -73,6 +73,18 @@ public:
     void RunTCP(void);
     void RunTcpBounceBack(void);
     static void Sig_Int(int inSigno);
+#if HAVE_WORKER_POOL
+    // --worker-pool, the stream is driven by a worker's epoll loop
+    // rather than RunTCP(), false returns mean the stream is done
+    bool PollStart(void);
+    bool PollRead(void);
+    bool PollTick(void);
+#endif
+#if HAVE_IO_URING
+    // an io_uring receive completion of RunTCPUring() or a worker's ring
+    bool UringRecv(int res);
+#endif
+    void FinishTCP(void);
 
 private:
     thread_Settings *mSettings;
@@ -86,7 +98,48 @@ private:
     inline void SetFullDuplexReportStartTime(void);
     inline void SetReportStartTime();
     int ReadWithRxTimestamp(void);
+#if defined(__linux__)
+    int ReadBatchWithRxTimestamp(void);
+    void InitReadBatch(void);
+    void FreeReadBatch(void);
+#endif
     bool ReadPacketID(void);
+#if HAVE_IO_URING
+    bool RunTCPUring(void);
+#endif
+#if HAVE_SENDFILE_SPLICE
+    // --null-sink, splice() the socket through a pipe into /dev/null
+    bool InitNullSink(void);
+    ssize_t recvNullSink(int fd, size_t len);
+    void FreeNullSink(void);
+    int sink_pipe[2];
+    int sink_null;
+#endif
+    // --af-xdp, the flow's datagrams are redirected to an AF_XDP socket
+    struct xdpsock *xdp;
+#if HAVE_AF_XDP
+    void XdpInit(void);
+    int ReadXdpWithRxTimestamp(void);
+    struct sockaddr_in xdp_peer;
+    unsigned xdp_count;
+    unsigned xdp_next;
+    int xdp_pollms;
+    bool xdp_draining;
+#endif
+    // MSG_DONTWAIT while a --busy-poll spins on the read, else zero
+    int busypoll_flags;
+#if HAVE_BUSY_POLL
+    // --busy-poll, spin on the non-blocking read before it blocks
+    void BusyPollInit(void);
+    inline void BusyPollStart(void);
+    inline bool BusyPollAgain(ssize_t rc);
+    inline void BusyPollSpin(int fd);
+    inline void BusyPollDone(void);
+    bool busypoll;
+    bool busypoll_sleeping;
+    struct timespec busypoll_start;
+    struct timespec busypoll_mark;
+#endif
     void L2_processing(void);
     int L2_quintuple_filter(void);
     void udp_isoch_processing(int);
@@ -114,6 +167,19 @@ private:
     struct msghdr message;
     char ctrl[CMSG_SPACE(sizeof(struct timeval))];
     struct cmsghdr *cmsg;
+#endif
+    // the datagram being processed, mBuf or a --udp-batch slot
+    char *rxbuf;
+#if defined(__linux__)
+    // --udp-batch, recvmmsg() and optional UDP GRO
+    struct mmsghdr *rxb_msgs;
+    struct iovec *rxb_iov;
+    char *rxb_buf;
+    char *rxb_ctrl;
+    int rxb_slotsize;
+    int rxb_count;
+    int rxb_next;
+    int rxb_offset;
 #endif
 #if defined(HAVE_LINUX_FILTER_H) && defined(HAVE_AF_PACKET)
     struct ether_header *eth_hdr;
@@ -122,7 +188,10 @@ private:
 #endif
     // OpenSSL support
     SSL *conn;
+    bool ktls_rx;
     ssize_t recvTCP( int fd, void *buf, size_t len, int flags );
+    bool TLSHandshake(void);
+    void TLSKernelOffload(void);
 }; // end class Server
 
 #endif // SERVER_H
@@ -113,7 +113,8 @@ enum ThreadMode {
     kMode_ReporterClient,
     kMode_WriteAckServer,
     kMode_WriteAckClient,
-    kMode_Listener
+    kMode_Listener,
+    kMode_ServerWorker
 };
 
 // report mode
@@ -143,6 +144,63 @@ enum RateUnits {
     kRate_PPS
 };
 
+// TLS handshake type, e.g. for --connect-only handshake rates
+enum TLSHandshakeMode {
+    kTLSHandshake_Full = 0,
+    kTLSHandshake_SessionID,
+    kTLSHandshake_Ticket,
+    kTLSHandshake_EarlyData
+};
+
+// per connection TLS handshake results
+#define TLSHS_RESUMED    0x1
+#define TLSHS_EARLYDATA  0x2
+#define TLSHS_KTLS_TX    0x4
+#define TLSHS_KTLS_RX    0x8
+#define TLSMAXEARLYDATA  16384
+// --tls-handshake, the bound on the client's read up to the server's
+// close_notify (and its session tickets) at shutdown
+#define TLSSHUTDOWNUSEC  500000
+#define TLSSHUTDOWNBYTES (1 << 20)
+// crypto engine used by --tls-engine=auto
+#define TLS_DEFAULT_ENGINE "qatengine"
+// --udp-batch and --udp-gso limits, UIO_MAXIOV and UDP_MAX_SEGMENTS
+#define UDPBATCHMAX       1024
+#define UDPGSOMAXPAYLOAD  65507
+#define UDPGSOMAXSEGS     64
+// --zerocopy buffer pool slots (a power of two) and completion wait
+#define ZCPOOLMIN         32
+#define ZCPOOLMAX         1024
+#define ZCWAITMS          10
+#define ZCWAITTRIES       100
+// --io-uring operations in flight per traffic thread and the completion
+// wait bound, much like the socket timeouts of the send()/recv() loops
+#define IOURINGDEPTHMAX   4096
+#define IOURINGWAITUSEC   100000
+// --txtime launch window limit, the ring of requested launch times (a power
+// of two) used to match the tx timestamps and the end of test drain bound
+#define TXTIMELEADMAX     1000000
+#define TXTIMERING        4096
+#define TXTIMEDRAINMS     100
+// --busy-poll spin budget limit per read, usecs
+#define BUSYPOLLMAX       1000000
+// --af-xdp, the wait for the peer's neighbor entry (the first datagram
+// goes out on the socket and resolves it)
+#define XDPNEIGHWAITMS    1000
+// --reporter-threads, packet ring drain workers
+#define REPORTERTHREADSMAX 64
+// --worker-pool threads and the epoll tick used for the per flow
+// interval and end of test checks of idle sockets
+#define WORKERPOOLMAX     1024
+#define WORKERTICKMSEC    100
+// reads per socket per epoll event, keeps one busy flow from starving
+// the others on the same worker
+#define WORKERREADBUDGET  16
+// --worker-pool with --io-uring, registered socket slots per worker
+#define WORKERURINGFILES  1024
+// --listen-shards, SO_REUSEPORT listeners per port
+#define LISTENSHARDSMAX   1024
+
 #include "Reporter.h"
 #include "payloads.h"
 
@@ -222,6 +280,7 @@ struct thread_Settings {
     int flags;
     int flags_extend;
     int flags_extend2;
+    int flags_extend3;
     // enums (which should be special int's)
     enum ThreadMode mThreadMode;         // -s or -c
     enum ReportMode mReportMode;
@@ -282,6 +341,7 @@ struct thread_Settings {
     int32_t peer_version_u;
     int32_t peer_version_l;
     double connecttime;
+    double tlshandshaketime;
     double rtt_nearcongest_weight_factor;
     char mPermitKey[MAX_PERMITKEY_LEN + 1]; //add some space for timestamp
     struct timeval mPermitKeyTime;
@@ -297,6 +357,30 @@ struct thread_Settings {
     int mWritePrefetch;
 #endif
     SSL_CTX *ssl_ctx;
+    int mTLSPipelines;
+    int mTLSRecordSize;             // --tls-coalesce
+    intmax_t mTLSRekeyBytes;        // --tls-rekey=<bytes>
+    double mTLSRekeyTime;           // --tls-rekey=<secs>s
+    int mUDPBatch;                  // --udp-batch
+    int mIOUringDepth;              // --io-uring
+    int mTxTimeLead;                // --txtime, launch window in usecs
+    int mBusyPoll;                  // --busy-poll, spin budget in usecs
+    int mXdpQueue;                  // --af-xdp, the interface queue
+    int mReporterThreads;           // --reporter-threads
+    int mWorkers;                   // --worker-pool
+    void *mWorker;                  // --worker-pool, the worker's epoll context
+    int mListenShards;              // --listen-shards
+    int mListenShard;               // this listener's shard index
+    struct BarrierMutex *mListenShardGate; // binds the shards in index order
+    enum TLSHandshakeMode mTLSHandshakeMode;
+    int tlshandshakeflags;
+    char*  mTLSCipherList;          // --tls-ciphers
+    char*  mTLSCipherSuites;        // --tls-ciphersuites
+    char*  mTLSGroups;              // --tls-groups
+    char*  mTLSCertFile;            // --tls-cert
+    char*  mTLSKeyFile;             // --tls-key
+    char*  mTLSCipherSweep;         // --tls-cipher-sweep
+    char*  mTLSEngine;              // --tls-engine
 };
 
 /*
@@ -392,6 +476,30 @@ struct thread_Settings {
 #define FLAG_SSL12          0x00001000
 #define FLAG_SSL13          0x00002000
 #define FLAG_KTLS           0x00004000
+#define FLAG_TLSASYNC       0x00008000
+#define FLAG_TLSENGINEAB    0x00010000
+#define FLAG_CPUSTATS       0x00020000
+#define FLAG_CPUCYCLES      0x00040000
+#define FLAG_TLSCOALESCE    0x00080000
+#define FLAG_TLSREKEY       0x00100000
+#define FLAG_UDPBATCH       0x00200000
+#define FLAG_UDPGSO         0x00400000
+#define FLAG_UDPGRO         0x00800000
+#define FLAG_ZEROCOPY       0x01000000
+#define FLAG_IOURING        0x02000000
+#define FLAG_WORKERPOOL     0x04000000
+#define FLAG_LISTENSHARDS   0x08000000
+#define FLAG_SENDFILE       0x10000000
+#define FLAG_NULLSINK       0x20000000
+#define FLAG_TXTIME         0x40000000
+#define FLAG_BUSYPOLL       0x80000000
+
+/*
+ * Third set of extended flags
+ */
+#define FLAG_AFXDP          0x00000001
+#define FLAG_REPORTERTHREADS 0x00000002
+#define FLAG_REPORTERSTATS  0x00000004
 
 #define isBuflenSet(settings)      ((settings->flags & FLAG_BUFLENSET) != 0)
 #define isCompat(settings)         ((settings->flags & FLAG_COMPAT) != 0)
@@ -468,6 +576,26 @@ struct thread_Settings {
 #define isSSL12(settings)    	   ((settings->flags_extend2 & FLAG_SSL12) != 0)
 #define isSSL13(settings)    	   ((settings->flags_extend2 & FLAG_SSL13) != 0)
 #define isKTLS(settings)    	   ((settings->flags_extend2 & FLAG_KTLS) != 0)
+#define isTLSAsync(settings)       ((settings->flags_extend2 & FLAG_TLSASYNC) != 0)
+#define isTLSEngineAB(settings)    ((settings->flags_extend2 & FLAG_TLSENGINEAB) != 0)
+#define isCPUStats(settings)       ((settings->flags_extend2 & FLAG_CPUSTATS) != 0)
+#define isCPUCycles(settings)      ((settings->flags_extend2 & FLAG_CPUCYCLES) != 0)
+#define isTLSCoalesce(settings)    ((settings->flags_extend2 & FLAG_TLSCOALESCE) != 0)
+#define isTLSRekey(settings)       ((settings->flags_extend2 & FLAG_TLSREKEY) != 0)
+#define isUDPBatch(settings)       ((settings->flags_extend2 & FLAG_UDPBATCH) != 0)
+#define isUDPGSO(settings)         ((settings->flags_extend2 & FLAG_UDPGSO) != 0)
+#define isUDPGRO(settings)         ((settings->flags_extend2 & FLAG_UDPGRO) != 0)
+#define isZeroCopy(settings)       ((settings->flags_extend2 & FLAG_ZEROCOPY) != 0)
+#define isIOUring(settings)        ((settings->flags_extend2 & FLAG_IOURING) != 0)
+#define isWorkerPool(settings)     ((settings->flags_extend2 & FLAG_WORKERPOOL) != 0)
+#define isListenShards(settings)   ((settings->flags_extend2 & FLAG_LISTENSHARDS) != 0)
+#define isSendfile(settings)       ((settings->flags_extend2 & FLAG_SENDFILE) != 0)
+#define isNullSink(settings)       ((settings->flags_extend2 & FLAG_NULLSINK) != 0)
+#define isTxTime(settings)         ((settings->flags_extend2 & FLAG_TXTIME) != 0)
+#define isBusyPoll(settings)       ((settings->flags_extend2 & FLAG_BUSYPOLL) != 0)
+#define isAFXDP(settings)          ((settings->flags_extend3 & FLAG_AFXDP) != 0)
+#define isReporterThreads(settings) ((settings->flags_extend3 & FLAG_REPORTERTHREADS) != 0)
+#define isReporterStats(settings)  ((settings->flags_extend3 & FLAG_REPORTERSTATS) != 0)
 
 #define setBuflenSet(settings)     settings->flags |= FLAG_BUFLENSET
 #define setCompat(settings)        settings->flags |= FLAG_COMPAT
@@ -540,6 +668,26 @@ struct thread_Settings {
 #define setSSL12(settings)         settings->flags_extend2 |= FLAG_SSL12
 #define setSSL13(settings)         settings->flags_extend2 |= FLAG_SSL13
 #define setKTLS(settings)          settings->flags_extend2 |= FLAG_KTLS
+#define setTLSAsync(settings)      settings->flags_extend2 |= FLAG_TLSASYNC
+#define setTLSEngineAB(settings)   settings->flags_extend2 |= FLAG_TLSENGINEAB
+#define setCPUStats(settings)      settings->flags_extend2 |= FLAG_CPUSTATS
+#define setCPUCycles(settings)     settings->flags_extend2 |= FLAG_CPUCYCLES
+#define setTLSCoalesce(settings)   settings->flags_extend2 |= FLAG_TLSCOALESCE
+#define setTLSRekey(settings)      settings->flags_extend2 |= FLAG_TLSREKEY
+#define setUDPBatch(settings)      settings->flags_extend2 |= FLAG_UDPBATCH
+#define setUDPGSO(settings)        settings->flags_extend2 |= FLAG_UDPGSO
+#define setUDPGRO(settings)        settings->flags_extend2 |= FLAG_UDPGRO
+#define setZeroCopy(settings)      settings->flags_extend2 |= FLAG_ZEROCOPY
+#define setIOUring(settings)       settings->flags_extend2 |= FLAG_IOURING
+#define setWorkerPool(settings)    settings->flags_extend2 |= FLAG_WORKERPOOL
+#define setListenShards(settings)  settings->flags_extend2 |= FLAG_LISTENSHARDS
+#define setSendfile(settings)      settings->flags_extend2 |= FLAG_SENDFILE
+#define setNullSink(settings)      settings->flags_extend2 |= FLAG_NULLSINK
+#define setTxTime(settings)        settings->flags_extend2 |= FLAG_TXTIME
+#define setBusyPoll(settings)      settings->flags_extend2 |= FLAG_BUSYPOLL
+#define setAFXDP(settings)         settings->flags_extend3 |= FLAG_AFXDP
+#define setReporterThreads(settings) settings->flags_extend3 |= FLAG_REPORTERTHREADS
+#define setReporterStats(settings)   settings->flags_extend3 |= FLAG_REPORTERSTATS
 
 #define unsetBuflenSet(settings)   settings->flags &= ~FLAG_BUFLENSET
 #define unsetCompat(settings)      settings->flags &= ~FLAG_COMPAT
@@ -608,6 +756,27 @@ struct thread_Settings {
 #define unsetBounceBack(settings)    settings->flags_extend2 &= ~FLAG_BOUNCEBACK
 #define unsetTcpDrain(settings)      settings->flags_extend2 &= ~FLAG_TCPDRAIN
 #define unsetOverrideTOS(settings)   settings->flags_extend2 &= ~FLAG_OVERRIDETOS
+#define unsetKTLS(settings)          settings->flags_extend2 &= ~FLAG_KTLS
+#define unsetTLSAsync(settings)      settings->flags_extend2 &= ~FLAG_TLSASYNC
+#define unsetTLSEngineAB(settings)   settings->flags_extend2 &= ~FLAG_TLSENGINEAB
+#define unsetCPUStats(settings)      settings->flags_extend2 &= ~FLAG_CPUSTATS
+#define unsetCPUCycles(settings)     settings->flags_extend2 &= ~FLAG_CPUCYCLES
+#define unsetTLSCoalesce(settings)   settings->flags_extend2 &= ~FLAG_TLSCOALESCE
+#define unsetTLSRekey(settings)      settings->flags_extend2 &= ~FLAG_TLSREKEY
+#define unsetUDPBatch(settings)      settings->flags_extend2 &= ~FLAG_UDPBATCH
+#define unsetUDPGSO(settings)        settings->flags_extend2 &= ~FLAG_UDPGSO
+#define unsetUDPGRO(settings)        settings->flags_extend2 &= ~FLAG_UDPGRO
+#define unsetZeroCopy(settings)      settings->flags_extend2 &= ~FLAG_ZEROCOPY
+#define unsetIOUring(settings)       settings->flags_extend2 &= ~FLAG_IOURING
+#define unsetWorkerPool(settings)    settings->flags_extend2 &= ~FLAG_WORKERPOOL
+#define unsetListenShards(settings)  settings->flags_extend2 &= ~FLAG_LISTENSHARDS
+#define unsetSendfile(settings)      settings->flags_extend2 &= ~FLAG_SENDFILE
+#define unsetNullSink(settings)      settings->flags_extend2 &= ~FLAG_NULLSINK
+#define unsetTxTime(settings)        settings->flags_extend2 &= ~FLAG_TXTIME
+#define unsetBusyPoll(settings)      settings->flags_extend2 &= ~FLAG_BUSYPOLL
+#define unsetAFXDP(settings)         settings->flags_extend3 &= ~FLAG_AFXDP
+#define unsetReporterThreads(settings) settings->flags_extend3 &= ~FLAG_REPORTERTHREADS
+#define unsetReporterStats(settings)   settings->flags_extend3 &= ~FLAG_REPORTERSTATS
 
 // set to defaults
 void Settings_Initialize(struct thread_Settings* main);
@@ -641,6 +810,9 @@ int Settings_GenerateClientHdr(struct thread_Settings *client, void * hdr, struc
 
 int Settings_ClientTestHdrLen(uint32_t flags, struct thread_Settings *inSettings);
 
+// create the shared TLS context, returns true if a crypto engine is in use
+bool Settings_SetupTLS(struct thread_Settings *mSettings);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
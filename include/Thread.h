@@ -115,6 +115,11 @@ void thread_start_all(struct thread_Settings* thread);
 void thread_start(struct thread_Settings* thread);
 void thread_stop(struct thread_Settings* thread);
 
+// account for a traffic stream run by a --worker-pool worker rather
+// than its own thread, i.e. the counting of thread_start and run_wrapper
+void thread_pooled_start(struct thread_Settings* thread);
+void thread_pooled_stop(struct thread_Settings* thread);
+
 /* wait for this or all threads to complete */
 void thread_joinall(void);
 int thread_numuserthreads(void);
@@ -162,6 +167,11 @@ void client_spawn(struct thread_Settings* thread);
 void client_init(struct thread_Settings* clients);
 void listener_spawn(struct thread_Settings* thread);
 void listeners_init(struct thread_Settings* listeners);
+void listener_shards_init(struct thread_Settings* listeners);
+void server_workers_init(struct thread_Settings* listeners);
+void server_worker_spawn(struct thread_Settings* thread);
+bool server_worker_dispatch(struct thread_Settings* server);
+void server_workers_stop(void);
 void writeack_server_spawn(struct thread_Settings* thread);
 void writeack_client_spawn(struct thread_Settings* thread);
 int fullduplex_start_barrier(struct BarrierMutex *barrier);
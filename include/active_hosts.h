@@ -68,6 +68,8 @@ struct Iperf_ListEntry {
     iperf_sockaddr host;
     struct SumReport *sum_report;
     int thread_count;
+    int joined_count;               // agents ever pushed
+    int unused_count;               // of those, removed without a report
 #if WIN32
     SOCKET socket;
 #else
@@ -92,4 +94,5 @@ void Iperf_destroy_active_table (void);
 int Iperf_push_host (struct thread_Settings *agent);
 int Iperf_push_host_port_conditional (struct thread_Settings *agent);
 void Iperf_remove_host (struct thread_Settings *agent);
+void Iperf_remove_unused_host (struct thread_Settings *agent);
 #endif
@@ -229,6 +229,61 @@ SPECIAL_OSF1_EXTERN_C_STOP
 #ifdef HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+// UDP GSO and GRO socket options, linux/udp.h has them with AF_PACKET
+#if defined(__linux__) && !defined(UDP_SEGMENT)
+#include <netinet/udp.h>
+#endif
+// MSG_ZEROCOPY transmit, the completions are on the socket error queue
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#include <poll.h>
+#define HAVE_MSG_ZEROCOPY 1
+#endif
+// --io-uring, multishot receive (and its provided buffer ring), linux 6.0
+#if defined(__linux__) && defined(HAVE_LINUX_IO_URING_H)
+#include <linux/io_uring.h>
+#if defined(IORING_RECV_MULTISHOT)
+#define HAVE_IO_URING 1
+#endif
+#endif
+// --worker-pool, epoll driven server workers
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define HAVE_WORKER_POOL 1
+#endif
+// reporter thread sleeps, woken by the traffic threads
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <poll.h>
+#define HAVE_REPORTER_WAKEUP 1
+#endif
+// --listen-shards, SO_REUSEPORT listeners
+#if defined(__linux__) && defined(SO_REUSEPORT)
+#define HAVE_LISTEN_SHARDS 1
+#endif
+// --sendfile and --null-sink
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#define HAVE_SENDFILE_SPLICE 1
+#endif
+// --txtime, SO_TXTIME launch times checked against the SO_TIMESTAMPING tx stamps
+#if defined(__linux__) && defined(SO_TXTIME) && defined(SO_TIMESTAMPING)
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#define HAVE_SO_TXTIME 1
+#endif
+// --busy-poll
+#if defined(__linux__) && defined(SO_BUSY_POLL)
+#define HAVE_BUSY_POLL 1
+#endif
+// --af-xdp, the framing uses the AF_PACKET headers and checksums
+#if defined(__linux__) && defined(HAVE_LINUX_IF_XDP_H) && defined(HAVE_LINUX_FILTER_H) && defined(HAVE_AF_PACKET)
+#include <linux/if_xdp.h>
+#if defined(AF_XDP) && defined(XDP_USE_NEED_WAKEUP)
+#define HAVE_AF_XDP 1
+#endif
+#endif
 SPECIAL_OSF1_EXTERN_C_START
     #include <arpa/inet.h>   /* netinet/in.h must be before this on SunOS */
 SPECIAL_OSF1_EXTERN_C_STOP
@@ -238,6 +293,8 @@ SPECIAL_OSF1_EXTERN_C_STOP
 
 #ifdef HAVE_POSIX_THREAD
 #include <pthread.h>
+// --reporter-threads, packet ring drain workers
+#define HAVE_REPORTER_SHARDS 1
 #endif // HAVE_POSIX_THREAD
 
 #ifndef INET6_ADDRSTRLEN
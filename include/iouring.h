@@ -0,0 +1,104 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2026
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * iouring.h
+ * Minimal io_uring support for the traffic threads, i.e. the ring
+ * setup, the registrations and a provided buffer ring, done with the
+ * raw system calls so liburing isn't required
+ * -------------------------------------------------------------------
+ */
+#ifndef IOURING_H
+#define IOURING_H
+
+#if HAVE_IO_URING
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct iouring {
+    int fd;
+    unsigned sq_entries;
+    unsigned cq_entries;
+    bool ext_arg;
+    // submission queue, shared with the kernel
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned sq_local_tail;
+    struct io_uring_sqe *sqes;
+    // completion queue, shared with the kernel
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    // provided buffers for multishot receives, one group per ring
+    struct io_uring_buf_ring *br;
+    size_t br_size;
+    char *br_base;
+    unsigned br_entries;
+    unsigned br_bufsize;
+    unsigned short br_tail;
+};
+
+struct iouring *iouring_init(unsigned entries);
+void iouring_free(struct iouring *ring);
+struct io_uring_sqe *iouring_get_sqe(struct iouring *ring);
+int iouring_submit(struct iouring *ring, unsigned wait_nr, long timeout_usec);
+struct io_uring_cqe *iouring_peek_cqe(struct iouring *ring);
+void iouring_cqe_seen(struct iouring *ring);
+int iouring_register_files(struct iouring *ring, int *fds, unsigned count);
+int iouring_register_buffers(struct iouring *ring, struct iovec *iovs, unsigned count);
+int iouring_update_file(struct iouring *ring, unsigned slot, int fd);
+bool iouring_probe_op(struct iouring *ring, int op);
+bool iouring_probe_recv_multishot(struct iouring *ring);
+int iouring_buf_ring_init(struct iouring *ring, unsigned short bgid, char *base, unsigned count, unsigned bufsize);
+void iouring_buf_ring_recycle(struct iouring *ring, unsigned short bid);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+#endif // HAVE_IO_URING
+#endif // IOURING_H
@@ -63,6 +63,32 @@ struct reportstruct_tcpstats {
     intmax_t retry_tot;
 };
 
+// Traffic thread cpu usage, sampled by the traffic thread at
+// interval boundaries (see --cpu-stats)
+struct reportstruct_cpustats {
+    bool isValid;
+    intmax_t cputime; // thread cpu clock, units nanoseconds
+    intmax_t utime; // getrusage user time, units microseconds
+    intmax_t stime; // getrusage system time, units microseconds
+    intmax_t cycles; // perf cpu cycles
+};
+
+// --busy-poll, running totals of the reads served by the spin on
+// non-blocking reads vs those which fell back to a blocking read
+struct reportstruct_busypoll {
+    intmax_t spin_ns;
+    intmax_t sleep_ns;
+    intmax_t spun;
+    intmax_t slept;
+};
+
+// The traffic threads' per packet (or per write/read) record. The
+// fields up to the sampled stats are the hot ones which every flow
+// uses and which the packet ring carries in its compact record. The
+// rest are only set by the less common modes (isochronous, bursts,
+// l2 checks, tls, zerocopy, txtime, busy-poll, ...) and stay zero
+// otherwise, a packet with any of them set goes through the ring
+// as a full side record.
 struct ReportStruct {
     intmax_t packetID;
     intmax_t packetLen;
@@ -73,6 +99,12 @@ struct ReportStruct {
     int errwrite;
     int emptyreport;
     int l2errors;
+    int transit_ready;
+    int writecnt;
+    // sampled at intervals, only valid per isValid
+    struct reportstruct_tcpstats tcpstats;
+    struct reportstruct_cpustats cpustats;
+    // cold fields, l2len must stay the first one
     int l2len;
     int expected_l2len;
     struct timeval isochStartTime;
@@ -81,22 +113,86 @@ struct ReportStruct {
     intmax_t burstsize;
     intmax_t burstperiod;
     intmax_t remaining;
-    int transit_ready;
-    int writecnt;
-    struct reportstruct_tcpstats tcpstats;
+    int tlsrecords;
+    int tlsrekeys;
+    double tlsrekey_stall;
+    int zc_zerocopy;
+    int zc_copied;
+    int txt_stamps;
+    int txt_missed;
+    double txt_dev;
+    double txt_devmax;
+    struct reportstruct_busypoll busypoll;
     double select_delay;
     long drain_time;
 };
 
+// The compact per packet ring record, one cache line, the times
+// are in nanoseconds
+#define REPORTRECORD_EMPTY       0x1
+#define REPORTRECORD_TRANSIT     0x2
+#define REPORTRECORD_FULL        0x4
+
+struct ReportRecord {
+    intmax_t packetID;
+    intmax_t packetLen;
+    int64_t packetTime;
+    int64_t prevPacketTime;
+    int64_t sentTime;
+    int64_t prevSentTime;
+    int errwrite;
+    int writecnt;
+    int l2errors;
+    int flags;
+};
+
+// Handoffs between threads, acquire loads of the other side's index
+// (or state) and release stores of one's own. The seq_cst pair orders
+// the ring producer's await flag against the consumer's release so a
+// blocked producer can't miss its wakeup
+#if defined(__ATOMIC_ACQUIRE)
+#define PR_LOAD_ACQUIRE(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define PR_STORE_RELEASE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define PR_LOAD_SEQCST(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define PR_STORE_SEQCST(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#else
+#define PR_LOAD_ACQUIRE(x) (x)
+#define PR_STORE_RELEASE(x, v) ((x) = (v))
+#define PR_LOAD_SEQCST(x) PR_LOAD_ACQUIRE(x)
+#define PR_STORE_SEQCST(x, v) PR_STORE_RELEASE(x, v)
+#endif
+
+// Single producer (traffic thread), single consumer (reporter thread)
+// ring. The indices are free running and masked by the power of two
+// size, each side publishes its own index with release semantics and
+// keeps a cached copy of the other side's index so the shared cache
+// line is only read when the cached one says full (or empty). The
+// producer and consumer fields are kept on separate cache lines.
+#define PACKETRING_CACHELINE 64
+#define PACKETRING_BATCH 64
+#define PACKETRING_RESTS 8
+
 struct PacketRing {
-    // producer and consumer
-    // must be an atomic type, e.g. int
-    // otherwise reads/write can be torn
-    int producer;
-    int consumer;
-    int maxcount;
-    int consumerdone;
+    // producer side, written by the traffic thread
+    unsigned int producer;
+    unsigned int consumer_cache;
     int awaitcounter;
+    char pad0[PACKETRING_CACHELINE - (3 * sizeof(int))];
+    // consumer side, written by the reporter thread,
+    // consumer is published lazily, i.e. the slots handed
+    // out by the last dequeue stay owned by the consumer
+    // until its next dequeue call
+    unsigned int consumer;
+    unsigned int consumer_next;
+    unsigned int producer_cache;
+    int consumerdone;
+    // set by a producer blocked on a full ring, kept
+    // here as it's rarely written and read per release
+    int producerwaiting;
+    char pad1[PACKETRING_CACHELINE - (5 * sizeof(int))];
+    // read only after init
+    unsigned int mask;
+    int maxcount;
     int mutex_enable;
     int bytes;
 
@@ -107,19 +203,25 @@ struct PacketRing {
     //    (signaled by the producer)
     struct Condition *awake_producer;
     struct Condition *awake_consumer;
-    struct ReportStruct *data;
+    struct ReportRecord *data;
+    // side records, indexed the same as data, only written (and
+    // hence only faulted in) for packets which need the full struct
+    struct ReportStruct *full;
+    // consumer owned, the hot records of the last dequeue
+    // expanded back into report structs
+    struct ReportStruct *expand;
 };
 
 extern struct PacketRing * packetring_init(int count, struct Condition *awake_consumer, struct Condition *awake_producer);
 extern void packetring_enqueue(struct PacketRing *pr, struct ReportStruct *metapacket);
 extern struct ReportStruct *packetring_dequeue(struct PacketRing * pr);
+extern int packetring_dequeue_n(struct PacketRing *pr, struct ReportStruct **packets, int max);
+extern void packetring_unget(struct PacketRing *pr, int count);
 extern void enqueue_ackring(struct PacketRing *pr, struct ReportStruct *metapacket);
 extern struct ReportStruct *dequeue_ackring(struct PacketRing * pr);
 extern void packetring_free(struct PacketRing *pr);
 extern void free_ackring(struct PacketRing *pr);
-#ifdef HAVE_THREAD_DEBUG
 extern int packetring_getcount(struct PacketRing *pr);
-#endif
 
 #ifdef __cplusplus
 } /* end extern "C" */
@@ -84,6 +84,9 @@ int  setsock_tcp_notsent_low_watermark(int inSock, int clampsize);
 
 int recvn(int inSock, void *, char *outBuf, int inLen, int flags);
 int writen(int inSock, void *, const void *inBuf, int inLen, int *count);
+int tls_async_wait(int inSock, void *conn, int rc);
+int dtls_timer_wait(int inSock, void *conn, int rc);
+void dtls_set_socket(void *conn, int inSock, void *peer, int payloadlen);
 
 void disarm_itimer(void);
 /* -------------------------------------------------------------------
@@ -0,0 +1,117 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2026
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * xdpsock.h
+ * Minimal AF_XDP (XSK) support for the UDP traffic threads, i.e. the
+ * UMEM and its rings, a redirect program for the receive side and
+ * the Ethernet/IPv4/UDP framing, done with the raw system calls so
+ * libbpf and libxdp aren't required
+ * -------------------------------------------------------------------
+ */
+#ifndef XDPSOCK_H
+#define XDPSOCK_H
+
+#if HAVE_AF_XDP
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XDPSOCK_RING       2048 // descriptors per ring, a power of two
+#define XDPSOCK_FRAMES     (2 * XDPSOCK_RING)
+#define XDPSOCK_FRAMESIZE  4096
+#define XDPSOCK_BATCH      64   // frames per kick or per receive batch
+#define XDPSOCK_UDP4HDRLEN 42   // ethernet + ipv4 (no options) + udp
+#define XDPSOCK_DRAINMS    100  // end of test wait for the tx completions
+
+struct xdpsock_ring {
+    uint32_t *producer;
+    uint32_t *consumer;
+    void *desc;
+    uint32_t mask;
+    uint32_t size;
+    // our side of the ring, published with a release store
+    uint32_t local;
+    void *map;
+    size_t map_size;
+};
+
+struct xdpsock {
+    int fd;
+    int ifindex;
+    int queue;
+    char *umem;
+    size_t umem_size;
+    struct xdpsock_ring fill;
+    struct xdpsock_ring comp;
+    struct xdpsock_ring rx;
+    struct xdpsock_ring tx;
+    // transmit frames not in flight
+    uint64_t *free_frames;
+    unsigned free_count;
+    // the receive side redirect program, detached when the link closes
+    int map_fd;
+    int prog_fd;
+    int link_fd;
+    // the transmit flow, a header template per frame
+    unsigned char hdr[XDPSOCK_UDP4HDRLEN];
+};
+
+int xdpsock_ifindex(const struct sockaddr_in *local, char *ifname);
+bool xdpsock_neighbor(const char *ifname, const struct sockaddr_in *peer, unsigned char *mac);
+int xdpsock_mtu(const char *ifname);
+struct xdpsock *xdpsock_init(int ifindex, int queue, bool rx);
+void xdpsock_free(struct xdpsock *xsk);
+int xdpsock_redirect(struct xdpsock *xsk, const struct sockaddr_in *local, const struct sockaddr_in *peer);
+bool xdpsock_udp4_flow(struct xdpsock *xsk, const char *ifname, const struct sockaddr_in *local, const struct sockaddr_in *peer, const unsigned char *dstmac, int ttl, int tos);
+char *xdpsock_udp4_alloc(struct xdpsock *xsk, uint64_t *addr);
+void xdpsock_udp4_queue(struct xdpsock *xsk, uint64_t addr, int len);
+int xdpsock_tx_kick(struct xdpsock *xsk);
+unsigned xdpsock_tx_complete(struct xdpsock *xsk);
+unsigned xdpsock_tx_drain(struct xdpsock *xsk, int timeout_ms);
+unsigned xdpsock_rx_peek(struct xdpsock *xsk, unsigned max);
+char *xdpsock_udp4_rx(struct xdpsock *xsk, unsigned ix, const struct sockaddr_in *peer, int *len);
+void xdpsock_rx_release(struct xdpsock *xsk, unsigned count);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
+#endif // HAVE_AF_XDP
+#endif // XDPSOCK_H
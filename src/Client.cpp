@@ -52,6 +52,7 @@
  * ------------------------------------------------------------------- */
 #include <ctime>
 #include <cmath>
+#include <sys/stat.h>
 #include "headers.h"
 #include "Client.hpp"
 #include "Thread.h"
@@ -66,6 +67,8 @@
 #include "version.h"
 #include "payloads.h"
 #include "active_hosts.h"
+#include "iouring.h"
+#include "xdpsock.h"
 
 // const double kSecs_to_usecs = 1e6;
 const double kSecs_to_nsecs = 1e9;
@@ -113,6 +116,33 @@ Client::Client (thread_Settings *inSettings) {
     peerclose = false;
     isburst = (isIsochronous(mSettings) || isPeriodicBurst(mSettings) || ((isTripTime(mSettings) || isTcpDrain(mSettings)) && !isUDP(mSettings)));
     conn = 0;
+    tls_session = NULL;
+    ktls_tx = false;
+    tls_sendfile = false;
+    sendfile_offset = 0;
+    sendfile_size = 0;
+    file_sendfile = false;
+    file_splice = false;
+    tls_coalesce_buf = NULL;
+    tls_coalesce_size = 0;
+    tls_coalesce_fill = 0;
+    tls_rekey_mark = 0;
+    zc_pool = NULL;
+    zc_busy = NULL;
+    zc_poolsize = 0;
+    zc_sendid = 0;
+    txt_launch = NULL;
+    txt_sendid = 0;
+    txt_reapid = 0;
+    txt_last = 0;
+    txt_offset = 0;
+    txt_stamping = false;
+    xdp = NULL;
+    if (isTLSCoalesce(mSettings)) {
+	// one staged write feeds every pipeline a full record
+	tls_coalesce_size = mSettings->mTLSRecordSize * ((isTLSAsync(mSettings) && (mSettings->mTLSPipelines > 1)) ? mSettings->mTLSPipelines : 1);
+	tls_coalesce_buf = new char[tls_coalesce_size];
+    }
 } // end Client
 
 #include <openssl/ssl.h>
@@ -127,6 +157,11 @@ Client::~Client () {
 		 (isServerReverse(mSettings) ? "true" : "false"), (isFullDuplex(mSettings) ? "true" : "false"));
 #endif
     DELETE_PTR(framecounter);
+    DELETE_ARRAY(tls_coalesce_buf);
+    DELETE_ARRAY(zc_pool);
+    DELETE_ARRAY(zc_busy);
+    if (tls_session)
+	SSL_SESSION_free(tls_session);
 } // end ~Client
 
 
@@ -164,6 +199,8 @@ bool Client::my_connect (bool close_on_fail) {
 
     // connect socket
     connected = false;
+    mSettings->tlshandshaketime = 0;
+    mSettings->tlshandshakeflags = 0;
     if (!isUDP(mSettings)) {
 	int trycnt = mSettings->mConnectRetries + 1;
 	while (trycnt > 0) {
@@ -192,6 +229,7 @@ bool Client::my_connect (bool close_on_fail) {
 	rc = connect(mySocket, reinterpret_cast<sockaddr*>(&mSettings->peer),
 		     SockAddr_get_sizeof_sockaddr(&mSettings->peer));
 	connecttime = 0.0; // UDP doesn't have a 3WHS
+	mSettings->connecttime = connecttime;
         WARN_errno((rc == SOCKET_ERROR), "udp connect");
 	if (rc != SOCKET_ERROR)
 	    connected = true;
@@ -221,6 +259,13 @@ bool Client::my_connect (bool close_on_fail) {
 	setNoSettReport(mSettings);
     }
     // Post the connect report unless peer version exchange is set
+    // TLS connections post it after the handshake (see StartSynch)
+    if (!(connected && isTLSHandshakeDeferred()))
+	PostConnectionReport(connecttime);
+    return connected;
+} // end Connect
+
+void Client::PostConnectionReport (double connecttime) {
     if (isConnectionReport(mSettings) && !isSumOnly(mSettings)) {
 	if (connected) {
 	    struct ReportHeader *reporthdr = InitConnectionReport(mSettings, connecttime);
@@ -233,8 +278,123 @@ bool Client::my_connect (bool close_on_fail) {
 	    PostReport(InitConnectionReport(mSettings, -1));
 	}
     }
-    return connected;
-} // end Connect
+}
+
+// The TLS client role follows the data direction, i.e. the writer
+// is the TLS client and the reader (class Server) the TLS server.
+// Full duplex shares one socket and keeps the lazy handshake.
+// UDP uses DTLS, the test exchange datagram stays in the clear
+inline bool Client::isTLSHandshakeDeferred () {
+    return (isSSL(mSettings) && !isFullDuplex(mSettings) \
+	    && (!isReverse(mSettings) || isServerReverse(mSettings)));
+}
+
+// Perform the TLS handshake as its own phase, i.e. after the
+// test exchange (which is in the clear) and before the traffic
+// start time, so its cost isn't folded into the first interval
+bool Client::TLSHandshake () {
+    Timestamp hs_start;
+    int rc;
+    assert(conn == 0);
+    conn = SSL_new(mSettings->ssl_ctx);
+#ifdef __FreeBSD__
+    SSL_set_options(conn, SSL_OP_ENABLE_KTLS);
+#endif
+    if (isUDP(mSettings))
+	dtls_set_socket(conn, mySocket, &mSettings->peer, mSettings->mBufLen);
+    else
+	SSL_set_fd(conn, mySocket);
+    SSL_set_connect_state(conn);
+    // Resume using the session from the previous connection, if any
+    if (tls_session && (mSettings->mTLSHandshakeMode != kTLSHandshake_Full)) {
+	SSL_set_session(conn, tls_session);
+	if ((mSettings->mTLSHandshakeMode == kTLSHandshake_EarlyData) && (SSL_SESSION_get_max_early_data(tls_session) > 0)) {
+	    size_t written = 0;
+	    size_t earlylen = SSL_SESSION_get_max_early_data(tls_session);
+	    if (earlylen > static_cast<size_t>(mSettings->mBufLen))
+		earlylen = mSettings->mBufLen;
+	    do {
+		rc = SSL_write_early_data(conn, mSettings->mBuf, earlylen, &written);
+	    } while (!rc && tls_async_wait(mySocket, conn, rc));
+	}
+    }
+    do {
+	rc = SSL_do_handshake(conn);
+    } while ((rc <= 0) && (dtls_timer_wait(mySocket, conn, rc) || tls_async_wait(mySocket, conn, rc)));
+    Timestamp hs_done;
+    mSettings->tlshandshakeflags = 0;
+    if (rc == 1) {
+	mSettings->tlshandshaketime = 1e3 * hs_done.subSec(hs_start);
+	if (SSL_session_reused(conn))
+	    mSettings->tlshandshakeflags |= TLSHS_RESUMED;
+	if (SSL_get_early_data_status(conn) == SSL_EARLY_DATA_ACCEPTED)
+	    mSettings->tlshandshakeflags |= TLSHS_EARLYDATA;
+	TLSKernelOffload();
+    } else {
+	ERR_print_errors_fp(stderr);
+	mSettings->tlshandshaketime = -1;
+    }
+    return (rc == 1);
+}
+
+// With --ktls OpenSSL pushes the negotiated keys to the kernel, i.e.
+// setsockopt(SOL_TLS, TLS_TX/TLS_RX), as the handshake completes. Note
+// which directions the kernel took so the writes can bypass SSL_write
+void Client::TLSKernelOffload () {
+    ktls_tx = false;
+#ifdef SSL_OP_ENABLE_KTLS
+    if (!isKTLS(mSettings) || (conn == 0))
+	return;
+    if (BIO_get_ktls_send(SSL_get_wbio(conn))) {
+	ktls_tx = true;
+	mSettings->tlshandshakeflags |= TLSHS_KTLS_TX;
+    }
+    if (BIO_get_ktls_recv(SSL_get_rbio(conn)))
+	mSettings->tlshandshakeflags |= TLSHS_KTLS_RX;
+    if (!ktls_tx && !isConnectOnly(mSettings))
+	fprintf(stderr, "WARN: kTLS transmit offload not enabled (check the tls kernel module and cipher), using OpenSSL records\n");
+    if (ktls_tx && tls_coalesce_buf)
+	fprintf(stderr, "WARN: --tls-coalesce not applied, the kernel frames the kTLS records\n");
+#endif
+}
+
+// Close the TLS session of a --connect-only connection. TLS 1.3 delivers
+// session tickets after the handshake so read until the peer closes
+// before saving the session for the next connection's resumption
+void Client::TLSShutdown () {
+    if (conn) {
+	int rc = SSL_shutdown(conn);
+	if ((rc == 0) && (mSettings->mTLSHandshakeMode != kTLSHandshake_Full)) {
+	    // bounded, a peer that never answers or keeps sending can't
+	    // hold the next handshake
+	    Timestamp deadline;
+	    deadline.add(static_cast<double>(TLSSHUTDOWNUSEC) / 1e6);
+	    SetSocketOptionsReceiveTimeout(mSettings, TLSSHUTDOWNUSEC);
+	    int drained = 0;
+	    int n;
+	    while ((drained < TLSSHUTDOWNBYTES) && \
+		   ((n = SSL_read(conn, mSettings->mBuf, mSettings->mBufLen)) > 0)) {
+		drained += n;
+		Timestamp t;
+		if (deadline.before(t))
+		    break;
+	    }
+	}
+	if (mSettings->mTLSHandshakeMode != kTLSHandshake_Full) {
+	    SSL_SESSION *sess = SSL_get1_session(conn);
+	    if (sess && SSL_SESSION_is_resumable(sess)) {
+		if (tls_session)
+		    SSL_SESSION_free(tls_session);
+		tls_session = sess;
+	    } else if (sess) {
+		SSL_SESSION_free(sess);
+	    }
+	}
+	ERR_clear_error();
+	SSL_free(conn);
+	conn = 0;
+    }
+}
 
 bool Client::isConnected () const {
 #ifdef HAVE_THREAD_DEBUG
@@ -252,6 +412,15 @@ void Client::TxDelay () {
 inline void Client::myReportPacket (void) {
     ReportPacket(myReport, reportstruct);
     reportstruct->packetLen = 0;
+    reportstruct->tlsrecords = 0;
+    reportstruct->tlsrekeys = 0;
+    reportstruct->tlsrekey_stall = 0;
+    reportstruct->zc_zerocopy = 0;
+    reportstruct->zc_copied = 0;
+    reportstruct->txt_stamps = 0;
+    reportstruct->txt_missed = 0;
+    reportstruct->txt_dev = 0;
+    reportstruct->txt_devmax = 0;
 }
 
 
@@ -298,6 +467,10 @@ int Client::StartSynch () {
 		}
 	    }
 	}
+	if (isTLSHandshakeDeferred()) {
+	    TLSHandshake();
+	    PostConnectionReport(mSettings->connecttime);
+	}
 	if (isTxStartTime(mSettings)) {
 	    clock_usleep_abstime(&mSettings->txstart_epoch);
 	} else if (isTxHoldback(mSettings)) {
@@ -307,6 +480,9 @@ int Client::StartSynch () {
     } else if (isTripTime(mSettings) || isPeriodicBurst(mSettings)) {
 	reportstruct->packetLen = SendFirstPayload();
     }
+    if (isServerReverse(mSettings) && isTLSHandshakeDeferred()) {
+	TLSHandshake();
+    }
     if (isIsochronous(mSettings) || isPeriodicBurst(mSettings)) {
         Timestamp tmp;
         tmp.set(mSettings->txstart_epoch.tv_sec, mSettings->txstart_epoch.tv_usec);
@@ -332,6 +508,9 @@ int Client::StartSynch () {
 	}
     }
 #endif
+    if (isCPUStats(mSettings) && !isUDP(mSettings)) {
+	InitCPUStats(myReport);
+    }
 
     if (reportstruct->packetLen > 0) {
 	reportstruct->packetTime = myReport->info.ts.startTime;
@@ -419,6 +598,13 @@ void Client::ConnectPeriodic () {
 
     do {
 	if (my_connect(false)){
+	    if (isTLSHandshakeDeferred()) {
+		// The test exchange tells the listener to expect a TLS handshake
+		SendFirstPayload();
+		TLSHandshake();
+		PostConnectionReport(mSettings->connecttime);
+		TLSShutdown();
+	    }
 	    int rc = close(mySocket);
 	    WARN_errno(rc == SOCKET_ERROR, "client close");
 	    mySocket = INVALID_SOCKET;
@@ -504,6 +690,11 @@ void Client::Run () {
     // Initialize the report struct scratch pad
     // Peform common traffic setup
     InitTrafficLoop();
+#if HAVE_MSG_ZEROCOPY
+    // with --io-uring the zerocopy sends are SEND_ZC operations instead
+    if (isZeroCopy(mSettings) && !isIOUring(mSettings))
+	ZeroCopyInit();
+#endif
     /*
      * UDP
      */
@@ -515,14 +706,44 @@ void Client::Run () {
 	    Extractor_reduceReadSize(sizeof(struct UDP_datagram), mSettings);
 	    readAt += sizeof(struct UDP_datagram);
 	}
+#if HAVE_SO_TXTIME
+	if (isTxTime(mSettings))
+	    TxTimeInit();
+#endif
+#if HAVE_AF_XDP
+	if (isAFXDP(mSettings))
+	    XdpInit();
+#endif
 	// Launch the approprate UDP traffic loop
 	if (isIsochronous(mSettings)) {
 	    RunUDPIsochronous();
+#if HAVE_SO_TXTIME
+	} else if (txt_launch) {
+	    RunUDPTxTime();
+#endif
+#if HAVE_AF_XDP
+	} else if (xdp) {
+	    RunUDPXdp();
+#endif
+#if defined(__linux__)
+	} else if (isUDPBatch(mSettings)) {
+	    RunUDPBatch();
+#endif
 	} else {
 	    RunUDP();
 	}
     } else {
 	// Launch the approprate TCP traffic loop
+#if HAVE_IO_URING
+	if (isIOUring(mSettings)) {
+#if HAVE_DECL_TCP_NOTSENT_LOWAT
+	    if (isWritePrefetch(mSettings))
+		RunWriteEventsTCPUring();
+	    else
+#endif
+		RunTCPUring();
+	} else
+#endif
 	if (mSettings->mAppRate > 0) {
 	    RunRateLimitedTCP();
 	} else if (isNearCongest(mSettings)) {
@@ -542,9 +763,14 @@ ssize_t Client::sendTCP( int fd, const void *buffer, size_t len, int flags )
 {
     ssize_t currLen;
 
-    if (!isSSL(mSettings))
+    if (!isSSL(mSettings)) {
+#if HAVE_MSG_ZEROCOPY
+	if (zc_pool && (buffer == mSettings->mBuf))
+	    currLen = ZeroCopySend(fd, buffer, len, flags, sizeof(struct TCP_burst_payload));
+	else
+#endif
         currLen = send(fd, buffer, len, flags);
-    else {
+    } else {
         if (conn == 0) {
             conn = SSL_new(mSettings->ssl_ctx);
 #ifdef __FreeBSD__
@@ -552,15 +778,695 @@ ssize_t Client::sendTCP( int fd, const void *buffer, size_t len, int flags )
 #endif
             SSL_set_fd(conn, fd);
             SSL_set_connect_state(conn);
-            SSL_do_handshake(conn);
+            int rc;
+            do {
+                rc = SSL_do_handshake(conn);
+            } while ((rc <= 0) && tls_async_wait(fd, conn, rc));
+            if (rc == 1)
+                TLSKernelOffload();
+        }
+        if (ktls_tx) {
+            // kTLS, the kernel frames and encrypts the records
+            currLen = send(fd, buffer, len, flags);
+            if (currLen > 0)
+                reportstruct->tlsrecords += TLSRecordCount(currLen);
+        } else if (tls_coalesce_buf) {
+            currLen = TLSWriteRecords(buffer, len);
+        } else {
+            // With --tls-async the write may pause while the engine has the
+            // records in flight, so wait on the engine (or socket) and resume
+            do {
+                currLen = SSL_write(conn, buffer, len);
+            } while ((currLen <= 0) && tls_async_wait(fd, conn, currLen));
+            if (currLen < 0)
+                ERR_print_errors_fp(stderr);
+            else if (currLen > 0)
+                reportstruct->tlsrecords += TLSRecordCount(currLen);
         }
-        currLen = SSL_write(conn, buffer, len);
-        if (currLen < 0)
-            ERR_print_errors_fp(stderr);
     }
     return currLen;
 }
 
+// UDP writes, with -E each payload is sent as one DTLS record
+inline ssize_t Client::sendUDP (int fd, const void *buffer, size_t len) {
+    ssize_t currLen;
+    if (conn == 0) {
+#if HAVE_MSG_ZEROCOPY
+	if (zc_pool)
+	    currLen = ZeroCopySend(fd, buffer, len, 0, sizeof(struct client_udp_testhdr));
+	else
+#endif
+	currLen = write(fd, buffer, len);
+    } else {
+	do {
+	    currLen = SSL_write(conn, buffer, len);
+	} while ((currLen <= 0) && tls_async_wait(fd, conn, currLen));
+    }
+    return currLen;
+}
+
+#if HAVE_MSG_ZEROCOPY
+// --zerocopy, the kernel pins the user pages of a MSG_ZEROCOPY send until
+// the skb is freed, so mBuf can't be reused for the next write while the
+// previous one may still be in flight. Writes rotate through a pool large
+// enough to cover the socket send buffer, each slot holds a copy of mBuf
+void Client::ZeroCopyInit () {
+    int one = 1;
+    if (setsockopt(mySocket, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) {
+	WARN_errno(1, "setsockopt SO_ZEROCOPY, using copy writes");
+	unsetZeroCopy(mSettings);
+	return;
+    }
+    int sndbuf = 0;
+    Socklen_t optlen = sizeof(sndbuf);
+    if (getsockopt(mySocket, SOL_SOCKET, SO_SNDBUF, &sndbuf, &optlen) < 0)
+	sndbuf = 0;
+    int needed = (sndbuf / mSettings->mBufLen) + 2;
+    zc_poolsize = ZCPOOLMIN;
+    while ((zc_poolsize < needed) && (zc_poolsize < ZCPOOLMAX))
+	zc_poolsize <<= 1;
+    zc_pool = new char[static_cast<size_t>(zc_poolsize) * mSettings->mBufLen];
+    zc_busy = new bool[zc_poolsize];
+    for (int ix = 0; ix < zc_poolsize; ix++) {
+	memcpy(zc_pool + (static_cast<size_t>(ix) * mSettings->mBufLen), mSettings->mBuf, mSettings->mBufLen);
+	zc_busy[ix] = false;
+    }
+    zc_sendid = 0;
+}
+
+// Only the test headers change from write to write, so those are the only
+// bytes copied into the slot, the payload pattern is already there
+ssize_t Client::ZeroCopySend (int fd, const void *buffer, size_t len, int flags, size_t hdrlen) {
+    int slot = static_cast<int>(zc_sendid & (zc_poolsize - 1));
+    if ((len > static_cast<size_t>(mSettings->mBufLen)) || (zc_busy[slot] && !ZeroCopyAwait(slot)))
+	return send(fd, buffer, len, flags);
+    char *zcbuf = zc_pool + (static_cast<size_t>(slot) * mSettings->mBufLen);
+    memcpy(zcbuf, buffer, ((hdrlen < len) ? hdrlen : len));
+    ssize_t currLen = send(fd, zcbuf, len, flags | MSG_ZEROCOPY);
+    if (currLen >= 0) {
+	// the kernel numbers every successful zerocopy send, even a partial one
+	zc_busy[slot] = true;
+	zc_sendid++;
+	// take what completed so far, the counts then land in the interval of
+	// the send rather than when the pool wraps, and the slots free early
+	ZeroCopyReap(0);
+    } else if (errno == ENOBUFS) {
+	// out of optmem for the page pinning, copy this one
+	int saverr = errno;
+	ZeroCopyReap(0);
+	errno = saverr;
+	currLen = send(fd, buffer, len, flags);
+    }
+    return currLen;
+}
+
+// Read the completion notifications off the socket error queue. Each one
+// covers a range of send ids and says whether the kernel had to fall back
+// to copying, e.g. loopback or a device without scatter-gather
+int Client::ZeroCopyReap (int timeout_ms) {
+    if (timeout_ms > 0) {
+	// POLLERR is always reported, no events need to be requested
+	struct pollfd pfd;
+	pfd.fd = mySocket;
+	pfd.events = 0;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, timeout_ms) <= 0)
+	    return 0;
+    }
+    int reaped = 0;
+    while (1) {
+	char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	if (recvmsg(mySocket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+	    break;
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+	    if (!(((cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR)) || \
+		  ((cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR))))
+		continue;
+	    struct sock_extended_err *serr = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cmsg));
+	    if ((serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) || (serr->ee_errno != 0))
+		continue;
+	    uint32_t count = serr->ee_data - serr->ee_info + 1;
+	    for (uint32_t id = serr->ee_info; id != (serr->ee_data + 1); id++)
+		zc_busy[id & (zc_poolsize - 1)] = false;
+	    if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+		reportstruct->zc_copied += count;
+	    else
+		reportstruct->zc_zerocopy += count;
+	    reaped += count;
+	}
+    }
+    return reaped;
+}
+
+// The slot is still pinned, completions arrive in send order so
+// wait for the kernel to release it
+bool Client::ZeroCopyAwait (int slot) {
+    ZeroCopyReap(0);
+    for (int tries = 0; zc_busy[slot] && (tries < ZCWAITTRIES); tries++) {
+	ZeroCopyReap(ZCWAITMS);
+    }
+    return !zc_busy[slot];
+}
+
+void Client::ZeroCopyDrain () {
+    for (int ix = 0; ix < zc_poolsize; ix++) {
+	if (zc_busy[ix] && !ZeroCopyAwait(ix)) {
+	    fprintf(stderr, "WARN: zerocopy completions still outstanding at the end of traffic\n");
+	    break;
+	}
+    }
+}
+
+void Client::ZeroCopyFree () {
+    DELETE_ARRAY(zc_pool);
+    DELETE_ARRAY(zc_busy);
+    zc_poolsize = 0;
+}
+#endif
+
+#if HAVE_SO_TXTIME
+// --txtime, the launch times are CLOCK_MONOTONIC per the fq qdisc while
+// the software tx stamps are CLOCK_REALTIME, sample the offset once
+bool Client::TxTimeInit () {
+    struct sock_txtime txt;
+    txt.clockid = CLOCK_MONOTONIC;
+    txt.flags = SOF_TXTIME_REPORT_ERRORS;
+    if (setsockopt(mySocket, SOL_SOCKET, SO_TXTIME, &txt, sizeof(txt)) < 0) {
+	WARN_errno(1, "setsockopt SO_TXTIME, using delay loop pacing");
+	unsetTxTime(mSettings);
+	return false;
+    }
+    int tsflags = SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE | \
+	SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    if (setsockopt(mySocket, SOL_SOCKET, SO_TIMESTAMPING, &tsflags, sizeof(tsflags)) < 0) {
+	WARN_errno(1, "setsockopt SO_TIMESTAMPING, no txtime deviation");
+    } else {
+	txt_stamping = true;
+    }
+    struct timespec rt1, mono, rt2;
+    clock_gettime(CLOCK_REALTIME, &rt1);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &rt2);
+    int64_t rt = ((static_cast<int64_t>(rt1.tv_sec) + rt2.tv_sec) * 1000000000LL + rt1.tv_nsec + rt2.tv_nsec) / 2;
+    txt_offset = rt - (static_cast<int64_t>(mono.tv_sec) * 1000000000LL + mono.tv_nsec);
+    txt_launch = new uint64_t[TXTIMERING];
+    txt_sendid = 0;
+    txt_reapid = 0;
+    return true;
+}
+
+inline uint64_t Client::TxTimeNow () {
+    struct timespec mono;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    return (static_cast<uint64_t>(mono.tv_sec) * 1000000000ULL + mono.tv_nsec);
+}
+
+// The one wakeup per window refill, the stamps of the datagrams that went
+// out meanwhile are waiting on the error queue
+void Client::TxTimeWait (uint64_t until) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(until / 1000000000ULL);
+    ts.tv_nsec = static_cast<long>(until % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+	if (sInterupted)
+	    break;
+    }
+    if (txt_stamping)
+	TxTimeReap(0);
+}
+
+ssize_t Client::TxTimeSend (int fd, const void *buffer, size_t len, uint64_t launch) {
+    union {
+	char buf[CMSG_SPACE(sizeof(uint64_t))];
+	struct cmsghdr align;
+    } control;
+    struct iovec iov;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = const_cast<void *>(buffer);
+    iov.iov_len = len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+    memcpy(CMSG_DATA(cmsg), &launch, sizeof(uint64_t));
+    ssize_t currLen = sendmsg(fd, &msg, 0);
+    if (currLen >= 0) {
+	// the kernel numbers the timestamped sends, the OPT_ID
+	txt_launch[txt_sendid & (TXTIMERING - 1)] = launch;
+	txt_sendid++;
+	txt_last = launch;
+    }
+    return currLen;
+}
+
+// Match the tx stamps, taken as the datagram is handed to the device so
+// after the qdisc released it, to the requested launch times. The stamp
+// ids older than the ring (a window longer than TXTIMERING datagrams)
+// are only counted. A qdisc which drops a late datagram, e.g. etf,
+// reports it as SO_EE_ORIGIN_TXTIME
+int Client::TxTimeReap (int timeout_ms) {
+    if (timeout_ms > 0) {
+	struct pollfd pfd;
+	pfd.fd = mySocket;
+	pfd.events = 0;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, timeout_ms) <= 0)
+	    return 0;
+    }
+    int reaped = 0;
+    while (1) {
+	char control[CMSG_SPACE(sizeof(struct scm_timestamping)) + \
+		     CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	if (recvmsg(mySocket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+	    break;
+	struct scm_timestamping *stamp = NULL;
+	struct sock_extended_err *serr = NULL;
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+	    if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMPING))
+		stamp = reinterpret_cast<struct scm_timestamping *>(CMSG_DATA(cmsg));
+	    else if (((cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR)) || \
+		     ((cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR)))
+		serr = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cmsg));
+	}
+	if (!serr)
+	    continue;
+#ifdef SO_EE_ORIGIN_TXTIME
+	if (serr->ee_origin == SO_EE_ORIGIN_TXTIME) {
+	    reportstruct->txt_missed++;
+	    txt_reapid++;
+	    reaped++;
+	    continue;
+	}
+#endif
+	if ((serr->ee_origin != SO_EE_ORIGIN_TIMESTAMPING) || !stamp)
+	    continue;
+	uint32_t id = serr->ee_data;
+	txt_reapid++;
+	reaped++;
+	if ((txt_sendid - id) > TXTIMERING)
+	    continue;
+	int64_t actual = (static_cast<int64_t>(stamp->ts[0].tv_sec) * 1000000000LL + stamp->ts[0].tv_nsec) - txt_offset;
+	double dev = (actual - static_cast<int64_t>(txt_launch[id & (TXTIMERING - 1)])) / 1e6;
+	reportstruct->txt_stamps++;
+	reportstruct->txt_dev += dev;
+	if (dev < 0)
+	    dev = -dev;
+	if (reportstruct->txt_devmax < dev)
+	    reportstruct->txt_devmax = dev;
+    }
+    return reaped;
+}
+
+// The tail of the schedule is still held by the qdisc, the final datagram
+// (the server's end of test) has to wait for it to reach the wire
+void Client::TxTimeDrain () {
+    uint64_t deadline = txt_last + (TXTIMEDRAINMS * 1000000ULL);
+    if (!txt_stamping) {
+	TxTimeWait(txt_last);
+	return;
+    }
+    while ((txt_reapid != txt_sendid) && (TxTimeNow() < deadline) && !sInterupted) {
+	TxTimeReap(1);
+    }
+}
+
+void Client::TxTimeFree () {
+    DELETE_ARRAY(txt_launch);
+    txt_stamping = false;
+}
+#endif
+
+// The record layer cuts a write into records of max_send_fragment bytes
+inline int Client::TLSRecordCount (size_t len) {
+    size_t fragment = (mSettings->mTLSRecordSize > 0) ? mSettings->mTLSRecordSize : SSL3_RT_MAX_PLAIN_LENGTH;
+    return static_cast<int>((len + fragment - 1) / fragment);
+}
+
+// Write all the bytes with one SSL_write_ex, i.e. the record layer gets the
+// whole run of full size records (and pipelines) in a single call
+bool Client::TLSWriteAll (const char *buffer, size_t len) {
+    size_t written = 0;
+    int rc;
+    do {
+	rc = SSL_write_ex(conn, buffer, len, &written);
+    } while (!rc && tls_async_wait(mySocket, conn, rc));
+    if (!rc) {
+	ERR_print_errors_fp(stderr);
+	return false;
+    }
+    reportstruct->tlsrecords += TLSRecordCount(written);
+    return true;
+}
+
+// --tls-coalesce, stage small writes so every SSL_write_ex hands the record
+// layer full size records, i.e. one record and one AEAD operation per
+// record size bytes rather than per -l buffer. Staged bytes are accepted
+// as written, much like a socket buffer accepts a send(), and the final
+// partial record is flushed by FinishTrafficActions
+ssize_t Client::TLSWriteRecords (const void *buffer, size_t len) {
+    const char *src = static_cast<const char *>(buffer);
+    size_t remaining = len;
+    // large writes go straight through, less the tail of a partial record
+    if ((tls_coalesce_fill == 0) && (remaining >= tls_coalesce_size)) {
+	size_t direct = remaining - (remaining % mSettings->mTLSRecordSize);
+	if (!TLSWriteAll(src, direct))
+	    return -1;
+	src += direct;
+	remaining -= direct;
+    }
+    while (remaining > 0) {
+	size_t n = tls_coalesce_size - tls_coalesce_fill;
+	if (n > remaining)
+	    n = remaining;
+	memcpy(tls_coalesce_buf + tls_coalesce_fill, src, n);
+	tls_coalesce_fill += n;
+	src += n;
+	remaining -= n;
+	if (tls_coalesce_fill == tls_coalesce_size) {
+	    tls_coalesce_fill = 0;
+	    if (!TLSWriteAll(tls_coalesce_buf, tls_coalesce_size))
+		return -1;
+	}
+    }
+    return len;
+}
+
+inline bool Client::TLSRekeyDue (void) {
+    if (!conn || !isTLSRekey(mSettings))
+	return false;
+    if ((mSettings->mTLSRekeyBytes > 0) && ((totLen - tls_rekey_mark) >= mSettings->mTLSRekeyBytes))
+	return true;
+    return ((mSettings->mTLSRekeyTime > 0) && (now.subSec(tls_rekey_next) >= 0));
+}
+
+// --tls-rekey, rotate the traffic keys in the middle of the stream. TLS 1.3
+// sends a KeyUpdate and requests the peer update too, TLS 1.2 renegotiates,
+// i.e. a full handshake over the established connection. The time spent in
+// here is the stall seen by the send loop and is reported with the write
+void Client::TLSRekey () {
+    Timestamp start;
+    int rc;
+    if (SSL_version(conn) >= TLS1_3_VERSION)
+	rc = SSL_key_update(conn, SSL_KEY_UPDATE_REQUESTED);
+    else
+	rc = SSL_renegotiate(conn);
+    if (rc == 1) {
+	do {
+	    rc = SSL_do_handshake(conn);
+	} while ((rc <= 0) && tls_async_wait(mySocket, conn, rc));
+    }
+    now.setnow();
+    if (rc != 1) {
+	ERR_print_errors_fp(stderr);
+	if (SSL_version(conn) < TLS1_3_VERSION)
+	    fprintf(stderr, "WARN: TLS key rotation failed, disabling --tls-rekey (the server needs --tls-rekey to allow renegotiation)\n");
+	else
+	    fprintf(stderr, "WARN: TLS key rotation failed, disabling --tls-rekey\n");
+	unsetTLSRekey(mSettings);
+	return;
+    }
+    reportstruct->tlsrekeys++;
+    reportstruct->tlsrekey_stall += now.subSec(start);
+    tls_rekey_mark = totLen;
+    tls_rekey_next = now;
+    tls_rekey_next.add(mSettings->mTLSRekeyTime);
+}
+
+#if HAVE_IO_URING
+/*
+ * TCP send loop on io_uring, --io-uring
+ *
+ * Keeps up to mIOUringDepth writes in flight from a pool of registered
+ * buffers on a registered socket, i.e. one io_uring_enter() both submits
+ * the refills and reaps the completions. With --zerocopy the writes are
+ * SEND_ZC and a slot is reused only after its notification completion.
+ * The plain TCP payload is a pattern so writes completing out of order
+ * don't matter, the burst (header) loops aren't supported by ModalOptions.
+ * A short write still has its unsent rest written before any new write.
+ * Each completion is reported as a write via ReportPacket.
+ */
+enum { UringSlotFree = 0, UringSlotSend, UringSlotNotif };
+#define URING_CANCEL_TAG ~0ULL
+
+// A write of len bytes at off into the slot's buffer, fd -1 is the
+// registered socket
+static void uring_prep_write (struct io_uring_sqe *sqe, int slot, struct iovec *iovs, int off, int len, \
+			      bool sendzc, bool fixedbufs, int fd) {
+    if (sendzc) {
+#ifdef IORING_SEND_ZC_REPORT_USAGE
+	sqe->opcode = IORING_OP_SEND_ZC;
+	sqe->ioprio = IORING_RECVSEND_FIXED_BUF | IORING_SEND_ZC_REPORT_USAGE;
+	sqe->buf_index = slot;
+	sqe->msg_flags = MSG_WAITALL;
+#endif
+    } else if (fixedbufs) {
+	sqe->opcode = IORING_OP_WRITE_FIXED;
+	sqe->buf_index = slot;
+    } else {
+	sqe->opcode = IORING_OP_SEND;
+	sqe->msg_flags = MSG_WAITALL;
+    }
+    if (fd < 0) {
+	sqe->fd = 0;
+	sqe->flags |= IOSQE_FIXED_FILE;
+    } else {
+	sqe->fd = fd;
+    }
+    sqe->addr = reinterpret_cast<unsigned long>(static_cast<char *>(iovs[slot].iov_base) + off);
+    sqe->len = len;
+    sqe->user_data = slot;
+}
+
+void Client::RunTCPUring () {
+    const int depth = mSettings->mIOUringDepth;
+    struct iouring *ring = iouring_init(depth);
+    if (!ring) {
+	WARN_errno(1, "io_uring_setup, using the send() loop");
+	unsetIOUring(mSettings);
+	RunTCP();
+	return;
+    }
+    // Without a timed wait a full socket would block the interval
+    // reports and the -t end check in io_uring_enter()
+    if (!ring->ext_arg) {
+	fprintf(stderr, "WARN: io_uring timed waits (IORING_FEAT_EXT_ARG) not supported by the kernel, using the send() loop\n");
+	iouring_free(ring);
+	unsetIOUring(mSettings);
+	RunTCP();
+	return;
+    }
+    char *pool = new char[static_cast<size_t>(depth) * mSettings->mBufLen];
+    struct iovec *iovs = new struct iovec[depth];
+    int *slotstate = new int[depth];
+    int *slotlen = new int[depth];
+    int *slotoff = new int[depth];      // bytes of the slot written
+    int *slotsub = new int[depth];      // bytes of the slot's write in flight
+    bool *slotshort = new bool[depth];  // awaiting its notification to resend
+    int *freeslots = new int[depth];
+    int freecnt = 0;
+    // the short writes to finish, in order, ahead of any new write
+    int *resend = new int[depth];
+    int resendhead = 0;
+    int resendcnt = 0;
+    int shortcnt = 0;
+    for (int ix = depth - 1; ix >= 0; ix--) {
+	iovs[ix].iov_base = pool + (static_cast<size_t>(ix) * mSettings->mBufLen);
+	iovs[ix].iov_len = mSettings->mBufLen;
+	memcpy(iovs[ix].iov_base, mSettings->mBuf, mSettings->mBufLen);
+	slotstate[ix] = UringSlotFree;
+	slotshort[ix] = false;
+	freeslots[freecnt++] = ix;
+    }
+    bool fixedbufs = (iouring_register_buffers(ring, iovs, depth) == 0);
+    bool fixedfile = (iouring_register_files(ring, &mySocket, 1) == 0);
+    bool sendzc = false;
+#ifdef IORING_SEND_ZC_REPORT_USAGE
+    if (isZeroCopy(mSettings)) {
+	sendzc = fixedbufs && iouring_probe_op(ring, IORING_OP_SEND_ZC);
+	if (!sendzc)
+	    fprintf(stderr, "WARN: io_uring SEND_ZC not supported, using copy writes\n");
+    }
+#endif
+    intmax_t queued = 0;
+    int inflight = 0;
+    bool fatal = false;
+    bool cancelled = false;
+    bool timedout = false;
+    now.setnow();
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    while (1) {
+	// first the unsent rest of the short writes, then refill the window
+	while ((resendcnt > 0) && !fatal && !cancelled) {
+	    struct io_uring_sqe *sqe = iouring_get_sqe(ring);
+	    if (!sqe)
+		break;
+	    int slot = resend[resendhead];
+	    resendhead = (resendhead + 1) % depth;
+	    resendcnt--;
+	    shortcnt--;
+	    slotsub[slot] = slotlen[slot] - slotoff[slot];
+	    uring_prep_write(sqe, slot, iovs, slotoff[slot], slotsub[slot], sendzc, fixedbufs, (fixedfile ? -1 : mySocket));
+	    slotstate[slot] = UringSlotSend;
+	    inflight++;
+	}
+	while ((freecnt > 0) && (shortcnt == 0) && !fatal && InProgress() && \
+	       (!isModeAmount(mSettings) || (static_cast<intmax_t>(mSettings->mAmount) > queued))) {
+	    struct io_uring_sqe *sqe = iouring_get_sqe(ring);
+	    if (!sqe)
+		break;
+	    int slot = freeslots[--freecnt];
+	    int writelen = mSettings->mBufLen;
+	    if (isModeAmount(mSettings) && ((static_cast<intmax_t>(mSettings->mAmount) - queued) < writelen))
+		writelen = static_cast<int>(mSettings->mAmount - queued);
+	    uring_prep_write(sqe, slot, iovs, 0, writelen, sendzc, fixedbufs, (fixedfile ? -1 : mySocket));
+	    slotstate[slot] = UringSlotSend;
+	    slotlen[slot] = writelen;
+	    slotoff[slot] = 0;
+	    slotsub[slot] = writelen;
+	    queued += writelen;
+	    inflight++;
+	}
+	if (!inflight)
+	    break;
+	// an interrupt, a closed peer or the end of the traffic shouldn't
+	// wait on the queued writes, e.g. with a small window
+	if ((sInterupted || peerclose || fatal || !InProgress()) && !cancelled) {
+	    struct io_uring_sqe *sqe = iouring_get_sqe(ring);
+	    if (sqe) {
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+		sqe->user_data = URING_CANCEL_TAG;
+		cancelled = true;
+	    }
+	}
+	int rc = iouring_submit(ring, 1, IOURINGWAITUSEC);
+	timedout = (rc == -ETIME);
+	if (timedout) {
+	    now.setnow();
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+	} else if ((rc < 0) && (rc != -EINTR) && (rc != -EAGAIN) && (rc != -EBUSY)) {
+	    errno = -rc;
+	    WARN_errno(1, "io_uring_enter");
+	    break;
+	}
+	struct io_uring_cqe *cqe;
+	while ((cqe = iouring_peek_cqe(ring)) != NULL) {
+	    if (cqe->user_data == URING_CANCEL_TAG) {
+		iouring_cqe_seen(ring);
+		continue;
+	    }
+	    int slot = static_cast<int>(cqe->user_data);
+#ifdef IORING_CQE_F_NOTIF
+	    if (cqe->flags & IORING_CQE_F_NOTIF) {
+		// the kernel is done with the pages of this slot
+		if (cqe->res & IORING_NOTIF_USAGE_ZC_COPIED)
+		    reportstruct->zc_copied++;
+		else
+		    reportstruct->zc_zerocopy++;
+		if (slotshort[slot]) {
+		    slotshort[slot] = false;
+		    resend[(resendhead + resendcnt++) % depth] = slot;
+		} else {
+		    slotstate[slot] = UringSlotFree;
+		    freeslots[freecnt++] = slot;
+		}
+		inflight--;
+		iouring_cqe_seen(ring);
+		continue;
+	    }
+#endif
+	    int res = cqe->res;
+	    bool more = ((cqe->flags & IORING_CQE_F_MORE) != 0);
+	    iouring_cqe_seen(ring);
+	    inflight--;
+	    // a short write keeps its rest queued
+	    bool partial = (res > 0) && (res < slotsub[slot]);
+	    queued -= (partial ? res : slotsub[slot]);
+	    if (partial) {
+		slotoff[slot] += res;
+		shortcnt++;
+	    }
+	    if (more) {
+		slotstate[slot] = UringSlotNotif;
+		slotshort[slot] = partial;
+		inflight++;
+	    } else if (partial) {
+		resend[(resendhead + resendcnt++) % depth] = slot;
+	    } else {
+		slotstate[slot] = UringSlotFree;
+		freeslots[freecnt++] = slot;
+	    }
+	    now.setnow();
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+	    reportstruct->sentTime = reportstruct->packetTime;
+	    reportstruct->writecnt = 1;
+	    if (res <= 0) {
+		if (res == 0) {
+		    peerclose = true;
+		} else if ((res == -ECANCELED) || NONFATALTCPWRITERR(-res)) {
+		    reportstruct->errwrite=WriteErrAccount;
+		} else if (sendzc && (res == -EINVAL)) {
+		    // e.g. a kernel without SEND_ZC usage reports
+		    fprintf(stderr, "WARN: io_uring SEND_ZC failed, using copy writes\n");
+		    sendzc = false;
+		    reportstruct->errwrite=WriteErrNoAccount;
+		} else {
+		    errno = -res;
+		    reportstruct->errwrite=WriteErrFatal;
+		    WARN_errno(1, "tcp write");
+		    fatal = true;
+		}
+		reportstruct->packetLen = 0;
+		reportstruct->emptyreport = 1;
+	    } else {
+		reportstruct->packetLen = res;
+		reportstruct->emptyreport = 0;
+		reportstruct->errwrite=WriteNoErr;
+		totLen += res;
+		if (isModeAmount(mSettings)) {
+		    /* mAmount may be unsigned, so don't let it underflow! */
+		    if (mSettings->mAmount >= static_cast<unsigned long>(res)) {
+			mSettings->mAmount -= static_cast<unsigned long>(res);
+		    } else {
+			mSettings->mAmount = 0;
+		    }
+		}
+	    }
+	    if (!one_report) {
+		myReportPacket();
+	    }
+	}
+    }
+    iouring_free(ring);
+    DELETE_ARRAY(resend);
+    DELETE_ARRAY(freeslots);
+    DELETE_ARRAY(slotshort);
+    DELETE_ARRAY(slotsub);
+    DELETE_ARRAY(slotoff);
+    DELETE_ARRAY(slotlen);
+    DELETE_ARRAY(slotstate);
+    DELETE_ARRAY(iovs);
+    DELETE_ARRAY(pool);
+    FinishTrafficActions();
+}
+#endif
+
 /*
  * TCP send loop
  */
@@ -569,9 +1475,44 @@ void Client::RunTCP () {
     int burst_id = 1;
     int writelen = mSettings->mBufLen;
 
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // kTLS with a -F regular file, have the kernel encrypt straight from
+    // the page cache rather than fread() into mBuf followed by a write
+    if (ktls_tx && !isburst && isFileInput(mSettings) && mSettings->Extractor_file) {
+	struct stat filestat;
+	if ((fstat(fileno(mSettings->Extractor_file), &filestat) == 0) && S_ISREG(filestat.st_mode)) {
+	    tls_sendfile = true;
+	    sendfile_offset = ftello(mSettings->Extractor_file);
+	    sendfile_size = filestat.st_size;
+	}
+    }
+#endif
+#if HAVE_SENDFILE_SPLICE
+    // --sendfile, a regular file goes by sendfile() from the page cache
+    // and a pipe (e.g. -I from a producer) by splice(), either way the
+    // payload never lands in mBuf
+    if (isSendfile(mSettings) && !conn && !isburst && isFileInput(mSettings) && mSettings->Extractor_file) {
+	struct stat filestat;
+	if (fstat(fileno(mSettings->Extractor_file), &filestat) == 0) {
+	    if (S_ISREG(filestat.st_mode)) {
+		file_sendfile = true;
+		sendfile_offset = ftello(mSettings->Extractor_file);
+		sendfile_size = filestat.st_size;
+	    } else if (S_ISFIFO(filestat.st_mode)) {
+		file_splice = true;
+	    }
+	}
+	if (!file_sendfile && !file_splice) {
+	    fprintf(stderr, "WARN: --sendfile input is neither a regular file nor a pipe, using read/write\n");
+	}
+    }
+#endif
     now.setnow();
     reportstruct->packetTime.tv_sec = now.getSecs();
     reportstruct->packetTime.tv_usec = now.getUsecs();
+    tls_rekey_mark = totLen;
+    tls_rekey_next = now;
+    tls_rekey_next.add(mSettings->mTLSRekeyTime);
     while (InProgress()) {
 	reportstruct->writecnt = 0;
         if (isModeAmount(mSettings)) {
@@ -638,6 +1579,24 @@ void Client::RunTCP () {
 	    if (isWritePrefetch(mSettings)) {
 		AwaitWriteSelectEventTCP();
 	    }
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	    if (tls_sendfile) {
+		if (writelen > (sendfile_size - sendfile_offset))
+		    writelen = static_cast<int>(sendfile_size - sendfile_offset);
+		reportstruct->packetLen = SSL_sendfile(conn, fileno(mSettings->Extractor_file), sendfile_offset, writelen, 0);
+		if (reportstruct->packetLen > 0)
+		    sendfile_offset += reportstruct->packetLen;
+	    } else
+#endif
+#if HAVE_SENDFILE_SPLICE
+	    if (file_sendfile) {
+		if (writelen > (sendfile_size - sendfile_offset))
+		    writelen = static_cast<int>(sendfile_size - sendfile_offset);
+		reportstruct->packetLen = sendfile(mySocket, fileno(mSettings->Extractor_file), &sendfile_offset, writelen);
+	    } else if (file_splice) {
+		reportstruct->packetLen = splice(fileno(mSettings->Extractor_file), NULL, mySocket, NULL, writelen, SPLICE_F_MOVE | SPLICE_F_MORE);
+	    } else
 #endif
 	    reportstruct->packetLen = sendTCP(mySocket, mSettings->mBuf, writelen, 0);
 	    now.setnow();
@@ -686,6 +1645,9 @@ void Client::RunTCP () {
 		mSettings->mAmount = 0;
 	    }
 	}
+	if (TLSRekeyDue()) {
+	    TLSRekey();
+	}
 	if (!one_report) {
 	    myReportPacket();
 	}
@@ -809,10 +1771,9 @@ void Client::RunRateLimitedTCP () {
 	// Add tokens per the loop time
 	time2.setnow();
         if (isVaryLoad(mSettings)) {
-	    static Timestamp time3;
-	    if (time2.subSec(time3) >= VARYLOAD_PERIOD) {
+	    if (time2.subSec(varyload_time) >= VARYLOAD_PERIOD) {
 		var_rate = lognormal(mSettings->mAppRate,mSettings->mVariance);
-		time3 = time2;
+		varyload_time = time2;
 		if (var_rate < 0)
 		    var_rate = 0;
 	    }
@@ -893,12 +1854,8 @@ void Client::RunRateLimitedTCP () {
 }
 
 #if HAVE_DECL_TCP_NOTSENT_LOWAT
-inline bool Client::AwaitWriteSelectEventTCP (void) {
-    int rc;
-    struct timeval timeout;
-    fd_set writeset;
-    FD_ZERO(&writeset);
-    FD_SET(mySocket, &writeset);
+// The longest wait for the socket to take a write, in usecs
+inline long Client::WriteEventTimeout (void) {
     if (isModeTime(mSettings)) {
         Timestamp write_event_timeout(0,0);
 	if (mSettings->mInterval && (mSettings->mIntervalMode == kInterval_Time)) {
@@ -906,12 +1863,20 @@ inline bool Client::AwaitWriteSelectEventTCP (void) {
 	} else {
 	    write_event_timeout.add((double) mSettings->mAmount / 1e2 * 4.0);
 	}
-	timeout.tv_sec = write_event_timeout.getSecs();
-        timeout.tv_usec = write_event_timeout.getUsecs();
-    } else {
-	timeout.tv_sec = 10; // longest is 10 seconds
-	timeout.tv_usec = 0;
+	return (write_event_timeout.getSecs() * 1000000L) + write_event_timeout.getUsecs();
     }
+    return 10000000L; // longest is 10 seconds
+}
+
+inline bool Client::AwaitWriteSelectEventTCP (void) {
+    int rc;
+    struct timeval timeout;
+    fd_set writeset;
+    FD_ZERO(&writeset);
+    FD_SET(mySocket, &writeset);
+    long timeout_usec = WriteEventTimeout();
+    timeout.tv_sec = timeout_usec / 1000000L;
+    timeout.tv_usec = timeout_usec % 1000000L;
 
     Timestamp t1;
     if ((rc = select(mySocket + 1, NULL, &writeset, NULL, &timeout)) <= 0) {
@@ -973,41 +1938,240 @@ void Client::RunWriteEventsTCP () {
     }
     FinishTrafficActions();
 }
-#endif
-void Client::RunBounceBackTCP () {
 
-}
+#if HAVE_IO_URING
 /*
- * UDP send loop
+ * RunWriteEventsTCP() on io_uring, --tcp-write-prefetch --io-uring
+ *
+ * The write and the POLLOUT wait for the next one are linked and go in
+ * one io_uring_enter() rather than a select() and a write() each. The
+ * header is written once the wait completes, so the write timestamps
+ * are as before and only one write is in flight. A short write breaks
+ * the link, its rest then goes with the next wait and without a header.
  */
-double Client::get_delay_target () {
-    double delay_target;
-    if (isIPG(mSettings)) {
-	delay_target = mSettings->mBurstIPG * 1000000;  // convert from milliseconds to nanoseconds
-    } else {
-	// compute delay target in units of nanoseconds
-	if (mSettings->mAppRateUnits == kRate_BW) {
-	    // compute delay for bandwidth restriction, constrained to [0,1] seconds
-	    delay_target = (mSettings->mBufLen * ((kSecs_to_nsecs * kBytes_to_Bits)
-							   / mSettings->mAppRate));
-	} else {
-	    delay_target = 1e9 / mSettings->mAppRate;
-	}
+#define URING_WRITE_TAG 1ULL
+#define URING_POLL_TAG  2ULL
+void Client::RunWriteEventsTCPUring () {
+    struct iouring *ring = iouring_init(4);
+    if (!ring || !ring->ext_arg) {
+	if (!ring)
+	    WARN_errno(1, "io_uring_setup, using select()");
+	else
+	    fprintf(stderr, "WARN: io_uring timed waits (IORING_FEAT_EXT_ARG) not supported by the kernel, using select()\n");
+	iouring_free(ring);
+	unsetIOUring(mSettings);
+	RunWriteEventsTCP();
+	return;
     }
-    return delay_target;
-}
-
-void Client::RunUDP () {
-    struct UDP_datagram* mBuf_UDP = reinterpret_cast<struct UDP_datagram*>(mSettings->mBuf);
-    int currLen;
-
-    double delay_target = get_delay_target();
-    double delay = 0;
-    double adjust = 0;
+    int burst_id = 0;
+    int writelen = mSettings->mBufLen;
+    int sent = 0;            // bytes of the current write sent
+    bool writable = false;   // the wait completed, the next write may go
+    bool waiting = false;    // the wait is submitted
+    bool writing = false;    // the write is submitted
+    bool fatal = false;
+    double select_delay = -1;
+    Timestamp t1;
+    now.setnow();
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    while ((InProgress() || writing) && !fatal && !sInterupted && !peerclose) {
+	if (writable && (sent == 0) && InProgress()) {
+	    if (isModeAmount(mSettings)) {
+		writelen = ((mSettings->mAmount < static_cast<unsigned>(mSettings->mBufLen)) ? mSettings->mAmount : mSettings->mBufLen);
+	    }
+	    now.setnow();
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+	    WriteTcpTxHdr(reportstruct, writelen, ++burst_id);
+	    reportstruct->sentTime = reportstruct->packetTime;
+	}
+	if ((writable || (sent > 0)) && !writing && InProgress()) {
+	    struct io_uring_sqe *sqe = iouring_get_sqe(ring);
+	    sqe->opcode = IORING_OP_SEND;
+	    sqe->fd = mySocket;
+	    sqe->addr = reinterpret_cast<unsigned long>(mSettings->mBuf + sent);
+	    sqe->len = writelen - sent;
+	    sqe->msg_flags = MSG_WAITALL;
+	    sqe->flags = IOSQE_IO_LINK;
+	    sqe->user_data = URING_WRITE_TAG;
+	    writable = false;
+	    writing = true;
+	}
+	if (!waiting) {
+	    struct io_uring_sqe *sqe = iouring_get_sqe(ring);
+	    sqe->opcode = IORING_OP_POLL_ADD;
+	    sqe->fd = mySocket;
+	    sqe->poll32_events = POLLOUT;
+	    sqe->user_data = URING_POLL_TAG;
+	    waiting = true;
+	    t1.setnow();
+	}
+	// the write's completion alone doesn't end the wait
+	int rc = iouring_submit(ring, (writing && waiting) ? 2 : 1, WriteEventTimeout());
+	if ((rc == -ETIME) && !iouring_peek_cqe(ring)) {
+	    // as the select() timeout, the wait stays submitted
+#ifdef HAVE_THREAD_DEBUG
+	    thread_debug("AwaitWrite timeout");
+#endif
+	    now.setnow();
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+	    reportstruct->select_delay = -1;
+	    reportstruct->packetLen = 0;
+	    reportstruct->emptyreport = 1;
+	    if (!one_report) {
+		myReportPacket();
+	    }
+	    continue;
+	} else if ((rc < 0) && (rc != -ETIME) && (rc != -EINTR) && (rc != -EAGAIN) && (rc != -EBUSY)) {
+	    errno = -rc;
+	    WARN_errno(1, "io_uring_enter");
+	    break;
+	}
+	struct io_uring_cqe *cqe;
+	while ((cqe = iouring_peek_cqe(ring)) != NULL) {
+	    unsigned long long tag = cqe->user_data;
+	    int res = cqe->res;
+	    iouring_cqe_seen(ring);
+	    if (tag == URING_POLL_TAG) {
+		waiting = false;
+		// cancelled, i.e. the linked write fell short or failed
+		if (res > 0) {
+		    Timestamp t2;
+		    select_delay = t2.subSec(t1);
+		    writable = true;
+		}
+		continue;
+	    }
+	    writing = false;
+	    t1.setnow();
+	    reportstruct->select_delay = select_delay;
+	    reportstruct->writecnt = 1;
+	    if (res > 0) {
+		sent += res;
+		if (sent >= writelen)
+		    sent = 0;
+		reportstruct->packetLen = res;
+		reportstruct->emptyreport = 0;
+		reportstruct->errwrite = WriteNoErr;
+	    } else {
+		if (res == 0) {
+		    peerclose = true;
+		} else if (NONFATALTCPWRITERR(-res)) {
+		    reportstruct->errwrite = WriteErrAccount;
+		} else {
+		    errno = -res;
+		    reportstruct->errwrite = WriteErrFatal;
+		    WARN_errno(1, "event writen()");
+		    fatal = true;
+		}
+		reportstruct->packetLen = 0;
+		reportstruct->emptyreport = 1;
+	    }
+	    if (isModeAmount(mSettings) && !reportstruct->emptyreport) {
+		/* mAmount may be unsigned, so don't let it underflow! */
+		if (mSettings->mAmount >= static_cast<unsigned long>(reportstruct->packetLen)) {
+		    mSettings->mAmount -= static_cast<unsigned long>(reportstruct->packetLen);
+		} else {
+		    mSettings->mAmount = 0;
+		}
+	    }
+	    if (!one_report) {
+		myReportPacket();
+	    }
+	}
+    }
+    iouring_free(ring);
+    FinishTrafficActions();
+}
+#endif
+#endif
+void Client::RunBounceBackTCP () {
+
+}
+/*
+ * UDP send loop
+ */
+double Client::get_delay_target () {
+    double delay_target;
+    if (isIPG(mSettings)) {
+	delay_target = mSettings->mBurstIPG * 1000000;  // convert from milliseconds to nanoseconds
+    } else {
+	// compute delay target in units of nanoseconds
+	if (mSettings->mAppRateUnits == kRate_BW) {
+	    // compute delay for bandwidth restriction, constrained to [0,1] seconds
+	    delay_target = (mSettings->mBufLen * ((kSecs_to_nsecs * kBytes_to_Bits)
+							   / mSettings->mAppRate));
+	} else {
+	    delay_target = 1e9 / mSettings->mAppRate;
+	}
+    }
+    return delay_target;
+}
+
+/*
+ * UDP pacing shared by the send loops
+ *
+ * With a variable load (-b rate,variance) pick a new lognormal rate
+ * every VARYLOAD_PERIOD and update the per datagram delay target.
+ * The period timer is per Client so each traffic thread draws its
+ * own rates.
+ */
+void Client::udp_vary_load (double &delay_target) {
+    if (isVaryLoad(mSettings) && mSettings->mAppRateUnits == kRate_BW) {
+	if (now.subSec(varyload_time) >= VARYLOAD_PERIOD) {
+	    long var_rate = lognormal(mSettings->mAppRate,mSettings->mVariance);
+	    if (var_rate < 0)
+		var_rate = 0;
+	    delay_target = (mSettings->mBufLen * ((kSecs_to_nsecs * kBytes_to_Bits) / var_rate));
+	    varyload_time = now;
+	}
+    }
+}
+
+/*
+ * Adjustment for the running delay
+ * o measure how long the last loop iteration took
+ * o calculate the delay adjust
+ *   - If the last write put sent datagrams on the wire,
+ *     adjust = sent * target IPG - the loop time
+ *   - If write failed, adjust = the loop time
+ * o then adjust the overall running delay
+ * Note: adjust units are nanoseconds,
+ *       packet timestamps are microseconds
+ */
+void Client::udp_running_delay (double &delay, double delay_target, int sent) {
+    double adjust;
+    if (sent > 0)
+	adjust = (delay_target * sent) + \
+	    (1000.0 * lastPacketTime.subUsec(reportstruct->packetTime));
+    else
+	adjust = 1000.0 * lastPacketTime.subUsec(reportstruct->packetTime);
+    lastPacketTime.set(reportstruct->packetTime.tv_sec, reportstruct->packetTime.tv_usec);
+    // Since linux nanosleep/busyloop can exceed delay
+    // there are two possible equilibriums
+    //  1)  Try to perserve inter packet gap
+    //  2)  Try to perserve requested transmit rate
+    // The latter seems preferred, hence use a running delay
+    // that spans the life of the thread and constantly adjust.
+    // A negative delay means the iperf app is behind.
+    delay += adjust;
+    // Don't let delay grow unbounded
+    if (delay < delay_lower_bounds) {
+	delay = delay_target;
+    }
+}
+
+void Client::RunUDP () {
+    struct UDP_datagram* mBuf_UDP = reinterpret_cast<struct UDP_datagram*>(mSettings->mBuf);
+    int currLen;
+
+    double delay_target = get_delay_target();
+    double delay = 0;
 
     // Set this to > 0 so first loop iteration will delay the IPG
     currLen = 1;
-    double variance = mSettings->mVariance;
     if (apply_first_udppkt_delay && (delay_target > 100000)) {
 	//the case when a UDP first packet went out in SendFirstPayload
 	delay_loop(static_cast<unsigned long>(delay_target / 1000));
@@ -1026,56 +2190,21 @@ void Client::RunUDP () {
 	reportstruct->packetTime.tv_sec = now.getSecs();
 	reportstruct->packetTime.tv_usec = now.getUsecs();
 	reportstruct->sentTime = reportstruct->packetTime;
-        if (isVaryLoad(mSettings) && mSettings->mAppRateUnits == kRate_BW) {
-	    static Timestamp time3;
-	    if (now.subSec(time3) >= VARYLOAD_PERIOD) {
-		long var_rate = lognormal(mSettings->mAppRate,variance);
-		if (var_rate < 0)
-		    var_rate = 0;
-		delay_target = (mSettings->mBufLen * ((kSecs_to_nsecs * kBytes_to_Bits) / var_rate));
-		time3 = now;
-	    }
-	}
+	udp_vary_load(delay_target);
 	// store datagram ID into buffer
 	WritePacketID(reportstruct->packetID);
 	mBuf_UDP->tv_sec  = htonl(reportstruct->packetTime.tv_sec);
 	mBuf_UDP->tv_usec = htonl(reportstruct->packetTime.tv_usec);
 
-	// Adjustment for the running delay
-	// o measure how long the last loop iteration took
-	// o calculate the delay adjust
-	//   - If write succeeded, adjust = target IPG - the loop time
-	//   - If write failed, adjust = the loop time
-	// o then adjust the overall running delay
-	// Note: adjust units are nanoseconds,
-	//       packet timestamps are microseconds
-	if (currLen > 0)
-	    adjust = delay_target + \
-		(1000.0 * lastPacketTime.subUsec(reportstruct->packetTime));
-	else
-	    adjust = 1000.0 * lastPacketTime.subUsec(reportstruct->packetTime);
-
-	lastPacketTime.set(reportstruct->packetTime.tv_sec, reportstruct->packetTime.tv_usec);
-	// Since linux nanosleep/busyloop can exceed delay
-	// there are two possible equilibriums
-	//  1)  Try to perserve inter packet gap
-	//  2)  Try to perserve requested transmit rate
-	// The latter seems preferred, hence use a running delay
-	// that spans the life of the thread and constantly adjust.
-	// A negative delay means the iperf app is behind.
-	delay += adjust;
-	// Don't let delay grow unbounded
-	if (delay < delay_lower_bounds) {
-	    delay = delay_target;
-	}
+	udp_running_delay(delay, delay_target, (currLen > 0) ? 1 : 0);
 
 	reportstruct->errwrite = WriteNoErr;
 	reportstruct->emptyreport = 0;
 	// perform write
 	if (isModeAmount(mSettings)) {
-	    currLen = write(mySocket, mSettings->mBuf, (mSettings->mAmount < static_cast<unsigned>(mSettings->mBufLen)) ? mSettings->mAmount : mSettings->mBufLen);
+	    currLen = sendUDP(mySocket, mSettings->mBuf, (mSettings->mAmount < static_cast<unsigned>(mSettings->mBufLen)) ? mSettings->mAmount : mSettings->mBufLen);
 	} else {
-	    currLen = write(mySocket, mSettings->mBuf, mSettings->mBufLen);
+	    currLen = sendUDP(mySocket, mSettings->mBuf, mSettings->mBufLen);
 	}
 	if (currLen < 0) {
 	    reportstruct->packetID--;
@@ -1116,6 +2245,393 @@ void Client::RunUDP () {
     FinishTrafficActions();
 }
 
+#if defined(__linux__)
+/*
+ * UDP send loop with batched writes, --udp-batch and --udp-gso
+ *
+ * Each batch slot is a copy of the payload with its own UDP_datagram
+ * header so one sendmmsg(), or one UDP_SEGMENT (GSO) send, carries up
+ * to mUDPBatch datagrams. The running delay paces per batch while the
+ * accounting is still posted to the reporter one datagram at a time.
+ */
+void Client::RunUDPBatch () {
+    const int batch = mSettings->mUDPBatch;
+    const int len = mSettings->mBufLen;
+    char *batchbuf = new char[batch * len];
+    struct iovec *iov = new struct iovec[batch];
+    struct mmsghdr *msgs = new struct mmsghdr[batch];
+    memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+    for (int ix = 0; ix < batch; ix++) {
+	memcpy(batchbuf + (ix * len), mSettings->mBuf, len);
+	iov[ix].iov_base = batchbuf + (ix * len);
+	iov[ix].iov_len = len;
+	msgs[ix].msg_hdr.msg_iov = &iov[ix];
+	msgs[ix].msg_hdr.msg_iovlen = 1;
+    }
+#ifdef UDP_SEGMENT
+    // GSO, the stack gets one super-packet and cuts it into len sized
+    // datagrams, only the last one may be short
+    bool gso = isUDPGSO(mSettings);
+    union {
+	char buf[CMSG_SPACE(sizeof(uint16_t))];
+	struct cmsghdr align;
+    } control;
+    struct msghdr gsomsg;
+    memset(&gsomsg, 0, sizeof(gsomsg));
+    gsomsg.msg_iov = iov;
+    gsomsg.msg_control = control.buf;
+    gsomsg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&gsomsg);
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    *reinterpret_cast<uint16_t *>(CMSG_DATA(cmsg)) = static_cast<uint16_t>(len);
+#endif
+    double delay_target = get_delay_target();
+    double delay = 0;
+    // Set this to > 0 so first loop iteration will delay the IPG
+    int sent = 1;
+    if (apply_first_udppkt_delay && (delay_target > 100000)) {
+	//the case when a UDP first packet went out in SendFirstPayload
+	delay_loop(static_cast<unsigned long>(delay_target / 1000));
+    }
+
+    while (InProgress()) {
+	now.setnow();
+	reportstruct->packetTime.tv_sec = now.getSecs();
+	reportstruct->packetTime.tv_usec = now.getUsecs();
+	reportstruct->sentTime = reportstruct->packetTime;
+	udp_vary_load(delay_target);
+	int count = batch;
+	if (isModeAmount(mSettings) && (mSettings->mAmount < static_cast<unsigned long>(batch * len))) {
+	    count = static_cast<int>((mSettings->mAmount + len - 1) / len);
+	    if (count < 1)
+		count = 1;
+	}
+	// store the datagram IDs, the batch shares one tx timestamp
+	for (int ix = 0; ix < count; ix++) {
+	    struct UDP_datagram* mBuf_UDP = reinterpret_cast<struct UDP_datagram*>(iov[ix].iov_base);
+	    WritePacketID(reinterpret_cast<char *>(iov[ix].iov_base), reportstruct->packetID + ix);
+	    mBuf_UDP->tv_sec  = htonl(reportstruct->packetTime.tv_sec);
+	    mBuf_UDP->tv_usec = htonl(reportstruct->packetTime.tv_usec);
+	    iov[ix].iov_len = len;
+	}
+	if (isModeAmount(mSettings) && (mSettings->mAmount < static_cast<unsigned long>(count * len))) {
+	    iov[count - 1].iov_len = mSettings->mAmount - ((count - 1) * len);
+	}
+
+	// Same running delay as RunUDP, though the target is the IPG
+	// times the number of datagrams the last batch put on the wire
+	udp_running_delay(delay, delay_target, sent);
+
+	// perform the batch write
+	sent = -1;
+#ifdef UDP_SEGMENT
+	if (gso) {
+	    gsomsg.msg_iovlen = count;
+	    if (sendmsg(mySocket, &gsomsg, 0) >= 0) {
+		sent = count;
+	    } else if ((errno == EINVAL) || (errno == EIO)) {
+		// no GSO on the egress path, e.g. the segment size exceeds the MTU
+		WARN_errno(1, "udp gso, using sendmmsg()");
+		gso = false;
+	    }
+	}
+	if (!gso)
+#endif
+	sent = sendmmsg(mySocket, msgs, count, 0);
+	if (sent < 0) {
+	    if (FATALUDPWRITERR(errno)) {
+	        reportstruct->errwrite = WriteErrFatal;
+	        WARN_errno(1, "sendmmsg");
+		break;
+	    }
+	    reportstruct->errwrite = WriteErrAccount;
+	    reportstruct->emptyreport = 1;
+	    reportstruct->packetLen = 0;
+	    reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
+	    myReportPacket();
+	    sent = 0;
+	} else {
+	    // report packets, one per datagram sent
+	    reportstruct->errwrite = WriteNoErr;
+	    reportstruct->emptyreport = 0;
+	    for (int ix = 0; ix < sent; ix++) {
+		if (isModeAmount(mSettings)) {
+		    /* mAmount may be unsigned, so don't let it underflow! */
+		    if (mSettings->mAmount >= static_cast<unsigned long>(iov[ix].iov_len)) {
+			mSettings->mAmount -= static_cast<unsigned long>(iov[ix].iov_len);
+		    } else {
+			mSettings->mAmount = 0;
+		    }
+		}
+		reportstruct->packetLen = static_cast<unsigned long>(iov[ix].iov_len);
+		reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
+		myReportPacket();
+		reportstruct->packetID++;
+		myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+	    }
+	}
+	// Insert delay here only if the running delay is greater than 100 usec,
+	// otherwise don't delay and immediately continue with the next tx.
+	if (delay >= 100000) {
+	    // Convert from nanoseconds to microseconds
+	    // and invoke the microsecond delay
+	    delay_loop(static_cast<unsigned long>(delay / 1000));
+	}
+    }
+    DELETE_ARRAY(msgs);
+    DELETE_ARRAY(iov);
+    DELETE_ARRAY(batchbuf);
+    FinishTrafficActions();
+}
+#endif
+
+#if HAVE_AF_XDP
+// The connected socket picks the interface and the ports, the frames
+// carry that same flow so the peer's socket (or its XSK) takes them.
+// Any failure leaves the traffic on the socket
+bool Client::XdpInit () {
+    struct sockaddr_in local, peer;
+    socklen_t len = sizeof(local);
+    char ifname[IFNAMSIZ];
+    unsigned char dstmac[ETHER_ADDR_LEN];
+    int ifindex = 0;
+    if ((getsockname(mySocket, reinterpret_cast<struct sockaddr *>(&local), &len) == 0) && (local.sin_family == AF_INET)) {
+	len = sizeof(peer);
+	if (getpeername(mySocket, reinterpret_cast<struct sockaddr *>(&peer), &len) == 0)
+	    ifindex = xdpsock_ifindex(&local, ifname);
+    }
+    if (!ifindex) {
+	WARN(1, "af-xdp: no interface holds the local address, using the socket");
+	unsetAFXDP(mSettings);
+	return false;
+    }
+    if ((mSettings->mBufLen + static_cast<int>(sizeof(struct iphdr) + sizeof(struct udphdr))) > xdpsock_mtu(ifname)) {
+	WARN(1, "af-xdp: the datagram exceeds the interface mtu, using the socket");
+	unsetAFXDP(mSettings);
+	return false;
+    }
+    // the first datagram went out on the socket, which resolves the peer
+    int waitms = 0;
+    while (!xdpsock_neighbor(ifname, &peer, dstmac)) {
+	if ((waitms++ >= XDPNEIGHWAITMS) || sInterupted) {
+	    WARN(1, "af-xdp: no neighbor entry for the peer (not on-link?), using the socket");
+	    unsetAFXDP(mSettings);
+	    return false;
+	}
+	delay_loop(1000);
+    }
+    if (!(xdp = xdpsock_init(ifindex, mSettings->mXdpQueue, false))) {
+	WARN_errno(1, "af-xdp socket, using the socket");
+	unsetAFXDP(mSettings);
+	return false;
+    }
+    if (!xdpsock_udp4_flow(xdp, ifname, &local, &peer, dstmac, ((mSettings->mTTL > 0) ? mSettings->mTTL : 64), (mSettings->mTOS & 0xFF))) {
+	WARN(1, "af-xdp: interface isn't ethernet, using the socket");
+	xdpsock_free(xdp);
+	xdp = NULL;
+	unsetAFXDP(mSettings);
+	return false;
+    }
+    return true;
+}
+
+/*
+ * UDP send loop over an AF_XDP socket, --af-xdp
+ *
+ * Each payload is written straight into a UMEM frame behind the prebuilt
+ * Ethernet/IPv4/UDP headers and one sendto() per batch kicks the tx ring.
+ * The batch is what the rate allows in about 100 usecs, up to
+ * XDPSOCK_BATCH frames, and the running delay paces per batch as with
+ * --udp-batch while the accounting is per datagram.
+ */
+void Client::RunUDPXdp () {
+    const int len = mSettings->mBufLen;
+    int lens[XDPSOCK_BATCH];
+    double delay_target = get_delay_target();
+    double delay = 0;
+    // Set this to > 0 so first loop iteration will delay the IPG
+    int sent = 1;
+    if (apply_first_udppkt_delay && (delay_target > 100000)) {
+	//the case when a UDP first packet went out in SendFirstPayload
+	delay_loop(static_cast<unsigned long>(delay_target / 1000));
+    }
+
+    while (InProgress()) {
+	now.setnow();
+	reportstruct->packetTime.tv_sec = now.getSecs();
+	reportstruct->packetTime.tv_usec = now.getUsecs();
+	reportstruct->sentTime = reportstruct->packetTime;
+	udp_vary_load(delay_target);
+	int count = XDPSOCK_BATCH;
+	if ((delay_target * count) > 100000) {
+	    count = static_cast<int>(100000 / delay_target);
+	    if (count < 1)
+		count = 1;
+	}
+	// store the datagram IDs in the frames, the batch shares one tx timestamp
+	unsigned long remaining = mSettings->mAmount;
+	int queued;
+	for (queued = 0; queued < count; queued++) {
+	    uint64_t addr;
+	    int plen = len;
+	    if (isModeAmount(mSettings)) {
+		if (remaining == 0)
+		    break;
+		if (remaining < static_cast<unsigned long>(len))
+		    plen = static_cast<int>(remaining);
+		remaining -= plen;
+	    }
+	    char *payload = xdpsock_udp4_alloc(xdp, &addr);
+	    if (!payload)
+		break;
+	    memcpy(payload, mSettings->mBuf, plen);
+	    struct UDP_datagram* mBuf_UDP = reinterpret_cast<struct UDP_datagram*>(payload);
+	    WritePacketID(payload, reportstruct->packetID + queued);
+	    mBuf_UDP->tv_sec  = htonl(reportstruct->packetTime.tv_sec);
+	    mBuf_UDP->tv_usec = htonl(reportstruct->packetTime.tv_usec);
+	    xdpsock_udp4_queue(xdp, addr, plen);
+	    lens[queued] = plen;
+	}
+
+	// Same running delay as RunUDPBatch
+	udp_running_delay(delay, delay_target, sent);
+
+	// a transient EAGAIN, EBUSY or ENOBUFS leaves the frames queued for
+	// the next kick, they're accounted as written like a socket buffer would
+	if ((xdpsock_tx_kick(xdp) < 0) && (errno != EAGAIN) && (errno != EBUSY) && (errno != ENOBUFS)) {
+	    reportstruct->errwrite = WriteErrFatal;
+	    WARN_errno(1, "af-xdp sendto");
+	    break;
+	}
+	sent = queued;
+	if (queued == 0) {
+	    // every frame is in flight
+	    reportstruct->errwrite = WriteErrAccount;
+	    reportstruct->emptyreport = 1;
+	    reportstruct->packetLen = 0;
+	    reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
+	    myReportPacket();
+	} else {
+	    // report packets, one per datagram sent
+	    reportstruct->errwrite = WriteNoErr;
+	    reportstruct->emptyreport = 0;
+	    for (int ix = 0; ix < queued; ix++) {
+		if (isModeAmount(mSettings)) {
+		    /* mAmount may be unsigned, so don't let it underflow! */
+		    if (mSettings->mAmount >= static_cast<unsigned long>(lens[ix])) {
+			mSettings->mAmount -= static_cast<unsigned long>(lens[ix]);
+		    } else {
+			mSettings->mAmount = 0;
+		    }
+		}
+		reportstruct->packetLen = static_cast<unsigned long>(lens[ix]);
+		reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
+		myReportPacket();
+		reportstruct->packetID++;
+		myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+	    }
+	}
+	// Insert delay here only if the running delay is greater than 100 usec,
+	// otherwise don't delay and immediately continue with the next tx.
+	if (delay >= 100000) {
+	    // Convert from nanoseconds to microseconds
+	    // and invoke the microsecond delay
+	    delay_loop(static_cast<unsigned long>(delay / 1000));
+	}
+    }
+    FinishTrafficActions();
+}
+#endif
+
+#if HAVE_SO_TXTIME
+/*
+ * UDP send loop with kernel pacing, --txtime
+ *
+ * Rather than a delay per datagram each one is stamped with its launch
+ * time and handed to the qdisc (fq or etf) up to the window ahead. The
+ * thread only wakes when the window has half drained. The datagram
+ * carries its launch time as its tx timestamp.
+ */
+void Client::RunUDPTxTime () {
+    struct UDP_datagram* mBuf_UDP = reinterpret_cast<struct UDP_datagram*>(mSettings->mBuf);
+    const uint64_t lead = static_cast<uint64_t>(mSettings->mTxTimeLead) * 1000ULL;
+    double delay_target = get_delay_target();
+    double launch = static_cast<double>(TxTimeNow());
+    int currLen;
+
+    if (apply_first_udppkt_delay) {
+	//the case when a UDP first packet went out in SendFirstPayload
+	launch += delay_target;
+    }
+    while (InProgress()) {
+	uint64_t now_ns = TxTimeNow();
+	now.setnow();
+	udp_vary_load(delay_target);
+	// Behind by more than the window, e.g. the thread was descheduled,
+	// restart the schedule rather than bursting to catch up
+	if ((launch + lead) < now_ns) {
+	    launch = now_ns;
+	} else if (launch > (now_ns + lead)) {
+	    TxTimeWait(static_cast<uint64_t>(launch) - (lead / 2));
+	}
+	uint64_t launch_ns = static_cast<uint64_t>(launch);
+	int64_t launch_rt = static_cast<int64_t>(launch_ns) + txt_offset;
+	reportstruct->packetTime.tv_sec = static_cast<long>(launch_rt / 1000000000LL);
+	reportstruct->packetTime.tv_usec = static_cast<long>((launch_rt % 1000000000LL) / 1000);
+	reportstruct->sentTime = reportstruct->packetTime;
+	// store datagram ID into buffer
+	WritePacketID(reportstruct->packetID);
+	mBuf_UDP->tv_sec  = htonl(reportstruct->packetTime.tv_sec);
+	mBuf_UDP->tv_usec = htonl(reportstruct->packetTime.tv_usec);
+
+	reportstruct->errwrite = WriteNoErr;
+	reportstruct->emptyreport = 0;
+	// perform write
+	if (isModeAmount(mSettings)) {
+	    currLen = TxTimeSend(mySocket, mSettings->mBuf, (mSettings->mAmount < static_cast<unsigned>(mSettings->mBufLen)) ? mSettings->mAmount : mSettings->mBufLen, launch_ns);
+	} else {
+	    currLen = TxTimeSend(mySocket, mSettings->mBuf, mSettings->mBufLen, launch_ns);
+	}
+	if (currLen < 0) {
+	    reportstruct->packetID--;
+	    if (FATALUDPWRITERR(errno)) {
+	        reportstruct->errwrite = WriteErrFatal;
+	        WARN_errno(1, "write");
+		break;
+	    } else {
+	        reportstruct->errwrite = WriteErrAccount;
+	        currLen = 0;
+	    }
+	    reportstruct->emptyreport = 1;
+	} else {
+	    launch += delay_target;
+	    // a sender which never gets ahead of the window never waits
+	    if (txt_stamping && ((txt_sendid & 0x3F) == 0))
+		TxTimeReap(0);
+	}
+
+	if (isModeAmount(mSettings)) {
+	    /* mAmount may be unsigned, so don't let it underflow! */
+	    if (mSettings->mAmount >= static_cast<unsigned long>(currLen)) {
+	        mSettings->mAmount -= static_cast<unsigned long>(currLen);
+	    } else {
+	        mSettings->mAmount = 0;
+	    }
+	}
+
+	// report packets
+	reportstruct->packetLen = static_cast<unsigned long>(currLen);
+	reportstruct->prevPacketTime = myReport->info.ts.prevpacketTime;
+	myReportPacket();
+	reportstruct->packetID++;
+	myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+    }
+    FinishTrafficActions();
+}
+#endif
+
 /*
  * UDP isochronous send loop
  */
@@ -1152,6 +2668,16 @@ void Client::RunUDPIsochronous () {
 	frameid =  framecounter->wait_tick();
 	udp_payload->isoch.frameid  = htonl(frameid);
 	lastPacketTime.setnow();
+#if HAVE_SO_TXTIME
+	// --txtime, the frame is queued at once and the kernel spaces its
+	// datagrams by the ipg rather than a delay loop per datagram
+	uint64_t launch = 0;
+	if (txt_launch) {
+	    launch = TxTimeNow();
+	    if (txt_stamping)
+		TxTimeReap(0);
+	}
+#endif
 	if (!initdone) {
 	    initdone = 1;
 	    udp_payload->isoch.start_tv_sec = htonl(framecounter->getSecs());
@@ -1159,6 +2685,12 @@ void Client::RunUDPIsochronous () {
 	}
 	while ((bytecnt > 0) && InProgress()) {
 	    t1.setnow();
+#if HAVE_SO_TXTIME
+	    if (txt_launch) {
+		int64_t launch_rt = static_cast<int64_t>(launch) + txt_offset;
+		t1.set(static_cast<long>(launch_rt / 1000000000LL), static_cast<long>((launch_rt % 1000000000LL) / 1000));
+	    }
+#endif
 	    reportstruct->packetTime.tv_sec = t1.getSecs();
 	    reportstruct->packetTime.tv_usec = t1.getUsecs();
 	    reportstruct->sentTime = reportstruct->packetTime;
@@ -1198,15 +2730,23 @@ void Client::RunUDPIsochronous () {
 	    reportstruct->emptyreport = 0;
 
 	    // perform write
+	    int writelen;
 	    if (isModeAmount(mSettings) && (mSettings->mAmount < static_cast<unsigned>(mSettings->mBufLen))) {
 	        udp_payload->isoch.remaining = htonl(mSettings->mAmount);
 		reportstruct->remaining=mSettings->mAmount;
-	        currLen = write(mySocket, mSettings->mBuf, mSettings->mAmount);
+	        writelen = mSettings->mAmount;
 	    } else {
 	        udp_payload->isoch.remaining = htonl(bytecnt);
 		reportstruct->remaining=bytecnt;
-	        currLen = write(mySocket, mSettings->mBuf, (bytecnt < mSettings->mBufLen) ? bytecnt : mSettings->mBufLen);
+	        writelen = (bytecnt < mSettings->mBufLen) ? bytecnt : mSettings->mBufLen;
 	    }
+#if HAVE_SO_TXTIME
+	    if (txt_launch) {
+		currLen = TxTimeSend(mySocket, mSettings->mBuf, writelen, launch);
+		launch += static_cast<uint64_t>(delay_target);
+	    } else
+#endif
+	    currLen = sendUDP(mySocket, mSettings->mBuf, writelen);
 
 	    if (currLen < 0) {
 	        reportstruct->packetID--;
@@ -1250,7 +2790,7 @@ void Client::RunUDPIsochronous () {
 	    myReport->info.ts.prevpacketTime = reportstruct->packetTime;
 	    // Insert delay here only if the running delay is greater than 1 usec,
 	    // otherwise don't delay and immediately continue with the next tx.
-	    if (delay >= 1000) {
+	    if ((delay >= 1000) && !txt_launch) {
 		// Convert from nanoseconds to microseconds
 		// and invoke the microsecond delay
 		delay_loop(static_cast<unsigned long>(delay / 1000));
@@ -1262,7 +2802,11 @@ void Client::RunUDPIsochronous () {
 // end RunUDPIsoch
 
 inline void Client::WritePacketID (intmax_t packetID) {
-    struct UDP_datagram * mBuf_UDP = reinterpret_cast<struct UDP_datagram *>(mSettings->mBuf);
+    WritePacketID(mSettings->mBuf, packetID);
+}
+
+inline void Client::WritePacketID (char *buf, intmax_t packetID) {
+    struct UDP_datagram * mBuf_UDP = reinterpret_cast<struct UDP_datagram *>(buf);
     // store datagram ID into buffer
 #ifdef HAVE_INT64_T
     // Pack signed 64bit packetID into unsigned 32bit id1 + unsigned
@@ -1280,7 +2824,7 @@ inline void Client::WritePacketID (intmax_t packetID) {
 	   packetID, packetID, id1, id2);
 #endif
 #else
-    mBuf_UDP->id = htonl((reportstruct->packetID));
+    mBuf_UDP->id = htonl(packetID);
 #endif
 }
 
@@ -1325,6 +2869,10 @@ inline bool Client::InProgress (void) {
     // Read the next data block from
     // the file if it's file input
     if (isFileInput(mSettings)) {
+	if (tls_sendfile || file_sendfile)
+	    return (!(sInterupted || peerclose) && (sendfile_offset < sendfile_size));
+	if (file_splice)
+	    return !(sInterupted || peerclose);
 	Extractor_getNextDataBlock(readAt, mSettings);
         return Extractor_canRead(mSettings) != 0;
     }
@@ -1370,8 +2918,47 @@ inline void Client::tcp_shutdown (void) {
  */
 void Client::FinishTrafficActions () {
     disarm_itimer();
+    if (tls_coalesce_fill > 0) {
+	TLSWriteAll(tls_coalesce_buf, tls_coalesce_fill);
+	tls_coalesce_fill = 0;
+    }
+#if HAVE_MSG_ZEROCOPY
+    if (zc_pool) {
+	// account for every completion before the final report, the
+	// final UDP datagrams below are regular copy writes
+	ZeroCopyDrain();
+	ZeroCopyFree();
+    }
+#endif
+#if HAVE_SO_TXTIME
+    if (txt_launch) {
+	// the deviations of the tail ride on the final datagram's report
+	TxTimeDrain();
+	TxTimeFree();
+    }
+#endif
+#if HAVE_AF_XDP
+    if (xdp) {
+	// the frames go out ahead of the final datagrams on the socket
+	xdpsock_tx_drain(xdp, XDPSOCK_DRAINMS);
+	xdpsock_free(xdp);
+	xdp = NULL;
+    }
+#endif
     // Shutdown the TCP socket's writes as the event for the server to end its traffic loop
     if (!isUDP(mSettings)) {
+	// counts from after the last write, e.g. the drained zerocopy completions
+	// or the flushed coalesce records, the shutdown's null event clears them
+	if (!one_report && (reportstruct->tlsrecords || reportstruct->zc_zerocopy || reportstruct->zc_copied)) {
+	    now.setnow();
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+	    reportstruct->packetLen = 0;
+	    reportstruct->writecnt = 0;
+	    reportstruct->emptyreport = 0;
+	    reportstruct->errwrite = WriteNoErr;
+	    myReportPacket();
+	}
 	tcp_shutdown();
 	now.setnow();
 	reportstruct->packetTime.tv_sec = now.getSecs();
@@ -1398,7 +2985,7 @@ void Client::FinishTrafficActions () {
 	struct UDP_datagram * mBuf_UDP = reinterpret_cast<struct UDP_datagram *>(mSettings->mBuf);
 	mBuf_UDP->tv_sec = htonl(reportstruct->packetTime.tv_sec);
 	mBuf_UDP->tv_usec = htonl(reportstruct->packetTime.tv_usec);
-	int len = write(mySocket, mSettings->mBuf, mSettings->mBufLen);
+	int len = sendUDP(mySocket, mSettings->mBuf, mSettings->mBufLen);
 #ifdef HAVE_THREAD_DEBUG
 	thread_debug("UDP client sent final packet per negative seqno %ld", -reportstruct->packetID);
 #endif
@@ -1445,6 +3032,9 @@ void Client::AwaitServerFinPacket () {
     struct timeval timeout;
     int ack_success = 0;
     int count = RETRYCOUNT;
+    // SSL_read() keeps reading until a data record so bound its wait
+    if (conn != 0)
+	SetSocketOptionsReceiveTimeout(mSettings, RETRYTIMER);
     while (--count >= 0) {
         // wait until the socket is readable, or our timeout expires
         FD_ZERO(&readSet);
@@ -1458,7 +3048,7 @@ void Client::AwaitServerFinPacket () {
 	    // try to trigger another FIN by resending a negative seq no
 	    WritePacketID(-(++reportstruct->packetID));
 	    // write data
-	    rc = write(mySocket, mSettings->mBuf, mSettings->mBufLen);
+	    rc = sendUDP(mySocket, mSettings->mBuf, mSettings->mBufLen);
 	    WARN_errno(rc < 0, "write-fin");
 #ifdef HAVE_THREAD_DEBUG
 	    thread_debug("UDP client retransmit final packet per negative seqno %ld", -reportstruct->packetID);
@@ -1467,7 +3057,13 @@ void Client::AwaitServerFinPacket () {
             // socket ready to read, this packet size
 	    // is set by the server.  Assume it's large enough
 	    // to contain the final server packet
-	    rc = read(mySocket, mSettings->mBuf, MAXUDPBUF);
+	    if (conn != 0) {
+		// a DTLS handshake or alert record reads as zero bytes of data
+		if ((rc = SSL_read(conn, mSettings->mBuf, MAXUDPBUF)) <= 0)
+		    continue;
+	    } else {
+		rc = read(mySocket, mSettings->mBuf, MAXUDPBUF);
+	    }
 
 	    // dump any 2.0.13 client acks sent at the start of traffic
 	    if (rc == sizeof(client_hdr_ack)) {
@@ -1537,7 +3133,7 @@ void Client::AwaitServerCloseEvent () {
 
 int Client::SendFirstPayload () {
     int pktlen = 0;
-    if (!isConnectOnly(mSettings)) {
+    if (!isConnectOnly(mSettings) || isSSL(mSettings)) {
 	if (myReport && !TimeZero(myReport->info.ts.startTime) && !(mSettings->mMode == kTest_TradeOff)) {
 	    reportstruct->packetTime = myReport->info.ts.startTime;
 	} else {
@@ -63,6 +63,7 @@
 #include "active_hosts.h"
 #include "SocketAddr.h"
 #include "delay.h"
+#include "iouring.h"
 
 static int fullduplex_startstop_barrier (struct BarrierMutex *barrier) {
     int rc = 0;
@@ -166,6 +167,495 @@ void server_spawn(struct thread_Settings *thread) {
     DELETE_PTR(theServer);
 }
 
+#if HAVE_LISTEN_SHARDS
+/*
+ * listener_shards_init adds the --listen-shards copies of each port's
+ * listener, they bind in shard order per the port's gate so the shard
+ * index is also the socket's index in the SO_REUSEPORT group
+ */
+void listener_shards_init(struct thread_Settings *listener) {
+    struct thread_Settings *itr = listener;
+    while (itr != NULL) {
+	struct thread_Settings *portnext = itr->runNow;
+	struct BarrierMutex *gate = new struct BarrierMutex;
+	memset(gate, 0, sizeof(struct BarrierMutex));
+	Condition_Initialize(&gate->await);
+	itr->mListenShard = 0;
+	itr->mListenShardGate = gate;
+	for (int ix = 1; ix < listener->mListenShards; ix++) {
+	    struct thread_Settings *next = NULL;
+	    Settings_Copy(itr, &next, 1);
+	    if (next != NULL) {
+		setNoSettReport(next);
+		next->mThreadMode = kMode_Listener;
+		next->mListenShard = ix;
+		itr->runNow = next;
+		itr = next;
+	    }
+	}
+	itr->runNow = portnext;
+	itr = portnext;
+    }
+}
+#endif
+
+#if HAVE_WORKER_POOL
+/*
+ * --worker-pool, a fixed set of server worker threads where each runs
+ * an epoll loop over many accepted TCP sockets, rather than a thread
+ * per socket. Every stream keeps its own Server object, settings and
+ * reports so the per stream and sum reports are as before.
+ */
+#define WORKEREVENTS 64
+struct PooledStream {
+    struct thread_Settings *settings;
+    Server *server;
+    struct PooledStream *next;
+    struct PooledStream *prev;
+#if HAVE_IO_URING
+    // --io-uring, the stream's receive on the worker's ring and its
+    // registered file slot (-1 for none)
+    bool armed;
+    bool closing;
+    int fileslot;
+#endif
+};
+
+struct ServerWorker {
+    int epfd;
+    int wakefd;
+    // the listener hands streams over through the pending list
+    Mutex lock;
+    struct PooledStream *pending;
+    int count;                      // pending and running streams
+    bool done;
+    // the streams this worker drives, only touched by the worker
+    struct PooledStream *streams;
+#if HAVE_IO_URING
+    // --io-uring, one ring for all of the worker's streams and the free
+    // registered file slots
+    struct iouring *ring;
+    int *fileslots;
+    int nfileslots;
+#endif
+};
+
+static struct ServerWorker *server_workers = NULL;
+static int server_workers_num = 0;
+static int server_workers_listeners = 0;
+static bool server_workers_stopping = false;
+static Mutex server_workers_lock;
+
+/*
+ * server_workers_init creates the worker threads before any listener
+ * runs, one listener per port shares the pool
+ */
+void server_workers_init(struct thread_Settings *listener) {
+    Mutex_Initialize(&server_workers_lock);
+    for (struct thread_Settings *itr = listener; itr != NULL; itr = itr->runNow)
+	server_workers_listeners++;
+    server_workers = new struct ServerWorker[listener->mWorkers];
+    for (int ix = 0; ix < listener->mWorkers; ix++) {
+	struct ServerWorker *worker = &server_workers[ix];
+	memset(worker, 0, sizeof(struct ServerWorker));
+	worker->epfd = epoll_create1(EPOLL_CLOEXEC);
+	worker->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if ((worker->epfd < 0) || (worker->wakefd < 0)) {
+	    WARN_errno(1, "epoll worker, using a thread per connection");
+	    break;
+	}
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	int rc = epoll_ctl(worker->epfd, EPOLL_CTL_ADD, worker->wakefd, &ev);
+	FAIL_errno(rc < 0, "epoll_ctl wake", listener);
+	Mutex_Initialize(&worker->lock);
+	struct thread_Settings *thread = NULL;
+	Settings_Copy(listener, &thread, 0);
+	FAIL(!thread, "Failed memory allocation for worker settings", listener);
+	thread->mThreadMode = kMode_ServerWorker;
+	thread->mWorker = worker;
+	thread->runNow = NULL;
+	thread->runNext = NULL;
+	server_workers_num++;
+	thread_start(thread);
+    }
+}
+
+/*
+ * server_worker_dispatch gives an accepted stream to the least loaded
+ * worker. Returns false if there are no workers, the caller then
+ * starts a server thread.
+ */
+bool server_worker_dispatch(struct thread_Settings *server) {
+    struct ServerWorker *worker = NULL;
+    int least = 0;
+    for (int ix = 0; ix < server_workers_num; ix++) {
+	Mutex_Lock(&server_workers[ix].lock);
+	if (!server_workers[ix].done && (!worker || (server_workers[ix].count < least))) {
+	    worker = &server_workers[ix];
+	    least = worker->count;
+	}
+	Mutex_Unlock(&server_workers[ix].lock);
+    }
+    if (!worker)
+	return false;
+    Mutex_Lock(&worker->lock);
+    if (worker->done) {
+	// lost the race with the worker's exit
+	Mutex_Unlock(&worker->lock);
+	return false;
+    }
+    struct PooledStream *stream = new struct PooledStream;
+    stream->settings = server;
+    stream->server = NULL;
+    stream->prev = NULL;
+    stream->next = worker->pending;
+    worker->pending = stream;
+    worker->count++;
+    thread_pooled_start(server);
+    eventfd_write(worker->wakefd, 1);
+    Mutex_Unlock(&worker->lock);
+#ifdef HAVE_THREAD_DEBUG
+    thread_debug("Dispatch server settings=%p sock=%d to worker %p (streams=%d)", (void *)server, server->mSock, (void *)worker, least + 1);
+#endif
+    return true;
+}
+
+// The workers test this under their own lock, server_workers_stop()
+// never holds both so the order can't deadlock
+static bool server_workers_isstopping (void) {
+    Mutex_Lock(&server_workers_lock);
+    bool stopping = server_workers_stopping;
+    Mutex_Unlock(&server_workers_lock);
+    return stopping;
+}
+
+/*
+ * server_workers_stop is called per exiting listener, the last one
+ * lets the workers exit once their streams are done
+ */
+void server_workers_stop(void) {
+    Mutex_Lock(&server_workers_lock);
+    if (--server_workers_listeners == 0)
+	server_workers_stopping = true;
+    bool stopping = server_workers_stopping;
+    Mutex_Unlock(&server_workers_lock);
+    if (stopping) {
+	for (int ix = 0; ix < server_workers_num; ix++) {
+	    Mutex_Lock(&server_workers[ix].lock);
+	    if (!server_workers[ix].done)
+		eventfd_write(server_workers[ix].wakefd, 1);
+	    Mutex_Unlock(&server_workers[ix].lock);
+	}
+    }
+}
+
+static void server_worker_finish (struct ServerWorker *worker, struct PooledStream *stream) {
+#if HAVE_IO_URING
+    if (worker->ring) {
+	if (stream->fileslot >= 0) {
+	    iouring_update_file(worker->ring, stream->fileslot, -1);
+	    worker->fileslots[worker->nfileslots++] = stream->fileslot;
+	}
+    } else
+#endif
+    epoll_ctl(worker->epfd, EPOLL_CTL_DEL, stream->settings->mSock, NULL);
+    stream->server->FinishTCP();
+    DELETE_PTR(stream->server);
+    if (stream->prev)
+	stream->prev->next = stream->next;
+    else
+	worker->streams = stream->next;
+    if (stream->next)
+	stream->next->prev = stream->prev;
+    Mutex_Lock(&worker->lock);
+    worker->count--;
+    Mutex_Unlock(&worker->lock);
+    thread_pooled_stop(stream->settings);
+    DELETE_PTR(stream);
+}
+
+#if HAVE_IO_URING
+/*
+ * --io-uring with --worker-pool, all of a worker's sockets share one
+ * ring and one io_uring_enter() per pass submits the receives and reaps
+ * the reads of every stream. Each stream has one receive in flight into
+ * its own buffer, rather than a multishot one on shared provided buffers,
+ * so a busy stream can't take the buffers of the others.
+ */
+#define WORKERURINGWAKE   0ULL
+#define WORKERURINGCANCEL ~0ULL
+
+// Returns false if the kernel can't, the worker then runs the epoll loop
+static bool server_worker_uring_init (struct ServerWorker *worker, struct thread_Settings *thread) {
+    unsigned count = 1;
+    while (count < static_cast<unsigned>(thread->mIOUringDepth))
+	count <<= 1;
+    struct iouring *ring = iouring_init(count);
+    if (!ring) {
+	WARN_errno(1, "io_uring_setup, using epoll");
+	return false;
+    }
+    if (!ring->ext_arg) {
+	fprintf(stderr, "WARN: io_uring timed waits not supported by the kernel, using epoll\n");
+	iouring_free(ring);
+	return false;
+    }
+    // a sparse table, the array is then reused as the stack of free slots
+    int *slots = new int[WORKERURINGFILES];
+    for (int ix = 0; ix < WORKERURINGFILES; ix++)
+	slots[ix] = -1;
+    if (iouring_register_files(ring, slots, WORKERURINGFILES) == 0) {
+	for (int ix = 0; ix < WORKERURINGFILES; ix++)
+	    slots[ix] = WORKERURINGFILES - 1 - ix;
+	worker->nfileslots = WORKERURINGFILES;
+	worker->fileslots = slots;
+    } else {
+	DELETE_ARRAY(slots);
+    }
+    worker->ring = ring;
+    return true;
+}
+
+static void server_worker_uring_free (struct ServerWorker *worker) {
+    iouring_free(worker->ring);
+    worker->ring = NULL;
+    DELETE_ARRAY(worker->fileslots);
+}
+
+static struct io_uring_sqe *server_worker_uring_sqe (struct ServerWorker *worker) {
+    struct io_uring_sqe *sqe = iouring_get_sqe(worker->ring);
+    if (!sqe) {
+	// the submission queue is full, hand it to the kernel now
+	iouring_submit(worker->ring, 0, 0);
+	sqe = iouring_get_sqe(worker->ring);
+    }
+    return sqe;
+}
+
+static void server_worker_uring_arm (struct ServerWorker *worker, struct PooledStream *stream) {
+    struct io_uring_sqe *sqe = server_worker_uring_sqe(worker);
+    if (!sqe)
+	return;
+    sqe->opcode = IORING_OP_RECV;
+    if (stream->fileslot >= 0) {
+	sqe->fd = stream->fileslot;
+	sqe->flags = IOSQE_FIXED_FILE;
+    } else {
+	sqe->fd = stream->settings->mSock;
+    }
+    sqe->addr = reinterpret_cast<unsigned long>(stream->settings->mBuf);
+    sqe->len = stream->settings->mBufLen;
+    sqe->user_data = reinterpret_cast<unsigned long>(stream);
+    stream->armed = true;
+}
+
+// the listener's handovers and the stop wake the worker through the eventfd
+static void server_worker_uring_wake (struct ServerWorker *worker) {
+    struct io_uring_sqe *sqe = server_worker_uring_sqe(worker);
+    if (!sqe)
+	return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = worker->wakefd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = WORKERURINGWAKE;
+}
+
+// A stream's receive has to be off the ring before its Server goes, i.e.
+// an armed one is cancelled and finished on its last completion
+static void server_worker_uring_close (struct ServerWorker *worker, struct PooledStream *stream) {
+    if (!stream->armed) {
+	server_worker_finish(worker, stream);
+    } else if (!stream->closing) {
+	struct io_uring_sqe *sqe = server_worker_uring_sqe(worker);
+	if (!sqe)
+	    return;
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->addr = reinterpret_cast<unsigned long>(stream);
+	sqe->user_data = WORKERURINGCANCEL;
+	stream->closing = true;
+    }
+}
+#endif
+
+static void server_worker_start (struct ServerWorker *worker, struct PooledStream *stream) {
+    stream->server = new Server(stream->settings);
+    stream->prev = NULL;
+    stream->next = worker->streams;
+    if (worker->streams)
+	worker->streams->prev = stream;
+    worker->streams = stream;
+#if HAVE_IO_URING
+    if (worker->ring) {
+	stream->armed = false;
+	stream->closing = false;
+	stream->fileslot = -1;
+	if (worker->nfileslots > 0) {
+	    int slot = worker->fileslots[--worker->nfileslots];
+	    if (iouring_update_file(worker->ring, slot, stream->settings->mSock) == 1)
+		stream->fileslot = slot;
+	    else
+		worker->fileslots[worker->nfileslots++] = slot;
+	}
+	if (stream->server->PollStart())
+	    server_worker_uring_arm(worker, stream);
+	else
+	    server_worker_finish(worker, stream);
+	return;
+    }
+#endif
+    // a stream which failed its setup or is already done never gets polled
+    if (!stream->server->PollStart()) {
+	server_worker_finish(worker, stream);
+	return;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.ptr = stream;
+    int rc = epoll_ctl(worker->epfd, EPOLL_CTL_ADD, stream->settings->mSock, &ev);
+    WARN_errno(rc < 0, "epoll_ctl add");
+    if (rc < 0)
+	server_worker_finish(worker, stream);
+}
+
+#if HAVE_IO_URING
+// The ring version of server_worker_spawn()'s loop
+static void server_worker_uring_run (struct ServerWorker *worker) {
+    struct iouring *ring = worker->ring;
+    Timestamp lasttick;
+    server_worker_uring_wake(worker);
+    while (true) {
+	Mutex_Lock(&worker->lock);
+	struct PooledStream *adopt = worker->pending;
+	worker->pending = NULL;
+	if (!adopt && !worker->streams && (sInterupted || server_workers_isstopping())) {
+	    worker->done = true;
+	    close(worker->wakefd);
+	    close(worker->epfd);
+	    Mutex_Unlock(&worker->lock);
+	    break;
+	}
+	Mutex_Unlock(&worker->lock);
+	while (adopt) {
+	    struct PooledStream *next = adopt->next;
+	    server_worker_start(worker, adopt);
+	    adopt = next;
+	}
+	// the next receive of the streams read on the last pass
+	for (struct PooledStream *stream = worker->streams; stream; stream = stream->next) {
+	    if (!stream->armed && !stream->closing)
+		server_worker_uring_arm(worker, stream);
+	}
+	int rc = iouring_submit(ring, 1, WORKERTICKMSEC * 1000);
+	if ((rc < 0) && (rc != -ETIME) && (rc != -EINTR) && (rc != -EAGAIN) && (rc != -EBUSY)) {
+	    errno = -rc;
+	    WARN_errno(1, "io_uring_enter");
+	}
+	struct io_uring_cqe *cqe;
+	while ((cqe = iouring_peek_cqe(ring)) != NULL) {
+	    unsigned long long tag = cqe->user_data;
+	    int res = cqe->res;
+	    iouring_cqe_seen(ring);
+	    if (tag == WORKERURINGCANCEL)
+		continue;
+	    if (tag == WORKERURINGWAKE) {
+		eventfd_t value;
+		eventfd_read(worker->wakefd, &value);
+		server_worker_uring_wake(worker);
+		continue;
+	    }
+	    struct PooledStream *stream = reinterpret_cast<struct PooledStream *>(tag);
+	    stream->armed = false;
+	    if (stream->closing) {
+		server_worker_finish(worker, stream);
+	    } else if (!stream->server->UringRecv(res)) {
+		server_worker_uring_close(worker, stream);
+	    }
+	}
+	Timestamp now;
+	if ((rc == -ETIME) || (now.subUsec(lasttick) >= (WORKERTICKMSEC * 1000))) {
+	    struct PooledStream *stream = worker->streams;
+	    while (stream) {
+		struct PooledStream *next = stream->next;
+		if (!stream->closing && !stream->server->PollTick())
+		    server_worker_uring_close(worker, stream);
+		stream = next;
+	    }
+	    lasttick = now;
+	}
+    }
+    server_worker_uring_free(worker);
+}
+#endif
+
+/*
+ * server_worker_spawn is the worker's loop, it adopts the streams the
+ * listener hands over and reads whichever sockets are ready. The epoll
+ * wait is bounded because signals go to the main thread, and idle
+ * streams still need their interval reports and end of test checks.
+ */
+void server_worker_spawn(struct thread_Settings *thread) {
+    struct ServerWorker *worker = static_cast<struct ServerWorker *>(thread->mWorker);
+    struct epoll_event events[WORKEREVENTS];
+#if HAVE_SCHED_SETSCHEDULER
+    thread_setscheduler(thread);
+#endif
+    Timestamp lasttick;
+#if HAVE_IO_URING
+    if (isIOUring(thread) && server_worker_uring_init(worker, thread)) {
+	server_worker_uring_run(worker);
+	return;
+    }
+#endif
+    while (true) {
+	Mutex_Lock(&worker->lock);
+	struct PooledStream *adopt = worker->pending;
+	worker->pending = NULL;
+	if (!adopt && !worker->streams && (sInterupted || server_workers_isstopping())) {
+	    // the fds are closed under the lock, see dispatch and stop
+	    worker->done = true;
+	    close(worker->wakefd);
+	    close(worker->epfd);
+	    Mutex_Unlock(&worker->lock);
+	    break;
+	}
+	Mutex_Unlock(&worker->lock);
+	while (adopt) {
+	    struct PooledStream *next = adopt->next;
+	    server_worker_start(worker, adopt);
+	    adopt = next;
+	}
+	int n = epoll_wait(worker->epfd, events, WORKEREVENTS, WORKERTICKMSEC);
+	if ((n < 0) && (errno != EINTR)) {
+	    WARN_errno(1, "epoll_wait");
+	}
+	for (int ix = 0; ix < n; ix++) {
+	    struct PooledStream *stream = static_cast<struct PooledStream *>(events[ix].data.ptr);
+	    if (!stream) {
+		eventfd_t value;
+		eventfd_read(worker->wakefd, &value);
+	    } else if (!stream->server->PollRead()) {
+		server_worker_finish(worker, stream);
+	    }
+	}
+	Timestamp now;
+	if ((n <= 0) || (now.subUsec(lasttick) >= (WORKERTICKMSEC * 1000))) {
+	    struct PooledStream *stream = worker->streams;
+	    while (stream) {
+		struct PooledStream *next = stream->next;
+		if (!stream->server->PollTick())
+		    server_worker_finish(worker, stream);
+		stream = next;
+	    }
+	    lasttick = now;
+	}
+    }
+}
+#endif
+
 static void clientside_client_basic (struct thread_Settings *thread, Client *theClient) {
     setTransferID(thread, 0);
     SockAddr_remoteAddr(thread);
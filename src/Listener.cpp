@@ -83,6 +83,9 @@
 #include "SocketAddr.h"
 #include "payloads.h"
 #include "delay.h"
+#if HAVE_LISTEN_SHARDS
+#include <sched.h>
+#endif
 
 /* -------------------------------------------------------------------
 
@@ -92,6 +95,9 @@
 Listener::Listener (thread_Settings *inSettings) {
     mClients = inSettings->mThreads;
     ListenSocket = INVALID_SOCKET;
+#if HAVE_LISTEN_SHARDS
+    shard_cpu = -1;
+#endif
     /*
      * These thread settings are stored in three places
      *
@@ -137,6 +143,11 @@ void Listener::Run () {
     if (mSettings->clientListener) {
 	SockAddr_remoteAddr(mSettings);
     }
+#if HAVE_LISTEN_SHARDS
+    // the server threads inherit the shard's cpu affinity
+    if (isListenShards(mSettings))
+	shard_cpu = ShardAffinity();
+#endif
     if (!isUDP(mSettings)) {
 	// TCP needs just one listen
 	my_listen(); // This will set ListenSocket to a new sock fd
@@ -259,10 +270,7 @@ void Listener::Run () {
 	    (!isIPV6(mSettings) && SockAddr_isIPv6(&server->peer))) {
 	    // Not allowed, reset things and restart the loop
 	    // Don't forget to delete the UDP entry (inserted in my_accept)
-	    Iperf_remove_host(server);
-	    if (DecrSumReportRefCounter(server->mSumReport) <= 0) {
-		FreeSumReport(server->mSumReport);
-	    }
+	    Iperf_remove_unused_host(server);
 	    if (!isUDP(server))
 	        close(server->mSock);
 	    assert(server != mSettings);
@@ -290,10 +298,7 @@ void Listener::Run () {
 		assert(reporthdr);
 		PostReport(reporthdr);
 	    }
-	    Iperf_remove_host(server);
-	    if (DecrSumReportRefCounter(server->mSumReport) <= 0) {
-		FreeSumReport(server->mSumReport);
-	    }
+	    Iperf_remove_unused_host(server);
 	    close(server->mSock);
 	    assert(server != mSettings);
 	    Settings_Destroy(server);
@@ -304,10 +309,7 @@ void Listener::Run () {
 	if (isUDP(server)){
 	    if (!isCompat(mSettings) && !isTapDev(mSettings) && (isL2LengthCheck(mSettings) || isL2LengthCheck(server)) && !L2_setup(server, server->mSock)) {
 		// Requested L2 testing but L2 setup failed
-		Iperf_remove_host(server);
-		if (DecrSumReportRefCounter(server->mSumReport) <= 0) {
-		    FreeSumReport(server->mSumReport);
-		}
+		Iperf_remove_unused_host(server);
 		assert(server != mSettings);
 		Settings_Destroy(server);
 		continue;
@@ -379,9 +381,23 @@ void Listener::Run () {
 	    assert(reporthdr);
 	    PostReport(reporthdr);
 	}
+#if HAVE_WORKER_POOL
+	// --worker-pool, a worker's epoll loop drives the plain TCP receive
+	// streams, the others need the blocking reads of their own thread
+	if (isWorkerPool(server) && !isUDP(server) && (server->runNow == NULL) && (server->runNext == NULL) && \
+	    !isSSL(server) && !isIsochronous(server) && !isPeriodicBurst(server) && !isTripTime(server) && \
+	    !isBounceBack(server) && !isServerReverse(server) && !isReverse(server) && !isFullDuplex(server) && \
+	    !isBWSet(server) && !isTxStartTime(server) && \
+	    server_worker_dispatch(server))
+	    continue;
+#endif
 	// Now start the server side traffic threads
 	thread_start_all(server);
     }
+#if HAVE_WORKER_POOL
+    if (isWorkerPool(mSettings))
+	server_workers_stop();
+#endif
 #ifdef HAVE_THREAD_DEBUG
     thread_debug("Listener exiting port/sig/threads %d/%d/%d", mSettings->mPort, sInterupted, mCount);
 #endif
@@ -451,6 +467,16 @@ void Listener::my_listen () {
 	} else
 #endif
 	    {
+#if HAVE_LISTEN_SHARDS
+		if (isListenShards(mSettings)) {
+		    // take this shard's turn, see listener_shards_init
+		    Condition_Lock(mSettings->mListenShardGate->await);
+		    while (mSettings->mListenShardGate->count != mSettings->mListenShard)
+			Condition_Wait(&mSettings->mListenShardGate->await);
+		    Condition_Unlock(mSettings->mListenShardGate->await);
+		    ShardListenOptions();
+		}
+#endif
 		rc = bind(ListenSocket, reinterpret_cast<sockaddr*>(&mSettings->local), mSettings->size_local);
 		FAIL_errno(rc == SOCKET_ERROR, "listener bind", mSettings);
 	    }
@@ -474,6 +500,16 @@ void Listener::my_listen () {
 	    rc = listen(ListenSocket, INT_MAX);
 	}
 	WARN_errno(rc == SOCKET_ERROR, "listen");
+#if HAVE_LISTEN_SHARDS
+	if (isListenShards(mSettings)) {
+	    ShardSteering();
+	    // in the SO_REUSEPORT group, let the next shard go
+	    Condition_Lock(mSettings->mListenShardGate->await);
+	    mSettings->mListenShardGate->count++;
+	    Condition_Broadcast(&mSettings->mListenShardGate->await);
+	    Condition_Unlock(mSettings->mListenShardGate->await);
+	}
+#endif
     } else {
 #ifndef WIN32
 	// if UDP and multicast, join the group
@@ -488,6 +524,89 @@ void Listener::my_listen () {
     }
 } // end my_listen()
 
+#if HAVE_LISTEN_SHARDS
+/* -------------------------------------------------------------------
+ * --listen-shards, pin this shard to the shard index'th cpu of the
+ * process's affinity mask (wrapping when there are more shards than
+ * cpus). Returns the cpu or -1.
+ * ------------------------------------------------------------------- */
+int Listener::ShardAffinity () {
+    int cpu = -1;
+#if HAVE_DECL_CPU_SET
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+	WARN_errno(1, "sched_getaffinity");
+	return -1;
+    }
+    int nth = mSettings->mListenShard % CPU_COUNT(&allowed);
+    for (int ix = 0; ix < CPU_SETSIZE; ix++) {
+	if (CPU_ISSET(ix, &allowed) && (nth-- == 0)) {
+	    cpu = ix;
+	    break;
+	}
+    }
+    cpu_set_t myset;
+    CPU_ZERO(&myset);
+    CPU_SET(cpu, &myset);
+    if (sched_setaffinity(0, sizeof(myset), &myset) != 0) {
+	WARN_errno(1, "listener shard affinity");
+	cpu = -1;
+    }
+#endif
+#ifdef HAVE_THREAD_DEBUG
+    thread_debug("Listener shard %d on port %d pinned to cpu %d", mSettings->mListenShard, mSettings->mPort, cpu);
+#endif
+    return cpu;
+}
+
+/* -------------------------------------------------------------------
+ * --listen-shards socket options, set prior to the bind. The kernel
+ * prefers the group's socket whose SO_INCOMING_CPU matches the cpu
+ * handling the SYN (linux 6.1 and later), i.e. the shard pinned to it.
+ * ------------------------------------------------------------------- */
+void Listener::ShardListenOptions () {
+    int boolean = 1;
+    int rc = setsockopt(ListenSocket, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<char*>(&boolean), sizeof(boolean));
+    FAIL_errno(rc == SOCKET_ERROR, "setsockopt SO_REUSEPORT", mSettings);
+#ifdef SO_INCOMING_CPU
+    if (shard_cpu >= 0) {
+	rc = setsockopt(ListenSocket, SOL_SOCKET, SO_INCOMING_CPU, reinterpret_cast<char*>(&shard_cpu), sizeof(shard_cpu));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_INCOMING_CPU");
+    }
+#endif
+}
+
+/* -------------------------------------------------------------------
+ * When the shards sit on cpus 0..N-1 the last shard to join the group
+ * attaches a cBPF program that picks the socket index per the cpu
+ * handling the SYN, which also steers kernels prior to 6.1.
+ * ------------------------------------------------------------------- */
+void Listener::ShardSteering () {
+#if defined(SO_ATTACH_REUSEPORT_CBPF) && defined(SKF_AD_CPU)
+    // the index'th allowed cpu equals the index only when cpus 0..index are all allowed
+    if ((mSettings->mListenShard == (mSettings->mListenShards - 1)) && (shard_cpu == mSettings->mListenShard)) {
+	struct sock_filter code[] = {
+	    // A = the current cpu
+	    { BPF_LD  | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+	    // A = A % shards
+	    { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(mSettings->mListenShards) },
+	    // the socket index in the group
+	    { BPF_RET | BPF_A, 0, 0, 0 }
+	};
+	struct sock_fprog prog;
+	prog.len = sizeof(code) / sizeof(code[0]);
+	prog.filter = code;
+	int rc = setsockopt(ListenSocket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, reinterpret_cast<char*>(&prog), sizeof(prog));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_ATTACH_REUSEPORT_CBPF");
+#ifdef HAVE_THREAD_DEBUG
+	thread_debug("Listener shards on port %d cBPF steering rc=%d", mSettings->mPort, rc);
+#endif
+    }
+#endif
+}
+#endif
+
 /* -------------------------------------------------------------------
  * Joins the multicast group or source and group (SSM S,G)
  *
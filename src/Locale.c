@@ -69,16 +69,21 @@ Usage: iperf [-s|-c host] [options]\n\
        iperf [-h|--help] [-v|--version]\n\
 \n\
 Client/Server:\n\
+      --af-xdp[=#]         send or receive the UDP datagrams with an AF_XDP socket on interface queue # (default 0), IPv4 only\n\
   -b, --bandwidth #[kmgKMG | pps]  bandwidth to read/send at in bits/sec or packets/sec\n\
+      --cpu-stats[=cycles] report per thread cpu utilization and cpu cost per byte, optionally with cpu cycles\n\
   -e, --enhanced    use enhanced reporting giving more tcp/udp and traffic information\n\
   -f, --format    [kmgKMG]   format to report: Kbits, Mbits, KBytes, MBytes\n\
       --hide-ips           hide ip addresses and host names within outputs\n\
   -i, --interval  #        seconds between periodic bandwidth reports\n\
+      --io-uring[=#]       use the io_uring TCP traffic engine with # operations in flight (default 32)\n\
   -l, --len       #[kmKM]    length of buffer in bytes to read or write (Defaults: TCP=128K, v4 UDP=1470, v6 UDP=1450)\n\
   -m, --print_mss          print TCP maximum segment size (MTU - TCP/IP header)\n\
   -o, --output    <filename> output the report or error message to this specified file\n\
   -p, --port      #        client/server port to listen/send on and to connect\n\
       --permit-key         permit key to be used to verify client and server (TCP only)\n\
+      --reporter-stats     print the packet ring depth and reporter wakeups per stream\n\
+      --reporter-threads[=#] drain the traffic threads' packet rings from # reporter threads (default one per cpu)\n\
       --sum-only           output sum only reports\n\
   -u, --udp                use UDP rather than TCP\n\
   -w, --window    #[KM]    TCP window size (socket buffer size)\n"
@@ -91,18 +96,35 @@ Client/Server:\n\
   -N, --nodelay            set TCP no delay, disabling Nagle's Algorithm\n\
   -S, --tos       #        set the socket's IP_TOS (byte) field\n\
   -Z, --tcp-congestion <algo>  set TCP congestion control algorithm (Linux only)\n\
-  -E, --tls       #        use TLS 'v1.2' or 'v1.3'\n\
+  -E, --tls       #        use TLS 'v1.2' or 'v1.3', DTLS with -u\n\
+      --tls-async[=#]      use async TLS crypto offload with optional max records (pipelines) in flight\n\
+      --tls-cert <file>    TLS certificate (PEM), default newreq.pem\n\
+      --tls-ciphers <list> TLS 1.2 cipher list, e.g. ECDHE-RSA-AES256-GCM-SHA384:ECDHE-RSA-CHACHA20-POLY1305\n\
+      --tls-ciphersuites <list> TLS 1.3 ciphersuites, e.g. TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256\n\
+      --tls-coalesce[=#]   coalesce writes into full TLS records of # bytes (default 16384) before encryption\n\
+      --tls-engine <id|none|auto> TLS crypto engine, auto (default) uses qatengine if available, else the OpenSSL default provider\n\
+      --tls-groups <list>  TLS key exchange groups (curves), e.g. X25519:P-256\n\
+      --tls-handshake <full|id|ticket|0rtt> TLS handshake type, e.g. with --connect-only for handshake rates\n\
+      --tls-key <file>     TLS private key (PEM), default key.pem\n\
+      --tls-rekey [#[kmgKMG|s]] client rotates the TLS keys every # bytes or #s seconds (key update v1.3, renegotiate v1.2), a bare --tls-rekey lets a server permit v1.2 client renegotiation\n\
+      --ktls               use kernel TLS (kTLS) records after the handshake, implies -E v1.2 if not already set\n\
 \n\
 Server specific:\n\
   -p, --port      #[-#]    server port(s) to listen on/connect to\n\
   -s, --server             run in server mode\n\
   -1, --singleclient       run one server at a time\n\
+      --busy-poll[=#]      spin # usecs on non-blocking reads before a blocking read, also sets SO_BUSY_POLL (default 50)\n\
       --histograms         enable latency histograms\n\
+      --listen-shards[=#]  accept TCP on # SO_REUSEPORT listeners pinned one per cpu (default one per cpu)\n\
+      --null-sink          discard TCP reads with splice() to /dev/null, no copy to userspace\n\
       --permit-key-timeout set the timeout for a permit key in seconds\n\
       --tcp-rx-window-clamp set the TCP receive window clamp size in bytes\n\
       --tap-dev   #[<dev>] use TAP device to receive at L2 layer\n\
   -t, --time      #        time in seconds to listen for new connections as well as to receive traffic (default not set)\n\
+      --udp-batch[=#]      read up to # UDP datagrams per recvmmsg() call (default 32)\n\
+      --udp-gro            enable UDP GRO on the batched reads, coalesced datagrams are split per the gso size\n\
       --udp-histogram #,#  enable UDP latency histogram(s) with bin width and count, e.g. 1,1000=1(ms),1000(bins)\n\
+      --worker-pool[=#]    serve TCP connections from # epoll (or with --io-uring, io_uring) worker threads (default one per cpu)\n\
   -B, --bind <ip>[%<dev>]  bind to multicast address and optional device\n\
   -U, --single_udp         run in single threaded UDP mode\n\
       --sum-dstip          sum traffic threads based upon destination ip address (default is src ip)\n\
@@ -133,11 +155,18 @@ Client specific:\n\
       --no-udp-fin         No final server to client stats at end of UDP test\n\
   -n, --num       #[kmgKMG]    number of bytes to transmit (instead of -t)\n\
   -r, --tradeoff           Do a fullduplexectional test individually\n\
+      --sendfile           send the -F/-I input with sendfile() or splice(), no copy through userspace\n\
       --tcp-write-prefetch set the socket's TCP_NOTSENT_LOWAT value in bytes and use event based writes\n\
   -t, --time      #        time in seconds to transmit for (default 10 secs)\n\
+      --tls-cipher-sweep <c1,c2,...> run the test once per TLS cipher (per the -E version) and print a throughput/cpu table\n\
+      --tls-engine-ab      run the test with and without the TLS crypto engine and print the throughput and cpu cost deltas\n\
       --trip-times         enable end to end measurements (requires client and server clock sync)\n\
       --txdelay-time       time in seconds to hold back after connect and before first write\n\
       --txstart-time       unix epoch time to schedule first write and start traffic\n\
+      --txtime[=#]         UDP pacing by SO_TXTIME launch times queued # usecs ahead (default 2000), -e reports the deviation\n\
+      --udp-batch[=#]      send # UDP datagrams per sendmmsg() call (default 32)\n\
+      --udp-gso            send the UDP batch as one UDP_SEGMENT (GSO) super-packet\n\
+      --zerocopy           send with MSG_ZEROCOPY from a buffer pool and report the zerocopy/copied completions\n\
   -B, --bind [<ip> | <ip:port>] bind ip (and optional port) from which to source traffic\n\
   -F, --fileinput <name>   input the data to be transmitted from a file\n\
   -H, --ssm-host <ip>      set the SSM source, use with -B for (S,G) \n\
@@ -532,6 +561,34 @@ const char report_l2statistics[] =
 const char report_sum_outoforder[] =
 "[SUM] " IPERFTimeFrmt " sec  %d datagrams received out-of-order\n";
 
+/* the counter set lines, e.g. --cpu-stats, the text is one of the below */
+const char report_counters[] =
+"%s" IPERFTimeFrmt " sec  %s\n";
+
+const char report_sumcnt_counters[] =
+"[SUM-%d] " IPERFTimeFrmt " sec  %s\n";
+
+const char report_sum_counters[] =
+"[SUM] " IPERFTimeFrmt " sec  %s\n";
+
+const char report_cpustats[] =
+"CPU %.1f%% (usr/sys %.1f%%/%.1f%%)  %.3f ns/byte  %s cycles/byte";
+
+const char report_tlsrecords[] =
+"TLS %d records  %.0f records/sec  avg record %.0f bytes";
+
+const char report_zerocopy[] =
+"zerocopy %d completions  %d copied  (%.1f%% zerocopy)";
+
+const char report_txtime[] =
+"txtime %d stamps  deviation avg/max %.3f/%.3f ms  %d missed";
+
+const char report_busypoll[] =
+"busy-poll spin %.3f ms (%.1f%% cpu)  sleep %.3f ms  %jd/%jd reads spun/slept";
+
+const char report_tlsrekeys[] =
+"TLS %d rekeys  stall %.3f ms  (avg %.3f ms)";
+
 const char report_peer [] =
 "%slocal %s port %u connected with %s port %u%s\n";
 
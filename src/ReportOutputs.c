@@ -142,6 +142,115 @@ static inline void _output_outoforder(struct TransferInfo *stats) {
     }
 }
 
+/*
+ * The counter sets, e.g. --cpu-stats or --zerocopy, print a line per flow,
+ * [SUM-n] and [SUM] that differ only in the prefix. A set formats its
+ * fields of the interval into text and returns false when there's
+ * nothing to report, _output_counters() then prints the line
+ */
+enum CounterLine {
+    kCounters_Flow = 0,
+    kCounters_SumCnt,
+    kCounters_Sum
+};
+typedef bool (*counter_set) (struct TransferInfo *stats, char *text, size_t len);
+static inline void _output_counters (struct TransferInfo *stats, counter_set set, enum CounterLine line) {
+    char text[160];
+    if (!set(stats, text, sizeof(text)))
+	return;
+    switch (line) {
+    case kCounters_SumCnt:
+	printf(report_sumcnt_counters, stats->threadcnt, stats->ts.iStart, stats->ts.iEnd, text);
+	break;
+    case kCounters_Sum:
+	printf(report_sum_counters, stats->ts.iStart, stats->ts.iEnd, text);
+	break;
+    case kCounters_Flow:
+    default:
+	printf(report_counters, stats->common->transferIDStr, stats->ts.iStart, stats->ts.iEnd, text);
+	break;
+    }
+}
+
+// Per thread cpu usage (--cpu-stats), the percentages are relative to one
+// cpu so sums of multiple traffic threads can exceed 100%
+static bool set_cpustats (struct TransferInfo *stats, char *text, size_t len) {
+    double interval = stats->ts.iEnd - stats->ts.iStart;
+    if (!stats->isEnableCPUStats || (interval < SMALLEST_INTERVAL_SEC))
+	return false;
+    struct reportstruct_cpustats *cnt = &stats->cpustats.cnt;
+    char cyclesperbyte[40];
+    if (stats->cpustats.hasCycles && (stats->cntBytes > 0)) {
+	snprintf(cyclesperbyte, sizeof(cyclesperbyte), "%.2f", (double) cnt->cycles / (double) stats->cntBytes);
+    } else {
+	strcpy(cyclesperbyte, "NA");
+    }
+    snprintf(text, len, report_cpustats,
+	     100.0 * (double) cnt->cputime / (interval * 1e9),
+	     100.0 * (double) cnt->utime / (interval * 1e6),
+	     100.0 * (double) cnt->stime / (interval * 1e6),
+	     (stats->cntBytes > 0) ? ((double) cnt->cputime / (double) stats->cntBytes) : 0.0,
+	     cyclesperbyte);
+    return true;
+}
+
+// --busy-poll, the spin is the cpu cost of the mode, relative to one cpu
+static bool set_busypoll (struct TransferInfo *stats, char *text, size_t len) {
+    double interval = stats->ts.iEnd - stats->ts.iStart;
+    struct reportstruct_busypoll *cnt = &stats->busypoll.cnt;
+    if (!isBusyPoll(stats->common) || (interval < SMALLEST_INTERVAL_SEC) || !(cnt->spun || cnt->slept))
+	return false;
+    snprintf(text, len, report_busypoll, cnt->spin_ns / 1e6, 100.0 * (double) cnt->spin_ns / (interval * 1e9),
+	     cnt->sleep_ns / 1e6, cnt->spun, cnt->slept);
+    return true;
+}
+
+// TLS records written, the average record size is from the bytes written
+// in the report so with --tls-coalesce it lags by up to one staged write
+static bool set_tlsrecords (struct TransferInfo *stats, char *text, size_t len) {
+    double interval = stats->ts.iEnd - stats->ts.iStart;
+    int records = stats->sock_callstats.write.TLSRecords;
+    if (!isSSL(stats->common) || (records <= 0) || (interval < SMALLEST_INTERVAL_SEC))
+	return false;
+    snprintf(text, len, report_tlsrecords, records, (double) records / interval,
+	     (double) stats->cntBytes / (double) records);
+    return true;
+}
+
+// --zerocopy completions, the kernel falls back to copying, e.g. for a
+// device without scatter-gather or for loopback, and flags those as copied
+static bool set_zerocopy (struct TransferInfo *stats, char *text, size_t len) {
+    int zerocopy = stats->sock_callstats.write.ZCZeroCopy;
+    int completions = zerocopy + stats->sock_callstats.write.ZCCopied;
+    if (!isZeroCopy(stats->common) || (completions <= 0))
+	return false;
+    snprintf(text, len, report_zerocopy, completions, stats->sock_callstats.write.ZCCopied,
+	     100.0 * zerocopy / completions);
+    return true;
+}
+
+// --txtime, the deviation of the tx timestamps from the requested launch
+// times, positive is late, and the datagrams the qdisc dropped as missed
+static bool set_txtime (struct TransferInfo *stats, char *text, size_t len) {
+    if (!isTxTime(stats->common) || !(stats->sock_callstats.write.TxTStamps || stats->sock_callstats.write.TxTMissed))
+	return false;
+    snprintf(text, len, report_txtime, stats->sock_callstats.write.TxTStamps,
+	     (stats->sock_callstats.write.TxTStamps ? (stats->sock_callstats.write.TxTDev / stats->sock_callstats.write.TxTStamps) : 0.0),
+	     stats->sock_callstats.write.TxTDevMax, stats->sock_callstats.write.TxTMissed);
+    return true;
+}
+
+// --tls-rekey with -e, only the intervals with a key rotation get the line, which
+// marks them, and the stall is the time the writer was held in the rotation
+static bool set_tlsrekeys (struct TransferInfo *stats, char *text, size_t len) {
+    int rekeys = stats->sock_callstats.write.TLSRekeys;
+    if (!isTLSRekey(stats->common) || !isEnhanced(stats->common) || (rekeys <= 0))
+	return false;
+    double stall = stats->sock_callstats.write.TLSRekeyStall * 1e3;
+    snprintf(text, len, report_tlsrekeys, rekeys, stall, stall / rekeys);
+    return true;
+}
+
 //
 //  Little's law is L = lambda * W, where L is queue depth,
 //  lambda the arrival rate and W is the processing time
@@ -227,6 +336,8 @@ void tcp_output_read_enhanced (struct TransferInfo *stats) {
 	   stats->sock_callstats.read.bins[5],
 	   stats->sock_callstats.read.bins[6],
 	   stats->sock_callstats.read.bins[7]);
+    _output_counters(stats, set_cpustats, kCounters_Flow);
+    _output_counters(stats, set_busypoll, kCounters_Flow);
     fflush(stdout);
 }
 void tcp_output_read_enhanced_triptime (struct TransferInfo *stats) {
@@ -283,6 +394,8 @@ void tcp_output_read_enhanced_triptime (struct TransferInfo *stats) {
     if (stats->framelatency_histogram) {
 	histogram_print(stats->framelatency_histogram, stats->ts.iStart, stats->ts.iEnd);
     }
+    _output_counters(stats, set_cpustats, kCounters_Flow);
+    _output_counters(stats, set_busypoll, kCounters_Flow);
     fflush(stdout);
 }
 void tcp_output_frame_read (struct TransferInfo *stats) {
@@ -389,6 +502,10 @@ void tcp_output_write_enhanced (struct TransferInfo *stats) {
 	histogram_print(stats->latency_histogram, stats->ts.iStart, stats->ts.iEnd);
     }
 #endif
+    _output_counters(stats, set_tlsrecords, kCounters_Flow);
+    _output_counters(stats, set_tlsrekeys, kCounters_Flow);
+    _output_counters(stats, set_zerocopy, kCounters_Flow);
+    _output_counters(stats, set_cpustats, kCounters_Flow);
     fflush(stdout);
 }
 
@@ -449,6 +566,10 @@ void tcp_output_write_enhanced_drain (struct TransferInfo *stats) {
     if (stats->drain_histogram) {
 	histogram_print(stats->drain_histogram, stats->ts.iStart, stats->ts.iEnd);
     }
+    _output_counters(stats, set_tlsrecords, kCounters_Flow);
+    _output_counters(stats, set_tlsrekeys, kCounters_Flow);
+    _output_counters(stats, set_zerocopy, kCounters_Flow);
+    _output_counters(stats, set_cpustats, kCounters_Flow);
     fflush(stdout);
 }
 #endif
@@ -492,6 +613,10 @@ void tcp_output_write_enhanced_isoch (struct TransferInfo *stats) {
 	histogram_print(stats->latency_histogram, stats->ts.iStart, stats->ts.iEnd);
     }
 #endif
+    _output_counters(stats, set_tlsrecords, kCounters_Flow);
+    _output_counters(stats, set_tlsrekeys, kCounters_Flow);
+    _output_counters(stats, set_zerocopy, kCounters_Flow);
+    _output_counters(stats, set_cpustats, kCounters_Flow);
     fflush(stdout);
 }
 
@@ -573,6 +698,7 @@ void udp_output_read_enhanced (struct TransferInfo *stats) {
 	histogram_print(stats->latency_histogram, stats->ts.iStart, stats->ts.iEnd);
     }
     _output_outoforder(stats);
+    _output_counters(stats, set_busypoll, kCounters_Flow);
     fflush(stdout);
 }
 
@@ -619,6 +745,7 @@ void udp_output_read_enhanced_triptime (struct TransferInfo *stats) {
 	histogram_print(stats->latency_histogram, stats->ts.iStart, stats->ts.iEnd);
     }
     _output_outoforder(stats);
+    _output_counters(stats, set_busypoll, kCounters_Flow);
     fflush(stdout);
 }
 void udp_output_read_enhanced_triptime_isoch (struct TransferInfo *stats) {
@@ -672,6 +799,7 @@ void udp_output_read_enhanced_triptime_isoch (struct TransferInfo *stats) {
 	histogram_print(stats->framelatency_histogram, stats->ts.iStart, stats->ts.iEnd);
     }
     _output_outoforder(stats);
+    _output_counters(stats, set_busypoll, kCounters_Flow);
     fflush(stdout);
 }
 void udp_output_write (struct TransferInfo *stats) {
@@ -692,6 +820,8 @@ void udp_output_write_enhanced (struct TransferInfo *stats) {
 	   stats->sock_callstats.write.WriteCnt,
 	   stats->sock_callstats.write.WriteErr,
 	   (stats->cntIPG ? (stats->cntIPG / stats->IPGsum) : 0.0));
+    _output_counters(stats, set_zerocopy, kCounters_Flow);
+    _output_counters(stats, set_txtime, kCounters_Flow);
     fflush(stdout);
 }
 void udp_output_write_enhanced_isoch (struct TransferInfo *stats) {
@@ -704,6 +834,8 @@ void udp_output_write_enhanced_isoch (struct TransferInfo *stats) {
 	   stats->sock_callstats.write.WriteErr,
 	   (stats->cntIPG ? (stats->cntIPG / stats->IPGsum) : 0.0),
 	   stats->isochstats.cntFrames, stats->isochstats.cntFramesMissed, stats->isochstats.cntSlips);
+    _output_counters(stats, set_zerocopy, kCounters_Flow);
+    _output_counters(stats, set_txtime, kCounters_Flow);
     fflush(stdout);
 }
 
@@ -779,6 +911,7 @@ void udp_output_sumcnt_read_enhanced (struct TransferInfo *stats) {
 		   stats->ts.iEnd, stats->cntOutofOrder);
 	}
     }
+    _output_counters(stats, set_busypoll, kCounters_SumCnt);
     fflush(stdout);
 }
 
@@ -805,6 +938,7 @@ void udp_output_sum_read_enhanced (struct TransferInfo *stats) {
 	    outbuffer, outbufferext,
 	    stats->cntError, stats->cntDatagrams,
 	    (stats->cntIPG ? (stats->cntIPG / stats->IPGsum) : 0.0));
+    _output_counters(stats, set_busypoll, kCounters_Sum);
     fflush(stdout);
 }
 void udp_output_sum_write_enhanced (struct TransferInfo *stats) {
@@ -816,6 +950,8 @@ void udp_output_sum_write_enhanced (struct TransferInfo *stats) {
 	    stats->sock_callstats.write.WriteCnt,
 	    stats->sock_callstats.write.WriteErr,
 	   ((stats->cntIPG && (stats->IPGsum > 0.0)) ? (stats->cntIPG / stats->IPGsum) : 0.0));
+    _output_counters(stats, set_zerocopy, kCounters_Sum);
+    _output_counters(stats, set_txtime, kCounters_Sum);
     fflush(stdout);
 }
 void udp_output_sumcnt_write_enhanced (struct TransferInfo *stats) {
@@ -827,6 +963,8 @@ void udp_output_sumcnt_write_enhanced (struct TransferInfo *stats) {
 	    stats->sock_callstats.write.WriteCnt,
 	    stats->sock_callstats.write.WriteErr,
 	   ((stats->cntIPG && (stats->IPGsum > 0.0)) ? (stats->cntIPG / stats->IPGsum) : 0.0));
+    _output_counters(stats, set_zerocopy, kCounters_SumCnt);
+    _output_counters(stats, set_txtime, kCounters_SumCnt);
     fflush(stdout);
 }
 
@@ -853,6 +991,8 @@ void tcp_output_sum_read_enhanced (struct TransferInfo *stats) {
 	   stats->sock_callstats.read.bins[5],
 	   stats->sock_callstats.read.bins[6],
 	   stats->sock_callstats.read.bins[7]);
+    _output_counters(stats, set_cpustats, kCounters_Sum);
+    _output_counters(stats, set_busypoll, kCounters_Sum);
     fflush(stdout);
 }
 void tcp_output_sumcnt_read (struct TransferInfo *stats) {
@@ -878,6 +1018,8 @@ void tcp_output_sumcnt_read_enhanced (struct TransferInfo *stats) {
 	   stats->sock_callstats.read.bins[5],
 	   stats->sock_callstats.read.bins[6],
 	   stats->sock_callstats.read.bins[7]);
+    _output_counters(stats, set_cpustats, kCounters_SumCnt);
+    _output_counters(stats, set_busypoll, kCounters_SumCnt);
     fflush(stdout);
 }
 
@@ -909,6 +1051,10 @@ void tcp_output_sum_write_enhanced (struct TransferInfo *stats) {
 	   ,stats->sock_callstats.write.TCPretry
 #endif
     );
+    _output_counters(stats, set_tlsrecords, kCounters_Sum);
+    _output_counters(stats, set_tlsrekeys, kCounters_Sum);
+    _output_counters(stats, set_zerocopy, kCounters_Sum);
+    _output_counters(stats, set_cpustats, kCounters_Sum);
     fflush(stdout);
 }
 void tcp_output_sumcnt_write_enhanced (struct TransferInfo *stats) {
@@ -923,6 +1069,10 @@ void tcp_output_sumcnt_write_enhanced (struct TransferInfo *stats) {
 	   ,stats->sock_callstats.write.TCPretry
 #endif
     );
+    _output_counters(stats, set_tlsrecords, kCounters_SumCnt);
+    _output_counters(stats, set_tlsrekeys, kCounters_SumCnt);
+    _output_counters(stats, set_zerocopy, kCounters_SumCnt);
+    _output_counters(stats, set_cpustats, kCounters_SumCnt);
     fflush(stdout);
 }
 
@@ -1115,9 +1265,43 @@ static void reporter_output_listener_settings (struct ReportSettings *report) {
     if (isOverrideTOS(report->common)) {
 	fprintf(stdout, "Reflected TOS will be set to 0x%x\n", report->common->RTOS);
     }
+    if (isTLSAsync(report->common)) {
+	fprintf(stdout, "TLS async offload mode (max pipelines %d)\n", \
+		((report->common->TLSPipelines > 1) ? report->common->TLSPipelines : 1));
+    }
+    if (isKTLS(report->common)) {
+	fprintf(stdout, "TLS kernel offload (kTLS) requested\n");
+    }
     if (report->common->TOS) {
 	fprintf(stdout, "TOS will be set to 0x%x\n", report->common->TOS);
     }
+    if (isUDPBatch(report->common)) {
+	fprintf(stdout, "UDP batched reads of up to %d %s per recvmmsg()\n", report->common->UDPBatch, \
+		(isUDPGRO(report->common) ? "GRO reads" : "datagrams"));
+    }
+    if (isIOUring(report->common) && isWorkerPool(report->common)) {
+	fprintf(stdout, "TCP reads via one io_uring per worker thread\n");
+    } else if (isIOUring(report->common)) {
+	fprintf(stdout, "TCP reads via io_uring multishot receive (%d provided buffers)\n", report->common->IOUringDepth);
+    }
+    if (isListenShards(report->common)) {
+	fprintf(stdout, "TCP accepts sharded across %d SO_REUSEPORT listeners pinned per cpu\n", report->common->ListenShards);
+    }
+    if (isWorkerPool(report->common)) {
+	fprintf(stdout, "TCP connections served by %d epoll worker threads\n", report->common->Workers);
+    }
+    if (isBusyPoll(report->common)) {
+	fprintf(stdout, "Reads spin up to %d usecs on the socket before blocking (SO_BUSY_POLL)\n", report->common->BusyPoll);
+    }
+    if (isAFXDP(report->common)) {
+	fprintf(stdout, "UDP reads via an AF_XDP socket on queue %d (generic mode)\n", report->common->XdpQueue);
+    }
+    if (isReporterThreads(report->common)) {
+	fprintf(stdout, "Packet rings drained by %d reporter threads\n", report->common->ReporterThreads);
+    }
+    if (isNullSink(report->common)) {
+	fprintf(stdout, "TCP reads discarded by splice() to /dev/null\n");
+    }
     if (isUDP(report->common)) {
 	if (isSingleClient(report->common)) {
 	    fprintf(stdout, "WARN: Suggested to use lower case -u instead of -U (to avoid serialize & bypass of reporter thread)\n");
@@ -1201,6 +1385,29 @@ static void reporter_output_client_settings (struct ReportSettings *report) {
     if (isCongestionControl(report->common) && report->common->Congestion) {
 	fprintf(stdout, "TCP congestion control set to %s\n", report->common->Congestion);
     }
+    if (isTLSAsync(report->common)) {
+	fprintf(stdout, "TLS async offload mode (max pipelines %d)\n", \
+		((report->common->TLSPipelines > 1) ? report->common->TLSPipelines : 1));
+    }
+    if (isKTLS(report->common)) {
+	fprintf(stdout, "TLS kernel offload (kTLS) requested\n");
+    }
+    if (isIOUring(report->common)) {
+	fprintf(stdout, "TCP writes via io_uring (%d in flight%s)\n", report->common->IOUringDepth, \
+		(isZeroCopy(report->common) ? ", SEND_ZC" : ""));
+    }
+    if (isSendfile(report->common)) {
+	fprintf(stdout, "TCP writes via %s from the input file\n", (isSTDIN(report->common) ? "splice()" : "sendfile()"));
+    }
+    if (isTxTime(report->common)) {
+	fprintf(stdout, "UDP paced by SO_TXTIME launch times queued up to %d usecs ahead\n", report->common->TxTimeLead);
+    }
+    if (isAFXDP(report->common)) {
+	fprintf(stdout, "UDP writes via an AF_XDP socket on queue %d (generic mode)\n", report->common->XdpQueue);
+    }
+    if (isReporterThreads(report->common)) {
+	fprintf(stdout, "Packet rings drained by %d reporter threads\n", report->common->ReporterThreads);
+    }
     if (isNearCongest(report->common)) {
 	if (report->common->rtt_weight == NEARCONGEST_DEFAULT) {
 	    fprintf(stdout, "TCP near-congestion delay weight set to %2.4f (use --near-congestion=<value> to change)\n", report->common->rtt_weight);
@@ -1219,6 +1426,10 @@ static void reporter_output_client_settings (struct ReportSettings *report) {
 #else
         printf(client_datagram_size, report->common->BufLen, report->common->pktIPG);
 #endif
+	if (isUDPBatch(report->common)) {
+	    fprintf(stdout, "UDP batched writes of %d datagrams per %s\n", report->common->UDPBatch, \
+		    (isUDPGSO(report->common) ? "GSO send" : "sendmmsg()"));
+	}
     }
     if (isConnectOnly(report->common)) {
 	fprintf(stdout, "TCP three-way-handshake (3WHS) only\n");
@@ -1238,6 +1449,16 @@ static void reporter_output_client_settings (struct ReportSettings *report) {
     fflush(stdout);
 }
 
+// --reporter-stats, ring depth is per consumer pass, wakeups are the ones this traffic thread sent
+void reporter_print_ring_stats (struct ReporterData *data) {
+    if (data->packetring && data->ringdepth_samples) {
+	fprintf(stdout, "[%3d] packet ring depth (avg/max) = %.1f/%d of %d, reporter wakeups (ring/interval) = %d/%d, suspends = %d\n", \
+		data->info.common->transferID, ((double) data->ringdepth_sum / data->ringdepth_samples), \
+		data->ringdepth_max, (int) (data->packetring->mask + 1), data->wakeups_ring, \
+		data->wakeups_interval, data->reporter_thread_suspends);
+    }
+}
+
 void reporter_connect_printf_tcp_final (struct ConnectionInfo * report) {
     if (report->connect_times.cnt > 1) {
         double variance = (report->connect_times.cnt < 2) ? 0 : sqrt(report->connect_times.m2 / (report->connect_times.cnt - 1));
@@ -1248,6 +1469,18 @@ void reporter_connect_printf_tcp_final (struct ConnectionInfo * report) {
 		(report->connect_times.cnt + report->connect_times.err), \
 		report->connect_times.err);
     }
+    if (report->tlshandshake_times.cnt > 1) {
+        double variance = sqrt(report->tlshandshake_times.m2 / (report->tlshandshake_times.cnt - 1));
+	double span = report->tlshandshake_last - report->tlshandshake_first;
+        fprintf(stdout, "[ HS] final tls handshake times (min/avg/max/stdev) = %0.3f/%0.3f/%0.3f/%0.3f ms (tot/resumed/0-rtt) = %d/%d/%d\n", \
+		report->tlshandshake_times.min,  \
+	        (report->tlshandshake_times.sum / report->tlshandshake_times.cnt), \
+		report->tlshandshake_times.max, variance,  \
+		report->tlshandshake_times.cnt, report->tlsresumed_cnt, report->tlsearlydata_cnt);
+	if (isConnectOnly(report->common) && (span > 0)) {
+	    fprintf(stdout, "[ HS] tls handshake rate = %0.1f handshakes/sec\n", (report->tlshandshake_times.cnt / span));
+	}
+    }
     fflush(stdout);
 }
 
@@ -1358,7 +1591,16 @@ void reporter_print_connection_report (struct ConnectionInfo *report) {
 		char now_timebuf[80];
 		strftime(now_timebuf, sizeof(now_timebuf), "%Y-%m-%d %H:%M:%S (%Z)", &ts);
 		if (!isUDP(report->common) && (report->common->ThreadMode == kMode_Client)) {
-		    snprintf(b, SNBUFFERSIZE-strlen(b), " (ct=%4.2f ms) on %s", report->connecttime, now_timebuf);
+		    if (report->tlshandshaketime > 0) {
+			snprintf(b, SNBUFFERSIZE-strlen(b), " (ct=%4.2f ms, hs=%4.2f ms%s%s%s) on %s", report->connecttime, report->tlshandshaketime, \
+				 ((report->tlshandshakeflags & TLSHS_RESUMED) ? " resumed" : ""), \
+				 ((report->tlshandshakeflags & TLSHS_EARLYDATA) ? " 0-rtt" : ""), \
+				 ((report->tlshandshakeflags & TLSHS_KTLS_TX) ? " ktls" : ""), now_timebuf);
+		    } else {
+			snprintf(b, SNBUFFERSIZE-strlen(b), " (ct=%4.2f ms) on %s", report->connecttime, now_timebuf);
+		    }
+		} else if (isUDP(report->common) && (report->tlshandshaketime > 0)) {
+		    snprintf(b, SNBUFFERSIZE-strlen(b), " (dtls hs=%4.2f ms) on %s", report->tlshandshaketime, now_timebuf);
 		} else {
 		    snprintf(b, SNBUFFERSIZE-strlen(b), " on %s", now_timebuf);
 		}
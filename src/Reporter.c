@@ -49,7 +49,9 @@
  *
  * Major rewrite by Robert McMahon (Sept 2020, ver 2.0.14)
  * ________________________________________________________________ */
-
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <math.h>
 #include "headers.h"
 #include "Settings.hpp"
@@ -64,6 +66,11 @@
 #include "packet_ring.h"
 #include "payloads.h"
 #include "gettcpinfo.h"
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -76,6 +83,7 @@ extern "C" {
 struct ReportHeader *ReportRoot = NULL;
 struct ReportHeader *ReportPendingHead = NULL;
 struct ReportHeader *ReportPendingTail = NULL;
+struct FinalTally reporter_final_tally = {0, 0.0};
 
 // Reporter's reset of stats after a print occurs
 static void reporter_reset_transfer_stats_client_tcp(struct TransferInfo *stats);
@@ -84,10 +92,17 @@ static void reporter_reset_transfer_stats_server_udp(struct TransferInfo *stats)
 static void reporter_reset_transfer_stats_server_tcp(struct TransferInfo *stats);
 
 static void reporter_mmm_update (struct MeanMinMaxStats *stats, double value);
+static void reporter_fullduplex_interval_report(struct ReporterData *data);
+static void reporter_sum_interval_report(struct ReporterData *data);
 
 #if HAVE_TCP_STATS
 static inline void reporter_handle_packet_tcpistats(struct ReporterData *data, struct ReportStruct *packet);
 #endif
+static inline void reporter_handle_packet_cpustats(struct ReporterData *data, struct ReportStruct *packet);
+#if HAVE_REPORTER_WAKEUP
+static void reporter_wakeup_check(struct ReporterData *data, struct ReportStruct *packet);
+#endif
+static bool reporter_jobq_ready(void *arg);
 static struct ConnectionInfo *myConnectionReport;
 
 void PostReport (struct ReportHeader *reporthdr) {
@@ -122,6 +137,118 @@ void PostReport (struct ReportHeader *reporthdr) {
 #endif
     }
 }
+/*
+ * Sample the cpu usage of the calling thread, i.e. this must be
+ * called from the traffic thread and never the reporter thread
+ */
+static inline void sample_cpustats (struct CPUStats *cpu, struct reportstruct_cpustats *sample) {
+    sample->isValid = true;
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec t1;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1) == 0) {
+	sample->cputime = ((intmax_t) t1.tv_sec * 1000000000) + t1.tv_nsec;
+    }
+#endif
+#if defined(RUSAGE_THREAD)
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+	sample->utime = ((intmax_t) ru.ru_utime.tv_sec * 1000000) + ru.ru_utime.tv_usec;
+	sample->stime = ((intmax_t) ru.ru_stime.tv_sec * 1000000) + ru.ru_stime.tv_usec;
+    }
+#endif
+    if (cpu->hasCycles) {
+	uint64_t cycles;
+	if (read(cpu->cycles_fd, &cycles, sizeof(cycles)) == sizeof(cycles)) {
+	    sample->cycles = (intmax_t) cycles;
+	}
+    }
+}
+
+/*
+ * InitCPUStats is called by a traffic thread after its report start time
+ * is set. It takes the baseline sample and opens the optional per thread
+ * cycle counter. Later samples are taken by ReportPacket at the interval
+ * boundaries and by EndJob for the final report.
+ */
+void InitCPUStats (struct ReporterData *data) {
+    assert(data != NULL);
+    struct TransferInfo *stats = &data->info;
+    stats->isEnableCPUStats = true;
+    stats->cpustats.cycles_fd = -1;
+    stats->cpustats.hasCycles = false;
+#if defined(__linux__) && defined(__NR_perf_event_open)
+    if (isCPUCycles(stats->common)) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.exclude_hv = 1;
+	// pid 0 and cpu -1 counts this thread only, on any cpu
+	int fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if ((fd < 0) && ((errno == EACCES) || (errno == EPERM))) {
+	    // perf_event_paranoid may only allow user space counting
+	    attr.exclude_kernel = 1;
+	    fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+	if (fd < 0) {
+	    WARN_errno(1, "cpu cycles counter");
+	} else {
+	    stats->cpustats.cycles_fd = fd;
+	    stats->cpustats.hasCycles = true;
+	}
+    }
+#endif
+    sample_cpustats(&stats->cpustats, &stats->cpustats.start);
+    stats->cpustats.prev = stats->cpustats.start;
+    stats->cpustats.current = stats->cpustats.start;
+    stats->ts.nextCPUSampleTime = stats->ts.nextTime;
+}
+
+/*
+ * Returns true when the packet was folded into the traffic thread's
+ * aggregate. Otherwise a pending aggregate is enqueued so the caller's
+ * packet follows it in time order. Interval crossings go through the
+ * ring as is so the reporter's interval output isn't delayed, as do
+ * empty reports, zero length reads (e.g. the peer's close), write
+ * errors and the final packet.
+ */
+static inline bool reporter_aggregate_packet (struct ReporterData *data, struct ReportStruct *packet) {
+    struct ReportAggregate *agg = data->aggregate;
+    struct TransferInfo *stats = &data->info;
+    bool crossing = false;
+    if (!TimeZero(stats->ts.intervalTime)) {
+	if (TimeZero(agg->nextTime))
+	    agg->nextTime = stats->ts.nextTime;
+	if (TimeDifference(agg->nextTime, packet->packetTime) < 0) {
+	    crossing = true;
+	    while (TimeDifference(agg->nextTime, packet->packetTime) < 0) {
+		TimeAdd(agg->nextTime, stats->ts.intervalTime);
+	    }
+	}
+    }
+    if (!crossing && !(packet->packetID < 0) && !packet->emptyreport && (packet->packetLen > 0) && \
+	(packet->errwrite == WriteNoErr)) {
+	// the server's read accounting takes its count of reads from writecnt
+	int calls = ((stats->common->ThreadMode == kMode_Server) ? 1 : packet->writecnt);
+	if (agg->count++) {
+	    agg->packet.packetLen += packet->packetLen;
+	    agg->packet.writecnt += calls;
+	    agg->packet.packetTime = packet->packetTime;
+	    agg->packet.sentTime = packet->sentTime;
+	} else {
+	    agg->packet = *packet;
+	    agg->packet.writecnt = calls;
+	}
+	return true;
+    }
+    if (agg->count) {
+	packetring_enqueue(data->packetring, &agg->packet);
+	agg->count = 0;
+    }
+    return false;
+}
+
 /*
  * ReportPacket is called by a transfer agent to record
  * the arrival or departure of a "packet" (for TCP it
@@ -135,13 +262,24 @@ bool ReportPacket (struct ReporterData* data, struct ReportStruct *packet) {
     assert(data != NULL);
 
     bool rc = false;
+    struct TransferInfo *stats = &data->info;
   #ifdef HAVE_THREAD_DEBUG
     if (packet->packetID < 0) {
 	thread_debug("Reporting last packet for %p  qdepth=%d sock=%d", (void *) data, packetring_getcount(data->packetring), data->info.common->socket);
     }
   #endif
+    // the final packet from EndJob carries its own sample
+    if (stats->isEnableCPUStats && !(packet->packetID < 0)) {
+	packet->cpustats.isValid = false;
+	if (!TimeZero(stats->ts.nextCPUSampleTime) && (TimeDifference(stats->ts.nextCPUSampleTime, packet->packetTime) < 0)) {
+	    sample_cpustats(&stats->cpustats, &packet->cpustats);
+	    // skip over intervals without any traffic
+	    while (TimeDifference(stats->ts.nextCPUSampleTime, packet->packetTime) < 0) {
+		TimeAdd(stats->ts.nextCPUSampleTime, stats->ts.intervalTime);
+	    }
+	}
+    }
 #if HAVE_TCP_STATS
-    struct TransferInfo *stats = &data->info;
     if (stats->isEnableTcpInfo) {
 	if (!TimeZero(stats->ts.nextTCPStampleTime) && (TimeDifference(stats->ts.nextTCPStampleTime, packet->packetTime) < 0)) {
 	    gettcpinfo(data, packet);
@@ -152,6 +290,8 @@ bool ReportPacket (struct ReporterData* data, struct ReportStruct *packet) {
     }
 #endif
 
+    if (data->aggregate && reporter_aggregate_packet(data, packet))
+	return rc;
     // Note for threaded operation all that needs
     // to be done is to enqueue the packet data
     // into the ring.
@@ -165,6 +305,10 @@ bool ReportPacket (struct ReporterData* data, struct ReportStruct *packet) {
     // bypass the reporter thread here for single UDP
     if (isSingleUDP(data->info.common))
         reporter_process_transfer_report(data);
+    #if HAVE_REPORTER_WAKEUP
+    else
+	reporter_wakeup_check(data, packet);
+    #endif
   #else
     /*
      * Process the report in this thread
@@ -202,12 +346,30 @@ int EndJob (struct ReportHeader *reporthdr, struct ReportStruct *finalpacket) {
 	gettcpinfo(report, finalpacket);
     }
 #endif
+    // cpu stats are also sampled on the final packet, which is the last use of the cycle counter
+    if (report->info.isEnableCPUStats) {
+	sample_cpustats(&report->info.cpustats, &packet.cpustats);
+	if (report->info.cpustats.cycles_fd >= 0) {
+	    close(report->info.cpustats.cycles_fd);
+	    report->info.cpustats.cycles_fd = -1;
+	}
+    }
     // clear the reporter done predicate
     report->packetring->consumerdone = 0;
     // the negative packetID is used to inform the report thread this traffic thread is done
     packet.packetID = -1;
     packet.packetLen = finalpacket->packetLen;
     packet.packetTime = finalpacket->packetTime;
+    packet.tlsrecords = finalpacket->tlsrecords;
+    packet.tlsrekeys = finalpacket->tlsrekeys;
+    packet.tlsrekey_stall = finalpacket->tlsrekey_stall;
+    packet.zc_zerocopy = finalpacket->zc_zerocopy;
+    packet.zc_copied = finalpacket->zc_copied;
+    packet.txt_stamps = finalpacket->txt_stamps;
+    packet.txt_missed = finalpacket->txt_missed;
+    packet.txt_dev = finalpacket->txt_dev;
+    packet.txt_devmax = finalpacket->txt_devmax;
+    packet.busypoll = finalpacket->busypoll;
     if (isSingleUDP(report->info.common)) {
 	packetring_enqueue(report->packetring, &packet);
 	reporter_process_transfer_report(report);
@@ -247,6 +409,99 @@ int EndJob (struct ReportHeader *reporthdr, struct ReportStruct *finalpacket) {
 #define MINPACKETDEPTH 10
 #define MINPERQUEUEDEPTH 20
 #define REPORTERDELAY_DURATION 16000 // units is microseconds
+
+// Rather than a fixed delay the reporter (and shard) threads sleep on
+// an eventfd.  A traffic thread claims the sleeping flag and signals
+// when its packet ring reaches the high water mark or when an interval
+// (or the final) report is due, REPORTERDELAY_DURATION bounds the sleep.
+#define REPORTERWAKE_HIGHWATER_SHIFT 2 // a quarter of the ring
+struct ReporterWakeup {
+    int fd;
+    int sleeping;
+};
+static struct ReporterWakeup reporter_wakeup = {.fd = -1, .sleeping = 0};
+
+static void reporter_wakeup_init (struct ReporterWakeup *wakeup) {
+    wakeup->fd = -1;
+    wakeup->sleeping = 0;
+#if HAVE_REPORTER_WAKEUP
+    wakeup->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    WARN_errno(wakeup->fd < 0, "reporter eventfd");
+#endif
+}
+
+static void reporter_wakeup_free (struct ReporterWakeup *wakeup) {
+    if (wakeup->fd >= 0) {
+	close(wakeup->fd);
+	wakeup->fd = -1;
+    }
+}
+
+// Returns true if the sleeper was woken, false if it wasn't sleeping
+static inline bool reporter_wakeup_signal (struct ReporterWakeup *wakeup) {
+#if HAVE_REPORTER_WAKEUP
+    if (PR_LOAD_ACQUIRE(wakeup->sleeping) && __atomic_exchange_n(&wakeup->sleeping, 0, __ATOMIC_SEQ_CST)) {
+	uint64_t one = 1;
+	// EAGAIN means the counter is already set, i.e. it's awake anyway
+	if (write(wakeup->fd, &one, sizeof(one)) < 0) {
+	    WARN_errno((errno != EAGAIN), "reporter eventfd write");
+	}
+	return true;
+    }
+#endif
+    return false;
+}
+
+// A report's ring at the high water mark or holding packets past the
+// next interval, i.e. what a traffic thread would signal for
+static bool reporter_data_ready (struct ReporterData *data) {
+    int depth = packetring_getcount(data->packetring);
+    if (depth >= (int) ((data->packetring->mask + 1) >> REPORTERWAKE_HIGHWATER_SHIFT))
+	return true;
+    if ((depth > 0) && !TimeZero(data->info.ts.intervalTime)) {
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return (TimeDifference(data->info.ts.nextTime, now) < 0);
+    }
+    return false;
+}
+
+// The ready callback runs after the sleeping flag is published. A
+// traffic thread which tested the flag just before saw zero and skipped
+// its signal, so this second look keeps that work from waiting out the
+// whole REPORTERDELAY_DURATION
+static void reporter_sleep (struct ReporterWakeup *wakeup, bool (*ready)(void *), void *arg) {
+#if HAVE_REPORTER_WAKEUP
+    if (wakeup->fd >= 0) {
+	struct pollfd pfd = {.fd = wakeup->fd, .events = POLLIN, .revents = 0};
+	PR_STORE_SEQCST(wakeup->sleeping, 1);
+	if (ready(arg)) {
+	    PR_STORE_SEQCST(wakeup->sleeping, 0);
+	    return;
+	}
+	int rc = poll(&pfd, 1, (REPORTERDELAY_DURATION / 1000));
+	PR_STORE_SEQCST(wakeup->sleeping, 0);
+	if (rc > 0) {
+	    uint64_t count;
+	    // a late signal from a prior sleep only costs an early wakeup
+	    if (read(wakeup->fd, &count, sizeof(count)) < 0) {
+		WARN_errno((errno != EAGAIN), "reporter eventfd read");
+	    }
+	}
+	return;
+    }
+#endif
+    delay_loop(REPORTERDELAY_DURATION);
+}
+
+static inline void reporter_sample_ringdepth (struct ReporterData *data) {
+    int depth = packetring_getcount(data->packetring);
+    data->ringdepth_sum += depth;
+    data->ringdepth_samples++;
+    if (depth > data->ringdepth_max)
+	data->ringdepth_max = depth;
+}
+
 struct ConsumptionDetectorType {
     int accounted_packets;
     int accounted_packet_threads;
@@ -277,7 +532,7 @@ static inline void apply_consumption_detector (void) {
 	     * switching allowing for better CPU utilization,
 	     * which is very noticble on CPU constrained systems.
 	     */
-	    delay_loop(REPORTERDELAY_DURATION);
+	    reporter_sleep(&reporter_wakeup, reporter_jobq_ready, NULL);
 	    consumption_detector.reporter_thread_suspends++;
 	    // printf("DEBUG: forced reporter suspend, accounted=%d,  queueue depth after = %d\n", accounted_packets, getcount_packetring(reporthdr));
 	} else {
@@ -287,6 +542,268 @@ static inline void apply_consumption_detector (void) {
     }
 }
 
+#if HAVE_REPORTER_SHARDS
+// --reporter-threads, shard threads drain the packet rings of the data
+// reports assigned to them and do the per packet accounting.  The
+// reporter thread keeps the jobq, so all the printing and the sum
+// folding stay in jobq order.  A shard hands a report back (FOLD) when
+// it dequeues a packet crossing the next interval time or the final
+// packet, that packet is put back on the ring for the reporter thread.
+// The shardstate release/acquire orders the ring's consumer side
+// between the two threads.
+#define SHARD_NEW   0
+#define SHARD_MAIN  1
+#define SHARD_DRAIN 2
+#define SHARD_FOLD  3
+struct ReporterShard {
+    pthread_t thread;
+    Mutex lock;
+    struct ReporterData *intake;   // new reports from the reporter thread, under lock
+    struct ReporterData *reports;  // private to the shard thread
+    int nreports;
+    int suspends;
+    int stop;
+    struct ReporterWakeup wakeup;
+};
+static struct ReporterShard *reporter_shards = NULL;
+static int reporter_numshards = 0;
+// per jobq pass, for the reporter thread's idle check
+static int reporter_parked = 0;
+static int reporter_visited = 0;
+
+// Returns the packet to be folded by the reporter thread, NULL when the ring is drained
+static struct ReportStruct *reporter_shard_drain (struct ReporterData *data, int *drained) {
+    struct TransferInfo *stats = &data->info;
+    struct ReportStruct *packets[PACKETRING_BATCH];
+    int count;
+    reporter_sample_ringdepth(data);
+    while ((count = packetring_dequeue_n(data->packetring, packets, PACKETRING_BATCH)) > 0) {
+	for (int ix = 0; ix < count; ix++) {
+	    struct ReportStruct *packet = packets[ix];
+	    if ((packet->packetID < 0) || \
+		(data->transfer_interval_handler && (TimeDifference(stats->ts.nextTime, packet->packetTime) < 0))) {
+		packetring_unget(data->packetring, (count - ix));
+		return packet;
+	    }
+	    (*drained)++;
+#if HAVE_TCP_STATS
+	    if (stats->isEnableTcpInfo && packet->tcpstats.isValid) {
+		reporter_handle_packet_tcpistats(data, packet);
+	    }
+#endif
+	    if (stats->isEnableCPUStats && packet->cpustats.isValid) {
+		reporter_handle_packet_cpustats(data, packet);
+	    }
+	    if (isBusyPoll(stats->common)) {
+		stats->busypoll.current = packet->busypoll;
+	    }
+	    if (data->packet_handler_pre_report) {
+		(*data->packet_handler_pre_report)(data, packet);
+	    }
+	    if (data->packet_handler_post_report) {
+		(*data->packet_handler_post_report)(data, packet);
+	    }
+	    data->shardpacketTime = packet->packetTime;
+	}
+    }
+    return NULL;
+}
+
+static bool reporter_shard_ready (void *arg) {
+    struct ReporterShard *shard = (struct ReporterShard *) arg;
+    for (struct ReporterData *data = shard->reports; data != NULL; data = data->shardnext) {
+	if ((PR_LOAD_ACQUIRE(data->shardstate) == SHARD_DRAIN) && reporter_data_ready(data))
+	    return true;
+    }
+    return false;
+}
+
+static void *reporter_shard_run (void *arg) {
+    struct ReporterShard *shard = (struct ReporterShard *) arg;
+    while (!PR_LOAD_ACQUIRE(shard->stop)) {
+	Mutex_Lock(&shard->lock);
+	while (shard->intake) {
+	    struct ReporterData *tmp = shard->intake;
+	    shard->intake = tmp->shardnext;
+	    tmp->shardnext = shard->reports;
+	    shard->reports = tmp;
+	    shard->nreports++;
+	}
+	Mutex_Unlock(&shard->lock);
+	int drained = 0;
+	struct ReporterData **item = &shard->reports;
+	while (*item) {
+	    struct ReporterData *data = *item;
+	    struct ReportStruct *packet;
+	    if ((PR_LOAD_ACQUIRE(data->shardstate) == SHARD_DRAIN) && \
+		((packet = reporter_shard_drain(data, &drained)) != NULL)) {
+		// The reporter thread frees the report after the final packet,
+		// so it has to leave this list before the handoff
+		if (packet->packetID < 0) {
+		    *item = data->shardnext;
+		    shard->nreports--;
+		    data->reporter_thread_suspends = shard->suspends;
+		    PR_STORE_RELEASE(data->shardstate, SHARD_FOLD);
+		    reporter_wakeup_signal(&reporter_wakeup);
+		    continue;
+		}
+		PR_STORE_RELEASE(data->shardstate, SHARD_FOLD);
+		reporter_wakeup_signal(&reporter_wakeup);
+	    }
+	    item = &data->shardnext;
+	}
+	// Same as the consumption detector, let the rings fill when the load is light
+	int mindepth = shard->nreports * MINPERQUEUEDEPTH;
+	if (drained < ((mindepth > MINPACKETDEPTH) ? mindepth : MINPACKETDEPTH)) {
+	    reporter_sleep(&shard->wakeup, reporter_shard_ready, shard);
+	    shard->suspends++;
+	}
+    }
+    return NULL;
+}
+
+static void reporter_shards_start (int count) {
+    if (count <= 0)
+	return;
+    reporter_shards = (struct ReporterShard *) calloc(count, sizeof(struct ReporterShard));
+    FAIL_errno(reporter_shards == NULL, "No memory for reporter shards", NULL);
+    for (int ix = 0; ix < count; ix++) {
+	struct ReporterShard *shard = &reporter_shards[ix];
+	Mutex_Initialize(&shard->lock);
+	reporter_wakeup_init(&shard->wakeup);
+	int rc = pthread_create(&shard->thread, NULL, reporter_shard_run, shard);
+	if (rc) {
+	    errno = rc;
+	    WARN_errno(1, "reporter shard pthread_create");
+	    Mutex_Destroy(&shard->lock);
+	    reporter_wakeup_free(&shard->wakeup);
+	    break;
+	}
+	reporter_numshards++;
+    }
+#ifdef HAVE_THREAD_DEBUG
+    thread_debug("Reporter started %d of %d shard threads", reporter_numshards, count);
+#endif
+}
+
+static void reporter_shards_stop (void) {
+    for (int ix = 0; ix < reporter_numshards; ix++) {
+	PR_STORE_RELEASE(reporter_shards[ix].stop, 1);
+    }
+    for (int ix = 0; ix < reporter_numshards; ix++) {
+	pthread_join(reporter_shards[ix].thread, NULL);
+	Mutex_Destroy(&reporter_shards[ix].lock);
+	reporter_wakeup_free(&reporter_shards[ix].wakeup);
+    }
+    free(reporter_shards);
+    reporter_shards = NULL;
+    reporter_numshards = 0;
+}
+
+// Returns true when the report is owned by a shard thread, i.e. the
+// reporter thread is to skip it
+// A report which already folded into the sums' current interval
+// waits for the other members, otherwise a member could fold its
+// next interval (or its final) into the sums ahead of them
+static inline bool reporter_shard_foldwait (struct ReporterData *data) {
+    if (data->GroupSumReport && (data->sumfolds != data->GroupSumReport->intervals))
+	return true;
+    if (data->FullDuplexReport && isEnhanced(data->info.common) && \
+	(data->fullduplexfolds != data->FullDuplexReport->intervals))
+	return true;
+    return false;
+}
+
+static inline bool reporter_shard_parked (struct ReporterData *data) {
+    switch (PR_LOAD_ACQUIRE(data->shardstate)) {
+    case SHARD_NEW:
+	// Burst and frame reports, and the single UDP bypass, stay with the reporter thread
+	if (reporter_numshards && !isSingleUDP(data->info.common) && \
+	    ((data->transfer_interval_handler == NULL) || \
+	     (data->transfer_interval_handler == reporter_condprint_time_interval_report))) {
+	    struct ReporterShard *shard = &reporter_shards[data->info.common->transferID % reporter_numshards];
+	    // the traffic thread reads this to pick the shard's wakeup
+	    PR_STORE_RELEASE(data->shard, ((data->info.common->transferID % reporter_numshards) + 1));
+	    data->shardstate = SHARD_DRAIN;
+	    Mutex_Lock(&shard->lock);
+	    data->shardnext = shard->intake;
+	    shard->intake = data;
+	    Mutex_Unlock(&shard->lock);
+	    return true;
+	}
+	data->shardstate = SHARD_MAIN;
+	return false;
+    case SHARD_DRAIN:
+	return true;
+    case SHARD_FOLD:
+	return reporter_shard_foldwait(data);
+    default:
+	return false;
+    }
+}
+#endif // HAVE_REPORTER_SHARDS
+
+// The reporter thread's reports, a shard's fold handoff counts as well
+static bool reporter_jobq_ready (void *arg) {
+    for (struct ReportHeader *itr = ReportRoot; itr != NULL; itr = itr->next) {
+	if (itr->type != DATA_REPORT)
+	    continue;
+	struct ReporterData *data = (struct ReporterData *) itr->this_report;
+#if HAVE_REPORTER_SHARDS
+	switch (PR_LOAD_ACQUIRE(data->shardstate)) {
+	case SHARD_DRAIN:
+	    continue;
+	case SHARD_FOLD:
+	    if (!reporter_shard_foldwait(data))
+		return true;
+	    continue;
+	default:
+	    break;
+	}
+#endif
+	if (reporter_data_ready(data))
+	    return true;
+    }
+    return false;
+}
+
+#if HAVE_REPORTER_WAKEUP
+// Called by the traffic thread after the enqueue
+static void reporter_wakeup_check (struct ReporterData *data, struct ReportStruct *packet) {
+    struct ReporterWakeup *wakeup = &reporter_wakeup;
+#if HAVE_REPORTER_SHARDS
+    int shard = PR_LOAD_ACQUIRE(data->shard);
+    if (shard)
+	wakeup = &reporter_shards[shard - 1].wakeup;
+#endif
+    // an awake reporter needs nothing, and reporter_sleep() looks at the
+    // rings itself after publishing the flag
+    if (!PR_LOAD_ACQUIRE(wakeup->sleeping))
+	return;
+    struct TransferInfo *stats = &data->info;
+    bool interval_due = (packet->packetID < 0);
+    // a traffic thread copy of the next interval time, as the reporter's is
+    // advanced by the reporter thread
+    if (!TimeZero(stats->ts.intervalTime)) {
+	if (TimeZero(data->nextWakeTime))
+	    data->nextWakeTime = stats->ts.nextTime;
+	if (TimeDifference(data->nextWakeTime, packet->packetTime) < 0) {
+	    interval_due = true;
+	    while (TimeDifference(data->nextWakeTime, packet->packetTime) < 0) {
+		TimeAdd(data->nextWakeTime, stats->ts.intervalTime);
+	    }
+	}
+    }
+    if (interval_due) {
+	if (reporter_wakeup_signal(wakeup))
+	    data->wakeups_interval++;
+    } else if (packetring_getcount(data->packetring) >= (int) ((data->packetring->mask + 1) >> REPORTERWAKE_HIGHWATER_SHIFT)) {
+	if (reporter_wakeup_signal(wakeup))
+	    data->wakeups_ring++;
+    }
+}
+#endif
+
 #ifdef HAVE_THREAD_DEBUG
 static void reporter_jobq_dump(void) {
   thread_debug("reporter thread job queue request lock");
@@ -423,6 +940,11 @@ void reporter_spawn (struct thread_Settings *thread) {
 #if HAVE_SCHED_SETSCHEDULER
     // set reporter thread to realtime if requested
     thread_setscheduler(thread);
+#endif
+    reporter_wakeup_init(&reporter_wakeup);
+#if HAVE_REPORTER_SHARDS
+    if (isReporterThreads(thread))
+	reporter_shards_start(thread->mReporterThreads);
 #endif
     /*
      * Keep the reporter thread alive under the following conditions
@@ -437,6 +959,10 @@ void reporter_spawn (struct thread_Settings *thread) {
 	// thread_debug( "Jobq *HEAD* %p (%d)", (void *) ReportRoot, thread_numuserthreads());
 #endif
 	if (ReportRoot) {
+#if HAVE_REPORTER_SHARDS
+	    reporter_parked = 0;
+	    reporter_visited = 0;
+#endif
 	    // https://blog.kloetzl.info/beautiful-code/
 	    // Linked list removal/processing is derived from:
 	    //
@@ -469,8 +995,17 @@ void reporter_spawn (struct thread_Settings *thread) {
 		}
 		work_item = &(*work_item)->next;
 	    }
+#if HAVE_REPORTER_SHARDS
+	    // Nothing to do but wait on the shard threads
+	    if (reporter_parked && (reporter_parked == reporter_visited))
+		reporter_sleep(&reporter_wakeup, reporter_jobq_ready, NULL);
+#endif
 	}
     }
+#if HAVE_REPORTER_SHARDS
+    reporter_shards_stop();
+#endif
+    reporter_wakeup_free(&reporter_wakeup);
     if (myConnectionReport) {
 	if (myConnectionReport->connect_times.cnt > 1) {
 	    reporter_connect_printf_tcp_final(myConnectionReport);
@@ -501,12 +1036,32 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
     // Note: If this detection is not going off it means
     // the system is likely CPU bound and iperf is now likely
     // becoming a CPU bound test vs a network i/o bound test
-    if (!isSingleUDP(this_ireport->info.common))
-	apply_consumption_detector();
+    // Sharded reports come here only to fold, the shard thread does its own delay
+    if (!isSingleUDP(this_ireport->info.common)) {
+	reporter_sample_ringdepth(this_ireport);
+	if (!this_ireport->shard)
+	    apply_consumption_detector();
+    }
+    // A shard thread doesn't keep the sums' packet times current, catch them up per handoff
+    if (this_ireport->shard) {
+	if (sumstats && (TimeDifference(this_ireport->shardpacketTime, sumstats->ts.packetTime) > 0))
+	    sumstats->ts.packetTime = this_ireport->shardpacketTime;
+	if (fullduplexstats && (TimeDifference(this_ireport->shardpacketTime, fullduplexstats->ts.packetTime) > 0))
+	    fullduplexstats->ts.packetTime = this_ireport->shardpacketTime;
+    }
     // If there are more packets to process then handle them
+    struct ReportStruct *packets[PACKETRING_BATCH];
     struct ReportStruct *packet = NULL;
     int advance_jobq = 0;
-    while (!advance_jobq && (packet = packetring_dequeue(this_ireport->packetring))) {
+    int count = 0;
+    int next = 0;
+    while (!advance_jobq) {
+	if (next == count) {
+	    next = 0;
+	    if (!(count = packetring_dequeue_n(this_ireport->packetring, packets, PACKETRING_BATCH)))
+		break;
+	}
+	packet = packets[next++];
 	// Increment the total packet count processed by this thread
 	// this will be used to make decisions on if the reporter
 	// thread should add some delay to eliminate cpu thread
@@ -518,6 +1073,12 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 	    reporter_handle_packet_tcpistats(this_ireport, packet);
 	}
 #endif
+	if (this_ireport->info.isEnableCPUStats && packet->cpustats.isValid) {
+	    reporter_handle_packet_cpustats(this_ireport, packet);
+	}
+	if (isBusyPoll(this_ireport->info.common)) {
+	    this_ireport->info.busypoll.current = packet->busypoll;
+	}
 	if (!(packet->packetID < 0)) {
 	    // Check to output any interval reports,
             // bursts need to report the packet first
@@ -543,7 +1104,9 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 	    advance_jobq = 1;
 	    // A last packet event was detected
 	    // printf("last packet event detected\n"); fflush(stdout);
-	    this_ireport->reporter_thread_suspends = consumption_detector.reporter_thread_suspends;
+	    // a shard thread sets its own count
+	    if (!this_ireport->shard)
+		this_ireport->reporter_thread_suspends = consumption_detector.reporter_thread_suspends;
 	    if (this_ireport->packet_handler_pre_report) {
 		(*this_ireport->packet_handler_pre_report)(this_ireport, packet);
 	    }
@@ -553,8 +1116,27 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 	    this_ireport->info.ts.packetTime = packet->packetTime;
 	    assert(this_ireport->transfer_protocol_handler != NULL);
 	    (*this_ireport->transfer_protocol_handler)(this_ireport, 1);
+	    if (isReporterStats(this_ireport->info.common))
+		reporter_print_ring_stats(this_ireport);
 	    // This is a final report so set the sum report header's packet time
 	    // Note, the thread with the max value will set this
+	    // (a shard's final packet is past its last handoff, catch the sums up)
+	    if (this_ireport->shard) {
+		if (fullduplexstats && (TimeDifference(packet->packetTime, fullduplexstats->ts.packetTime) > 0))
+		    fullduplexstats->ts.packetTime = packet->packetTime;
+		if (sumstats && (TimeDifference(packet->packetTime, sumstats->ts.packetTime) > 0))
+		    sumstats->ts.packetTime = packet->packetTime;
+	    }
+	    // Sharded members fold in order, so when every other member has already
+	    // folded into the sums' current interval this one won't, output it now
+	    // that it includes this one's final partial interval
+	    if (this_ireport->shard) {
+		if (fullduplexstats && isEnhanced(this_ireport->info.common) && (this_ireport->FullDuplexReport->threads == 1))
+		    reporter_fullduplex_interval_report(this_ireport);
+		if (sumstats && this_ireport->GroupSumReport->threads && \
+		    (this_ireport->GroupSumReport->threads == (this_ireport->GroupSumReport->reference.count - 1)))
+		    reporter_sum_interval_report(this_ireport);
+	    }
 	    if (fullduplexstats && isEnhanced(this_ireport->info.common)) {
 		// The largest packet timestamp sets the sum report final time
 		if (TimeDifference(fullduplexstats->ts.packetTime, packet->packetTime) > 0) {
@@ -581,6 +1163,9 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 	    }
 	}
     }
+    // packets not yet processed stay on the ring for the next pass
+    if (next < count)
+	packetring_unget(this_ireport->packetring, (count - next));
     return need_free;
 }
 /*
@@ -593,9 +1178,24 @@ int reporter_process_transfer_report (struct ReporterData *this_ireport) {
 inline int reporter_process_report (struct ReportHeader *reporthdr) {
     assert(reporthdr != NULL);
     int done = 1;
+#if HAVE_REPORTER_SHARDS
+    reporter_visited++;
+#endif
     switch (reporthdr->type) {
     case DATA_REPORT:
+#if HAVE_REPORTER_SHARDS
+	if (reporter_shard_parked((struct ReporterData *)reporthdr->this_report)) {
+	    reporter_parked++;
+	    done = 0;
+	    break;
+	}
+#endif
 	done = reporter_process_transfer_report((struct ReporterData *)reporthdr->this_report);
+#if HAVE_REPORTER_SHARDS
+	// Give the ring back to the shard thread
+	if (!done && ((struct ReporterData *)reporthdr->this_report)->shard)
+	    PR_STORE_RELEASE(((struct ReporterData *)reporthdr->this_report)->shardstate, SHARD_DRAIN);
+#endif
 	fflush(stdout);
 	if (done) {
 	    struct ReporterData *tmp = (struct ReporterData *)reporthdr->this_report;
@@ -612,6 +1212,19 @@ inline int reporter_process_report (struct ReportHeader *reporthdr) {
 	if (!isCompat(creport->common) && (creport->common->ThreadMode == kMode_Client)) {
 	    // Clients' connect times will be inputs to the overall connect stats
 	    reporter_mmm_update(&myConnectionReport->connect_times, creport->connecttime);
+	    if (creport->tlshandshaketime > 0) {
+		double start = creport->connect_timestamp.tv_sec + (creport->connect_timestamp.tv_usec / 1e6);
+		double end = start + ((creport->connecttime + creport->tlshandshaketime) / 1e3);
+		reporter_mmm_update(&myConnectionReport->tlshandshake_times, creport->tlshandshaketime);
+		if (creport->tlshandshakeflags & TLSHS_RESUMED)
+		    myConnectionReport->tlsresumed_cnt++;
+		if (creport->tlshandshakeflags & TLSHS_EARLYDATA)
+		    myConnectionReport->tlsearlydata_cnt++;
+		if ((myConnectionReport->tlshandshake_first == 0) || (start < myConnectionReport->tlshandshake_first))
+		    myConnectionReport->tlshandshake_first = start;
+		if (end > myConnectionReport->tlshandshake_last)
+		    myConnectionReport->tlshandshake_last = end;
+	    }
 	}
 	reporter_print_connection_report(creport);
 	fflush(stdout);
@@ -824,7 +1437,13 @@ inline void reporter_handle_packet_server_tcp (struct ReporterData *data, struct
     if (packet->packetLen > 0) {
 	int bin;
 	stats->total.Bytes.current += packet->packetLen;
-	// mean min max tests
+	// mean min max tests, an aggregate of reads carries its count
+	// in writecnt and has no per read size for the bins
+	if (packet->writecnt > 1) {
+	    stats->sock_callstats.read.cntRead += packet->writecnt;
+	    stats->sock_callstats.read.totcntRead += packet->writecnt;
+	    return;
+	}
 	stats->sock_callstats.read.cntRead++;
 	stats->sock_callstats.read.totcntRead++;
 	bin = (int)floor((packet->packetLen -1)/stats->sock_callstats.read.binsize);
@@ -901,6 +1520,11 @@ static inline void reporter_handle_packet_tcpistats (struct ReporterData *data,
 }
 #endif
 
+static inline void reporter_handle_packet_cpustats (struct ReporterData *data, struct ReportStruct *packet) {
+    assert(data!=NULL);
+    data->info.cpustats.current = packet->cpustats;
+}
+
 void reporter_handle_packet_client (struct ReporterData *data, struct ReportStruct *packet) {
     struct TransferInfo *stats = &data->info;
     stats->ts.packetTime = packet->packetTime;
@@ -913,6 +1537,28 @@ void reporter_handle_packet_client (struct ReporterData *data, struct ReportStru
 	// These are valid packets that need standard iperf accounting
 	stats->sock_callstats.write.WriteCnt += packet->writecnt;
 	stats->sock_callstats.write.totWriteCnt += packet->writecnt;
+	stats->sock_callstats.write.TLSRecords += packet->tlsrecords;
+	stats->sock_callstats.write.totTLSRecords += packet->tlsrecords;
+	stats->sock_callstats.write.TLSRekeys += packet->tlsrekeys;
+	stats->sock_callstats.write.totTLSRekeys += packet->tlsrekeys;
+	stats->sock_callstats.write.TLSRekeyStall += packet->tlsrekey_stall;
+	stats->sock_callstats.write.totTLSRekeyStall += packet->tlsrekey_stall;
+	stats->sock_callstats.write.ZCZeroCopy += packet->zc_zerocopy;
+	stats->sock_callstats.write.totZCZeroCopy += packet->zc_zerocopy;
+	stats->sock_callstats.write.ZCCopied += packet->zc_copied;
+	stats->sock_callstats.write.totZCCopied += packet->zc_copied;
+	if (packet->txt_stamps || packet->txt_missed) {
+	    stats->sock_callstats.write.TxTStamps += packet->txt_stamps;
+	    stats->sock_callstats.write.totTxTStamps += packet->txt_stamps;
+	    stats->sock_callstats.write.TxTMissed += packet->txt_missed;
+	    stats->sock_callstats.write.totTxTMissed += packet->txt_missed;
+	    stats->sock_callstats.write.TxTDev += packet->txt_dev;
+	    stats->sock_callstats.write.totTxTDev += packet->txt_dev;
+	    if (stats->sock_callstats.write.TxTDevMax < packet->txt_devmax)
+		stats->sock_callstats.write.TxTDevMax = packet->txt_devmax;
+	    if (stats->sock_callstats.write.totTxTDevMax < packet->txt_devmax)
+		stats->sock_callstats.write.totTxTDevMax = packet->txt_devmax;
+	}
 	if (isIsochronous(stats->common)) {
 	    reporter_handle_packet_isochronous(data, packet);
 	} else if (isPeriodicBurst(stats->common)) {
@@ -993,8 +1639,14 @@ static inline void reporter_transfer_protocol_missed_reports (struct TransferInf
 
 static inline void reporter_reset_transfer_stats_client_tcp (struct TransferInfo *stats) {
     stats->total.Bytes.prev = stats->total.Bytes.current;
+    stats->cpustats.prev = stats->cpustats.current;
     stats->sock_callstats.write.WriteCnt = 0;
     stats->sock_callstats.write.WriteErr = 0;
+    stats->sock_callstats.write.TLSRecords = 0;
+    stats->sock_callstats.write.TLSRekeys = 0;
+    stats->sock_callstats.write.TLSRekeyStall = 0;
+    stats->sock_callstats.write.ZCZeroCopy = 0;
+    stats->sock_callstats.write.ZCCopied = 0;
     stats->isochstats.framecnt.prev = stats->isochstats.framecnt.current;
     stats->isochstats.framelostcnt.prev = stats->isochstats.framelostcnt.current;
     stats->isochstats.slipcnt.prev = stats->isochstats.slipcnt.current;
@@ -1024,6 +1676,12 @@ static inline void reporter_reset_transfer_stats_client_udp (struct TransferInfo
     stats->total.IPG.prev = stats->total.IPG.current;
     stats->sock_callstats.write.WriteCnt = 0;
     stats->sock_callstats.write.WriteErr = 0;
+    stats->sock_callstats.write.ZCZeroCopy = 0;
+    stats->sock_callstats.write.ZCCopied = 0;
+    stats->sock_callstats.write.TxTStamps = 0;
+    stats->sock_callstats.write.TxTMissed = 0;
+    stats->sock_callstats.write.TxTDev = 0;
+    stats->sock_callstats.write.TxTDevMax = 0;
     stats->isochstats.framecnt.prev = stats->isochstats.framecnt.current;
     stats->isochstats.framelostcnt.prev = stats->isochstats.framelostcnt.current;
     stats->isochstats.slipcnt.prev = stats->isochstats.slipcnt.current;
@@ -1031,9 +1689,58 @@ static inline void reporter_reset_transfer_stats_client_udp (struct TransferInfo
 	stats->IPGsum = 0;
 }
 
+// Set the cpu usage for the report being output, either since the
+// last interval or the totals since the start of traffic
+static inline void reporter_set_cpustats (struct TransferInfo *stats, bool total) {
+    if (stats->isEnableCPUStats) {
+	struct CPUStats *cpu = &stats->cpustats;
+	struct reportstruct_cpustats *base = (total ? &cpu->start : &cpu->prev);
+	cpu->cnt.cputime = cpu->current.cputime - base->cputime;
+	cpu->cnt.utime = cpu->current.utime - base->utime;
+	cpu->cnt.stime = cpu->current.stime - base->stime;
+	cpu->cnt.cycles = cpu->current.cycles - base->cycles;
+    }
+}
+
+static inline void reporter_sum_cpustats (struct TransferInfo *sumstats, struct TransferInfo *stats) {
+    if (stats->isEnableCPUStats) {
+	sumstats->isEnableCPUStats = true;
+	sumstats->cpustats.hasCycles = stats->cpustats.hasCycles;
+	sumstats->cpustats.current.cputime += stats->cpustats.cnt.cputime;
+	sumstats->cpustats.current.utime += stats->cpustats.cnt.utime;
+	sumstats->cpustats.current.stime += stats->cpustats.cnt.stime;
+	sumstats->cpustats.current.cycles += stats->cpustats.cnt.cycles;
+    }
+}
+
+// The traffic thread posts running totals, the same as the cpu samples
+static inline void reporter_set_busypoll (struct TransferInfo *stats, bool total) {
+    if (isBusyPoll(stats->common)) {
+	struct BusyPollStats *bp = &stats->busypoll;
+	bp->cnt = bp->current;
+	if (!total) {
+	    bp->cnt.spin_ns -= bp->prev.spin_ns;
+	    bp->cnt.sleep_ns -= bp->prev.sleep_ns;
+	    bp->cnt.spun -= bp->prev.spun;
+	    bp->cnt.slept -= bp->prev.slept;
+	}
+    }
+}
+
+static inline void reporter_sum_busypoll (struct TransferInfo *sumstats, struct TransferInfo *stats) {
+    if (isBusyPoll(stats->common)) {
+	sumstats->busypoll.current.spin_ns += stats->busypoll.cnt.spin_ns;
+	sumstats->busypoll.current.sleep_ns += stats->busypoll.cnt.sleep_ns;
+	sumstats->busypoll.current.spun += stats->busypoll.cnt.spun;
+	sumstats->busypoll.current.slept += stats->busypoll.cnt.slept;
+    }
+}
+
 static inline void reporter_reset_transfer_stats_server_tcp (struct TransferInfo *stats) {
     int ix;
     stats->total.Bytes.prev = stats->total.Bytes.current;
+    stats->cpustats.prev = stats->cpustats.current;
+    stats->busypoll.prev = stats->busypoll.current;
     stats->sock_callstats.read.cntRead = 0;
     for (ix = 0; ix < 8; ix++) {
 	stats->sock_callstats.read.bins[ix] = 0;
@@ -1051,6 +1758,7 @@ static inline void reporter_reset_transfer_stats_server_tcp (struct TransferInfo
 static inline void reporter_reset_transfer_stats_server_udp (struct TransferInfo *stats) {
     // Reset the enhanced stats for the next report interval
     stats->total.Bytes.prev = stats->total.Bytes.current;
+    stats->busypoll.prev = stats->busypoll.current;
     stats->total.Datagrams.prev = stats->PacketID;
     stats->total.OutofOrder.prev = stats->total.OutofOrder.current;
     stats->total.Lost.prev = stats->total.Lost.current;
@@ -1092,6 +1800,7 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 	stats->cntError = 0;
     stats->cntDatagrams = stats->PacketID - stats->total.Datagrams.prev;
     stats->cntIPG = stats->total.IPG.current - stats->total.IPG.prev;
+    reporter_set_busypoll(stats, false);
     if (stats->latency_histogram) {
         stats->latency_histogram->final = final;
     }
@@ -1117,6 +1826,7 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 	sumstats->total.IPG.current += stats->cntIPG;
 	if (sumstats->IPGsum < stats->IPGsum)
 	    sumstats->IPGsum = stats->IPGsum;
+	reporter_sum_busypoll(sumstats, stats);
 	sumstats->threadcnt++;
     }
     if (fullduplexstats) {
@@ -1144,6 +1854,7 @@ void reporter_transfer_protocol_server_udp (struct ReporterData *data, int final
 	}
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
 	stats->final = true;
+	reporter_set_busypoll(stats, true);
 	stats->IPGsum = TimeDifference(stats->ts.packetTime, stats->ts.startTime);
 	stats->cntOutofOrder = stats->total.OutofOrder.current;
 	// assume most of the  time out-of-order packets are not
@@ -1199,6 +1910,7 @@ void reporter_transfer_protocol_sum_server_udp (struct TransferInfo *stats, int
 	stats->cntBytes = stats->total.Bytes.current;
 	stats->IPGsum = TimeDifference(stats->ts.packetTime, stats->ts.startTime);
 	stats->cntIPG = stats->total.IPG.current;
+	reporter_set_busypoll(stats, true);
     } else {
 	stats->cntOutofOrder = stats->total.OutofOrder.current - stats->total.OutofOrder.prev;
 	// assume most of the  time out-of-order packets are not
@@ -1210,6 +1922,7 @@ void reporter_transfer_protocol_sum_server_udp (struct TransferInfo *stats, int
 	stats->cntDatagrams = stats->total.Datagrams.current - stats->total.Datagrams.prev;
 	stats->cntBytes = stats->total.Bytes.current - stats->total.Bytes.prev;
 	stats->cntIPG = stats->total.IPG.current - stats->total.IPG.prev;
+	reporter_set_busypoll(stats, false);
     }
     if ((stats->output_handler) && !(stats->isMaskOutput))
 	(*stats->output_handler)(stats);
@@ -1225,6 +1938,12 @@ void reporter_transfer_protocol_sum_client_udp (struct TransferInfo *stats, int
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
 	stats->sock_callstats.write.WriteErr = stats->sock_callstats.write.totWriteErr;
 	stats->sock_callstats.write.WriteCnt = stats->sock_callstats.write.totWriteCnt;
+	stats->sock_callstats.write.ZCZeroCopy = stats->sock_callstats.write.totZCZeroCopy;
+	stats->sock_callstats.write.ZCCopied = stats->sock_callstats.write.totZCCopied;
+	stats->sock_callstats.write.TxTStamps = stats->sock_callstats.write.totTxTStamps;
+	stats->sock_callstats.write.TxTMissed = stats->sock_callstats.write.totTxTMissed;
+	stats->sock_callstats.write.TxTDev = stats->sock_callstats.write.totTxTDev;
+	stats->sock_callstats.write.TxTDevMax = stats->sock_callstats.write.totTxTDevMax;
 	stats->cntDatagrams = stats->total.Datagrams.current;
 	stats->cntBytes = stats->total.Bytes.current;
 	stats->IPGsum = TimeDifference(stats->ts.packetTime, stats->ts.startTime);
@@ -1264,6 +1983,20 @@ void reporter_transfer_protocol_client_udp (struct ReporterData *data, int final
 	sumstats->sock_callstats.write.WriteCnt += stats->sock_callstats.write.WriteCnt;
 	sumstats->sock_callstats.write.totWriteErr += stats->sock_callstats.write.WriteErr;
 	sumstats->sock_callstats.write.totWriteCnt += stats->sock_callstats.write.WriteCnt;
+	sumstats->sock_callstats.write.ZCZeroCopy += stats->sock_callstats.write.ZCZeroCopy;
+	sumstats->sock_callstats.write.totZCZeroCopy += stats->sock_callstats.write.ZCZeroCopy;
+	sumstats->sock_callstats.write.ZCCopied += stats->sock_callstats.write.ZCCopied;
+	sumstats->sock_callstats.write.totZCCopied += stats->sock_callstats.write.ZCCopied;
+	sumstats->sock_callstats.write.TxTStamps += stats->sock_callstats.write.TxTStamps;
+	sumstats->sock_callstats.write.totTxTStamps += stats->sock_callstats.write.TxTStamps;
+	sumstats->sock_callstats.write.TxTMissed += stats->sock_callstats.write.TxTMissed;
+	sumstats->sock_callstats.write.totTxTMissed += stats->sock_callstats.write.TxTMissed;
+	sumstats->sock_callstats.write.TxTDev += stats->sock_callstats.write.TxTDev;
+	sumstats->sock_callstats.write.totTxTDev += stats->sock_callstats.write.TxTDev;
+	if (sumstats->sock_callstats.write.TxTDevMax < stats->sock_callstats.write.TxTDevMax)
+	    sumstats->sock_callstats.write.TxTDevMax = stats->sock_callstats.write.TxTDevMax;
+	if (sumstats->sock_callstats.write.totTxTDevMax < stats->sock_callstats.write.TxTDevMax)
+	    sumstats->sock_callstats.write.totTxTDevMax = stats->sock_callstats.write.TxTDevMax;
 	sumstats->total.Datagrams.current += stats->cntDatagrams;
 	if (sumstats->IPGsum < stats->IPGsum)
 	    sumstats->IPGsum = stats->IPGsum;
@@ -1282,6 +2015,12 @@ void reporter_transfer_protocol_client_udp (struct ReporterData *data, int final
 	stats->cntBytes = stats->total.Bytes.current;
 	stats->sock_callstats.write.WriteErr = stats->sock_callstats.write.totWriteErr;
 	stats->sock_callstats.write.WriteCnt = stats->sock_callstats.write.totWriteCnt;
+	stats->sock_callstats.write.ZCZeroCopy = stats->sock_callstats.write.totZCZeroCopy;
+	stats->sock_callstats.write.ZCCopied = stats->sock_callstats.write.totZCCopied;
+	stats->sock_callstats.write.TxTStamps = stats->sock_callstats.write.totTxTStamps;
+	stats->sock_callstats.write.TxTMissed = stats->sock_callstats.write.totTxTMissed;
+	stats->sock_callstats.write.TxTDev = stats->sock_callstats.write.totTxTDev;
+	stats->sock_callstats.write.TxTDevMax = stats->sock_callstats.write.totTxTDevMax;
 	stats->cntIPG = stats->total.IPG.current;
 	stats->cntDatagrams = stats->PacketID;
 	stats->IPGsum = TimeDifference(stats->ts.packetTime, stats->ts.startTime);
@@ -1312,6 +2051,8 @@ void reporter_transfer_protocol_server_tcp (struct ReporterData *data, int final
     struct TransferInfo *sumstats = (data->GroupSumReport != NULL) ? &data->GroupSumReport->info : NULL;
     struct TransferInfo *fullduplexstats = (data->FullDuplexReport != NULL) ? &data->FullDuplexReport->info : NULL;
     stats->cntBytes = stats->total.Bytes.current - stats->total.Bytes.prev;
+    reporter_set_cpustats(stats, false);
+    reporter_set_busypoll(stats, false);
     int ix;
     if (stats->framelatency_histogram) {
         stats->framelatency_histogram->final = 0;
@@ -1325,6 +2066,8 @@ void reporter_transfer_protocol_server_tcp (struct ReporterData *data, int final
 	    sumstats->sock_callstats.read.bins[ix] += stats->sock_callstats.read.bins[ix];
 	    sumstats->sock_callstats.read.totbins[ix] += stats->sock_callstats.read.bins[ix];
         }
+	reporter_sum_cpustats(sumstats, stats);
+	reporter_sum_busypoll(sumstats, stats);
     }
     if (fullduplexstats) {
 	fullduplexstats->total.Bytes.current += stats->cntBytes;
@@ -1351,6 +2094,8 @@ void reporter_transfer_protocol_server_tcp (struct ReporterData *data, int final
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
         stats->cntBytes = stats->total.Bytes.current;
 	stats->IPGsum = stats->ts.iEnd;
+	reporter_set_cpustats(stats, true);
+	reporter_set_busypoll(stats, true);
         stats->sock_callstats.read.cntRead = stats->sock_callstats.read.totcntRead;
         for (ix = 0; ix < TCPREADBINCOUNT; ix++) {
 	    stats->sock_callstats.read.bins[ix] = stats->sock_callstats.read.totbins[ix];
@@ -1388,6 +2133,7 @@ void reporter_transfer_protocol_client_tcp (struct ReporterData *data, int final
     struct TransferInfo *sumstats = (data->GroupSumReport != NULL) ? &data->GroupSumReport->info : NULL;
     struct TransferInfo *fullduplexstats = (data->FullDuplexReport != NULL) ? &data->FullDuplexReport->info : NULL;
     stats->cntBytes = stats->total.Bytes.current - stats->total.Bytes.prev;
+    reporter_set_cpustats(stats, false);
 #if HAVE_DECL_TCP_NOTSENT_LOWAT
     if (stats->latency_histogram) {
         stats->latency_histogram->final = final;
@@ -1413,11 +2159,22 @@ void reporter_transfer_protocol_client_tcp (struct ReporterData *data, int final
 	sumstats->sock_callstats.write.WriteCnt += stats->sock_callstats.write.WriteCnt;
 	sumstats->sock_callstats.write.totWriteErr += stats->sock_callstats.write.WriteErr;
 	sumstats->sock_callstats.write.totWriteCnt += stats->sock_callstats.write.WriteCnt;
+	sumstats->sock_callstats.write.TLSRecords += stats->sock_callstats.write.TLSRecords;
+	sumstats->sock_callstats.write.totTLSRecords += stats->sock_callstats.write.TLSRecords;
+	sumstats->sock_callstats.write.TLSRekeys += stats->sock_callstats.write.TLSRekeys;
+	sumstats->sock_callstats.write.totTLSRekeys += stats->sock_callstats.write.TLSRekeys;
+	sumstats->sock_callstats.write.TLSRekeyStall += stats->sock_callstats.write.TLSRekeyStall;
+	sumstats->sock_callstats.write.totTLSRekeyStall += stats->sock_callstats.write.TLSRekeyStall;
+	sumstats->sock_callstats.write.ZCZeroCopy += stats->sock_callstats.write.ZCZeroCopy;
+	sumstats->sock_callstats.write.totZCZeroCopy += stats->sock_callstats.write.ZCZeroCopy;
+	sumstats->sock_callstats.write.ZCCopied += stats->sock_callstats.write.ZCCopied;
+	sumstats->sock_callstats.write.totZCCopied += stats->sock_callstats.write.ZCCopied;
 	sumstats->threadcnt++;
 #if HAVE_TCP_STATS
 	sumstats->sock_callstats.write.TCPretry += stats->sock_callstats.write.TCPretry;
 	sumstats->sock_callstats.write.totTCPretry += stats->sock_callstats.write.TCPretry;
 #endif
+	reporter_sum_cpustats(sumstats, stats);
     }
     if (fullduplexstats) {
 	fullduplexstats->total.Bytes.current += stats->cntBytes;
@@ -1452,6 +2209,11 @@ void reporter_transfer_protocol_client_tcp (struct ReporterData *data, int final
 	}
 	stats->sock_callstats.write.WriteErr = stats->sock_callstats.write.totWriteErr;
 	stats->sock_callstats.write.WriteCnt = stats->sock_callstats.write.totWriteCnt;
+	stats->sock_callstats.write.TLSRecords = stats->sock_callstats.write.totTLSRecords;
+	stats->sock_callstats.write.TLSRekeys = stats->sock_callstats.write.totTLSRekeys;
+	stats->sock_callstats.write.TLSRekeyStall = stats->sock_callstats.write.totTLSRekeyStall;
+	stats->sock_callstats.write.ZCZeroCopy = stats->sock_callstats.write.totZCZeroCopy;
+	stats->sock_callstats.write.ZCCopied = stats->sock_callstats.write.totZCCopied;
 #if HAVE_TCP_STATS
 	stats->sock_callstats.write.TCPretry = stats->sock_callstats.write.totTCPretry;
 #endif
@@ -1462,7 +2224,11 @@ void reporter_transfer_protocol_client_tcp (struct ReporterData *data, int final
 #if HAVE_DECL_TCP_NOTSENT_LOWAT
 	stats->drain_mmm.current = stats->drain_mmm.total;
 #endif
+	reporter_set_cpustats(stats, true);
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
+	reporter_final_tally.bytes += stats->cntBytes;
+	if ((stats->ts.iEnd - stats->ts.iStart) > reporter_final_tally.seconds)
+	    reporter_final_tally.seconds = stats->ts.iEnd - stats->ts.iStart;
     } else if (isIsochronous(stats->common)) {
 	stats->isochstats.cntFrames = stats->isochstats.framecnt.current - stats->isochstats.framecnt.prev;
 	stats->isochstats.cntFramesMissed = stats->isochstats.framelostcnt.current - stats->isochstats.framelostcnt.prev;
@@ -1481,6 +2247,7 @@ void reporter_transfer_protocol_client_tcp (struct ReporterData *data, int final
 void reporter_transfer_protocol_sum_client_tcp (struct TransferInfo *stats, int final) {
     if (!final || (final && (stats->cntBytes > 0) && !TimeZero(stats->ts.intervalTime))) {
 	stats->cntBytes = stats->total.Bytes.current - stats->total.Bytes.prev;
+	reporter_set_cpustats(stats, false);
 	if (final) {
 	    if ((stats->output_handler) && !(stats->isMaskOutput)) {
 		reporter_set_timestamps_time(&stats->ts, FINALPARTIAL);
@@ -1497,10 +2264,16 @@ void reporter_transfer_protocol_sum_client_tcp (struct TransferInfo *stats, int
     if (final) {
 	stats->sock_callstats.write.WriteErr = stats->sock_callstats.write.totWriteErr;
 	stats->sock_callstats.write.WriteCnt = stats->sock_callstats.write.totWriteCnt;
+	stats->sock_callstats.write.TLSRecords = stats->sock_callstats.write.totTLSRecords;
+	stats->sock_callstats.write.TLSRekeys = stats->sock_callstats.write.totTLSRekeys;
+	stats->sock_callstats.write.TLSRekeyStall = stats->sock_callstats.write.totTLSRekeyStall;
+	stats->sock_callstats.write.ZCZeroCopy = stats->sock_callstats.write.totZCZeroCopy;
+	stats->sock_callstats.write.ZCCopied = stats->sock_callstats.write.totZCCopied;
 #if HAVE_TCP_STATS
 	stats->sock_callstats.write.TCPretry = stats->sock_callstats.write.totTCPretry;
 #endif
 	stats->cntBytes = stats->total.Bytes.current;
+	reporter_set_cpustats(stats, true);
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
 	if ((stats->output_handler) && !(stats->isMaskOutput))
 	    (*stats->output_handler)(stats);
@@ -1510,6 +2283,8 @@ void reporter_transfer_protocol_sum_client_tcp (struct TransferInfo *stats, int
 void reporter_transfer_protocol_sum_server_tcp (struct TransferInfo *stats, int final) {
     if (!final || (final && (stats->cntBytes > 0) && !TimeZero(stats->ts.intervalTime))) {
 	stats->cntBytes = stats->total.Bytes.current - stats->total.Bytes.prev;
+	reporter_set_cpustats(stats, false);
+	reporter_set_busypoll(stats, false);
 	if (final) {
 	    if ((stats->output_handler) && !(stats->isMaskOutput)) {
 		reporter_set_timestamps_time(&stats->ts, FINALPARTIAL);
@@ -1530,6 +2305,8 @@ void reporter_transfer_protocol_sum_server_tcp (struct TransferInfo *stats, int
 	    stats->sock_callstats.read.bins[ix] = stats->sock_callstats.read.totbins[ix];
 	}
 	stats->cntBytes = stats->total.Bytes.current;
+	reporter_set_cpustats(stats, true);
+	reporter_set_busypoll(stats, true);
 	reporter_set_timestamps_time(&stats->ts, TOTAL);
 	if ((stats->output_handler) && !(stats->isMaskOutput))
 	    (*stats->output_handler)(stats);
@@ -1589,6 +2366,30 @@ void reporter_transfer_protocol_fullduplex_udp (struct TransferInfo *stats, int
 	(*stats->output_handler)(stats);
 }
 
+// Output the full duplex sum's interval, both directions have folded into it
+static void reporter_fullduplex_interval_report (struct ReporterData *data) {
+    data->FullDuplexReport->threads = 0;
+    data->FullDuplexReport->intervals++;
+    assert(data->FullDuplexReport->transfer_protocol_sum_handler != NULL);
+    (*data->FullDuplexReport->transfer_protocol_sum_handler)(&data->FullDuplexReport->info, 0);
+}
+
+// Output the group sum's interval, all of the members have folded into it
+static void reporter_sum_interval_report (struct ReporterData *data) {
+    struct TransferInfo *sumstats = &data->GroupSumReport->info;
+    data->GroupSumReport->threads = 0;
+    data->GroupSumReport->intervals++;
+    if ((data->GroupSumReport->reference.count > (data->FullDuplexReport ? 2 : 1)) || \
+	isSumOnly(data->info.common)) {
+	sumstats->isMaskOutput = false;
+    } else {
+	sumstats->isMaskOutput = true;
+    }
+    reporter_set_timestamps_time(&sumstats->ts, INTERVAL);
+    assert(data->GroupSumReport->transfer_protocol_sum_handler != NULL);
+    (*data->GroupSumReport->transfer_protocol_sum_handler)(sumstats, 0);
+}
+
 // Conditional print based on time
 int reporter_condprint_time_interval_report (struct ReporterData *data, struct ReportStruct *packet) {
     struct TransferInfo *stats = &data->info;
@@ -1609,24 +2410,15 @@ int reporter_condprint_time_interval_report (struct ReporterData *data, struct R
 #endif
 	reporter_set_timestamps_time(&stats->ts, INTERVAL);
 	(*data->transfer_protocol_handler)(data, 0);
-	if (fullduplexstats && ((++data->FullDuplexReport->threads) == 2) && isEnhanced(stats->common)) {
-	    data->FullDuplexReport->threads = 0;
-	    assert(data->FullDuplexReport->transfer_protocol_sum_handler != NULL);
-	    (*data->FullDuplexReport->transfer_protocol_sum_handler)(fullduplexstats, 0);
+	if (fullduplexstats) {
+	    data->fullduplexfolds++;
+	    if (((++data->FullDuplexReport->threads) == 2) && isEnhanced(stats->common))
+		reporter_fullduplex_interval_report(data);
 	}
 	if (sumstats) {
-	    if ((++data->GroupSumReport->threads) == data->GroupSumReport->reference.count)   {
-		data->GroupSumReport->threads = 0;
-		if ((data->GroupSumReport->reference.count > (fullduplexstats ? 2 : 1)) || \
-		    isSumOnly(data->info.common)) {
-		    sumstats->isMaskOutput = false;
-		} else {
-		    sumstats->isMaskOutput = true;
-		}
-		reporter_set_timestamps_time(&sumstats->ts, INTERVAL);
-		assert(data->GroupSumReport->transfer_protocol_sum_handler != NULL);
-		(*data->GroupSumReport->transfer_protocol_sum_handler)(sumstats, 0);
-	    }
+	    data->sumfolds++;
+	    if ((++data->GroupSumReport->threads) == data->GroupSumReport->reference.count)
+		reporter_sum_interval_report(data);
 	}
         // In the (hopefully unlikely event) the reporter fell behind
         // output the missed reports to catch up
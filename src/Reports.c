@@ -97,6 +97,7 @@ static void common_copy (struct ReportCommon **common, struct thread_Settings *i
     (*common)->flags = inSettings->flags;
     (*common)->flags_extend = inSettings->flags_extend;
     (*common)->flags_extend2 = inSettings->flags_extend2;
+    (*common)->flags_extend3 = inSettings->flags_extend3;
     (*common)->ThreadMode = inSettings->mThreadMode;
     (*common)->ReportMode = inSettings->mReportMode;
     (*common)->KeyCheck = inSettings->mKeyCheck;
@@ -118,6 +119,15 @@ static void common_copy (struct ReportCommon **common, struct thread_Settings *i
     (*common)->transferID = inSettings->mTransferID;
     (*common)->threads = inSettings->mThreads;
     (*common)->winsize_requested = inSettings->mTCPWin;
+    (*common)->TLSPipelines = inSettings->mTLSPipelines;
+    (*common)->UDPBatch = inSettings->mUDPBatch;
+    (*common)->IOUringDepth = inSettings->mIOUringDepth;
+    (*common)->Workers = inSettings->mWorkers;
+    (*common)->ListenShards = inSettings->mListenShards;
+    (*common)->TxTimeLead = inSettings->mTxTimeLead;
+    (*common)->BusyPoll = inSettings->mBusyPoll;
+    (*common)->XdpQueue = inSettings->mXdpQueue;
+    (*common)->ReporterThreads = inSettings->mReporterThreads;
 #if defined(HAVE_LINUX_FILTER_H) && defined(HAVE_AF_PACKET)
     (*common)->socketdrop = inSettings->mSockDrop;
 #endif
@@ -340,6 +350,8 @@ struct ConnectionInfo * InitConnectOnlyReport (struct thread_Settings *thread) {
     creport->connect_times.vd = 0;
     creport->connect_times.m2 = 0;
     creport->connect_times.mean = 0;
+    creport->tlshandshake_times.min = FLT_MAX;
+    creport->tlshandshake_times.max = FLT_MIN;
     creport->txholdbacktime = thread->txholdback_timer;
     return creport;
 }
@@ -371,6 +383,9 @@ static void Free_iReport (struct ReporterData *ireport) {
     if (ireport->packetring) {
 	packetring_free(ireport->packetring);
     }
+    if (ireport->aggregate) {
+	free(ireport->aggregate);
+    }
     if (ireport->info.latency_histogram) {
 	histogram_delete(ireport->info.latency_histogram);
     }
@@ -662,6 +677,25 @@ struct ReportHeader* InitIndividualReport (struct thread_Settings *inSettings) {
 #endif
     }
 #endif
+    // Plain TCP throughput, none of the enhanced per write (read) stats, so the
+    // traffic thread can pre-aggregate rather than enqueue every write (read)
+    if (!isUDP(inSettings) && !isEnhanced(inSettings) && !isTripTime(inSettings) && !isPeriodicBurst(inSettings) && \
+	!isIsochronous(inSettings) && !isWritePrefetch(inSettings) && !isTcpDrain(inSettings) && !isSSL(inSettings) && \
+	!isZeroCopy(inSettings) && !isBusyPoll(inSettings) && !isCPUStats(inSettings) && \
+	((inSettings->mThreadMode == kMode_Client) || (inSettings->mThreadMode == kMode_Server)) && \
+	((ireport->transfer_interval_handler == NULL) || (ireport->transfer_interval_handler == reporter_condprint_time_interval_report))) {
+#if HAVE_POSIX_MEMALIGN
+	void *agg = NULL;
+	if (posix_memalign(&agg, PACKETRING_CACHELINE, sizeof(struct ReportAggregate)) == 0)
+	    memset(agg, 0, sizeof(struct ReportAggregate));
+	else
+	    agg = NULL;
+	ireport->aggregate = (struct ReportAggregate *) agg;
+#else
+	ireport->aggregate = (struct ReportAggregate *) calloc(1, sizeof(struct ReportAggregate));
+#endif
+	WARN_errno((ireport->aggregate == NULL), "report aggregate");
+    }
     return reporthdr;
 }
 
@@ -709,6 +743,8 @@ struct ReportHeader* InitConnectionReport (struct thread_Settings *inSettings, d
     // Fill out known fields for the connection report
     reporter_peerversion(creport, inSettings->peer_version_u, inSettings->peer_version_l);
     creport->connecttime = ct;
+    creport->tlshandshaketime = (isSSL(inSettings) ? inSettings->tlshandshaketime : 0);
+    creport->tlshandshakeflags = (isSSL(inSettings) ? inSettings->tlshandshakeflags : 0);
     if (isEnhanced(inSettings) && isTxStartTime(inSettings)) {
 	creport->epochStartTime.tv_sec = inSettings->txstart_epoch.tv_sec;
 	creport->epochStartTime.tv_usec = inSettings->txstart_epoch.tv_usec;
@@ -866,9 +902,10 @@ struct ReportHeader* InitServerRelayUDPReport(struct thread_Settings *inSettings
  * If additional datagrams come in (not silent), probably our AckFIN
  * was lost so the client has re-transmitted
  * termination datagrams, so re-transmit our AckFIN.
+ * With DTLS (conn non NULL) the AckFIN is sent as a record.
  * Sent by server to client
  * ------------------------------------------------------------------- */
-void write_UDP_AckFIN (struct TransferInfo *stats, int len) {
+void write_UDP_AckFIN (struct TransferInfo *stats, void *conn, int len) {
     assert(stats!= NULL);
     int ackpacket_length = (int) (sizeof(struct UDP_datagram) + sizeof(struct server_hdr));
     char *ackPacket = (char *) calloc(1, len);
@@ -936,9 +973,15 @@ void write_UDP_AckFIN (struct TransferInfo *stats, int len) {
 #ifdef HAVE_THREAD_DEBUG
 	    thread_debug("UDP server send done-ack w/server-stats to client (sock=%d)", stats->common->socket);
 #endif
-	    rc = write(((stats->common->socketdrop > 0) ? stats->common->socketdrop : stats->common->socket), ackPacket, ackpacket_length);
+	    if (conn != NULL)
+		rc = SSL_write(conn, ackPacket, ackpacket_length);
+	    else
+		rc = write(((stats->common->socketdrop > 0) ? stats->common->socketdrop : stats->common->socket), ackPacket, ackpacket_length);
 #else
-	    rc = write(stats->common->socket, ackPacket, ackpacket_length);
+	    if (conn != NULL)
+		rc = SSL_write(conn, ackPacket, ackpacket_length);
+	    else
+		rc = write(stats->common->socket, ackPacket, ackpacket_length);
 #endif
 	    WARN_errno(rc < 0, "write-ackfin");
 	    // wait here is for silence, no more packets from the client
@@ -65,6 +65,8 @@
 #include "PerfSocket.hpp"
 #include "SocketAddr.h"
 #include "payloads.h"
+#include "iouring.h"
+#include "xdpsock.h"
 #include <cmath>
 #if defined(HAVE_LINUX_FILTER_H) && defined(HAVE_AF_PACKET)
 #include "checksums.h"
@@ -115,7 +117,35 @@ Server::Server (thread_Settings *inSettings) {
     if (sorcvtimer > 0) {
 	SetSocketOptionsReceiveTimeout(mSettings, sorcvtimer);
     }
+    xdp = NULL;
+#if HAVE_AF_XDP
+    // the XSK waits are poll()s, bound them the same as the socket reads
+    xdp_pollms = ((sorcvtimer > 0) ? ((sorcvtimer + 999) / 1000) : -1);
+    xdp_count = 0;
+    xdp_next = 0;
+    xdp_draining = false;
+#endif
     conn = 0;
+    ktls_rx = false;
+    busypoll_flags = 0;
+    rxbuf = mSettings->mBuf;
+#if defined(__linux__)
+    rxb_msgs = NULL;
+    rxb_iov = NULL;
+    rxb_buf = NULL;
+    rxb_ctrl = NULL;
+    rxb_count = 0;
+    rxb_next = 0;
+    rxb_offset = 0;
+#endif
+#if HAVE_SENDFILE_SPLICE
+    sink_pipe[0] = -1;
+    sink_pipe[1] = -1;
+    sink_null = -1;
+#endif
+#if HAVE_BUSY_POLL
+    BusyPollInit();
+#endif
 }
 
 /* -------------------------------------------------------------------
@@ -132,6 +162,12 @@ Server::~Server () {
 	myDropSocket = INVALID_SOCKET;
     }
 #endif
+#if HAVE_SENDFILE_SPLICE
+    FreeNullSink();
+#endif
+#if HAVE_AF_XDP
+    xdpsock_free(xdp);
+#endif
 }
 
 inline bool Server::InProgress () {
@@ -153,16 +189,227 @@ Server :: recvTCP( int fd, void *buf, size_t len, int flags )
             SSL_set_options(conn, SSL_OP_ENABLE_KTLS);
 #endif
             SSL_set_fd(conn, fd);
-            if ( SSL_accept(conn) == -1 )   /* do SSL-protocol accept */
+            int rc;
+            do {
+                rc = SSL_accept(conn);   /* do SSL-protocol accept */
+            } while ((rc <= 0) && tls_async_wait(fd, conn, rc));
+            if (rc == -1)
+                ERR_print_errors_fp(stderr);
+            else if (rc == 1)
+                TLSKernelOffload();
+        }
+        // kTLS, the kernel decrypts the application data records. A plain
+        // recv() fails with EIO on a control record (e.g. an alert or key
+        // update) which is left queued for SSL_read() to handle
+        if (!ktls_rx || (((retval = recv(fd, buf, len, flags)) < 0) && (errno == EIO))) {
+            do {
+                retval = SSL_read(conn, buf, len);
+            } while ((retval <= 0) && tls_async_wait(fd, conn, retval));
+            if (retval < 0)
                 ERR_print_errors_fp(stderr);
         }
-        retval = SSL_read(conn, buf, len);
-        if (retval < 0)
-            ERR_print_errors_fp(stderr);
     }
     return (retval);
 }
 
+#if HAVE_SENDFILE_SPLICE
+bool Server::InitNullSink () {
+    if (pipe2(sink_pipe, O_CLOEXEC) < 0) {
+	WARN_errno(1, "null-sink pipe");
+	sink_pipe[0] = -1;
+	sink_pipe[1] = -1;
+	return false;
+    }
+    // size the pipe to a full read, the kernel rounds up to pages
+    // and an unprivileged request above pipe-max-size just fails
+    if (fcntl(sink_pipe[1], F_SETPIPE_SZ, mSettings->mBufLen) < 0) {
+	WARN_errno(errno != EPERM, "null-sink F_SETPIPE_SZ");
+    }
+    if ((sink_null = open("/dev/null", O_WRONLY | O_CLOEXEC)) < 0) {
+	WARN_errno(1, "null-sink /dev/null");
+	FreeNullSink();
+	return false;
+    }
+    return true;
+}
+
+void Server::FreeNullSink () {
+    if (sink_pipe[0] >= 0) {
+	close(sink_pipe[0]);
+	close(sink_pipe[1]);
+	sink_pipe[0] = -1;
+	sink_pipe[1] = -1;
+    }
+    if (sink_null >= 0) {
+	close(sink_null);
+	sink_null = -1;
+    }
+}
+
+// Same return semantics as recv(), the bytes are moved socket to pipe
+// and then pipe to /dev/null by page reference, never through mBuf
+ssize_t Server::recvNullSink (int fd, size_t len) {
+    ssize_t n = splice(fd, NULL, sink_pipe[1], NULL, len, SPLICE_F_MOVE);
+    if (n > 0) {
+	ssize_t drained = 0;
+	while (drained < n) {
+	    ssize_t m = splice(sink_pipe[0], NULL, sink_null, NULL, n - drained, SPLICE_F_MOVE);
+	    if (m <= 0) {
+		if ((m < 0) && (errno == EINTR))
+		    continue;
+		WARN_errno(1, "null-sink drain");
+		return -1;
+	    }
+	    drained += m;
+	}
+    }
+    return n;
+}
+#endif
+
+#if HAVE_BUSY_POLL
+void Server::BusyPollInit () {
+    busypoll = false;
+    busypoll_sleeping = false;
+    // the L2 checks read the AF_PACKET drop socket
+    if (!isBusyPoll(mSettings) || isL2LengthCheck(mSettings))
+	return;
+    busypoll = true;
+    // the kernel side of the mode, raising it above net.core.busy_read
+    // needs CAP_NET_ADMIN, the user space spin works either way
+    int value = mSettings->mBusyPoll;
+    int rc = setsockopt(mySocket, SOL_SOCKET, SO_BUSY_POLL, reinterpret_cast<char*>(&value), sizeof(value));
+    WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_BUSY_POLL");
+#if defined(SO_PREFER_BUSY_POLL)
+    if (rc != SOCKET_ERROR) {
+	value = 1;
+	rc = setsockopt(mySocket, SOL_SOCKET, SO_PREFER_BUSY_POLL, reinterpret_cast<char*>(&value), sizeof(value));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt SO_PREFER_BUSY_POLL");
+    }
+#endif
+}
+
+// Arm the spin for a read which takes busypoll_flags, i.e. recv(),
+// recvmsg() or recvmmsg() with MSG_DONTWAIT. The read itself is the
+// spin, see BusyPollAgain()
+inline void Server::BusyPollStart () {
+    busypoll_sleeping = false;
+    if (!busypoll)
+	return;
+    clock_gettime(CLOCK_MONOTONIC, &busypoll_start);
+    busypoll_flags = MSG_DONTWAIT;
+}
+
+// Given the result of the non-blocking read, true means go around
+// again. Data, a close or an error the caller will see end the spin.
+// A spent budget clears MSG_DONTWAIT and asks for one more pass, the
+// blocking read which BusyPollDone() accounts as sleep
+inline bool Server::BusyPollAgain (ssize_t rc) {
+    if (!busypoll_flags)
+	return false;
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    intmax_t spun = (static_cast<intmax_t>(t1.tv_sec - busypoll_start.tv_sec) * 1000000000) + (t1.tv_nsec - busypoll_start.tv_nsec);
+    if ((rc >= 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+	reportstruct->busypoll.spin_ns += spun;
+	reportstruct->busypoll.spun++;
+	busypoll_flags = 0;
+	return false;
+    }
+    if ((spun < (static_cast<intmax_t>(mSettings->mBusyPoll) * 1000)) && !sInterupted)
+	return true;
+    reportstruct->busypoll.spin_ns += spun;
+    busypoll_sleeping = true;
+    busypoll_mark = t1;
+    busypoll_flags = 0;
+    return true;
+}
+
+// The TLS record, splice() and burst header reads can't take
+// MSG_DONTWAIT, spin on a non-blocking peek of the socket instead.
+// Bytes the TLS layer already decrypted need no spin at all
+inline void Server::BusyPollSpin (int fd) {
+    if (!busypoll || (conn && (SSL_pending(conn) > 0)))
+	return;
+    char c;
+    BusyPollStart();
+    while (busypoll_flags && BusyPollAgain(recv(fd, &c, 1, MSG_PEEK | busypoll_flags)))
+	;
+}
+
+// The read that follows a spent budget blocks, account it as sleep
+inline void Server::BusyPollDone () {
+    if (busypoll_sleeping) {
+	struct timespec t1;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	reportstruct->busypoll.sleep_ns += (static_cast<intmax_t>(t1.tv_sec - busypoll_mark.tv_sec) * 1000000000) + (t1.tv_nsec - busypoll_mark.tv_nsec);
+	reportstruct->busypoll.slept++;
+	busypoll_sleeping = false;
+    }
+}
+#endif
+
+// Perform the TLS accept as its own phase rather than lazily
+// within the first read, see recvTCP
+bool Server::TLSHandshake () {
+    Timestamp hs_start;
+    int rc;
+    assert(conn == 0);
+    conn = SSL_new(mSettings->ssl_ctx);
+#ifdef __FreeBSD__
+    SSL_set_options(conn, SSL_OP_ENABLE_KTLS);
+#endif
+    if (isUDP(mSettings))
+	dtls_set_socket(conn, mSettings->mSock, &mSettings->peer, mSettings->mBufLen);
+    else
+	SSL_set_fd(conn, mSettings->mSock);
+    mSettings->tlshandshakeflags = 0;
+    // TLS 1.3 0-RTT, early data must be read prior to completing the handshake
+    if (SSL_CTX_get_max_early_data(mSettings->ssl_ctx) > 0) {
+	size_t readbytes;
+	do {
+	    readbytes = 0;
+	    rc = SSL_read_early_data(conn, mSettings->mBuf, mSettings->mBufLen, &readbytes);
+	    if (rc == SSL_READ_EARLY_DATA_SUCCESS) {
+		mSettings->firstreadbytes += readbytes;
+		mSettings->tlshandshakeflags |= TLSHS_EARLYDATA;
+	    }
+	} while ((rc == SSL_READ_EARLY_DATA_SUCCESS) || \
+		 ((rc == SSL_READ_EARLY_DATA_ERROR) && tls_async_wait(mSettings->mSock, conn, 0)));
+    }
+    do {
+	rc = SSL_accept(conn);   /* do SSL-protocol accept */
+    } while ((rc <= 0) && (dtls_timer_wait(mSettings->mSock, conn, rc) || tls_async_wait(mSettings->mSock, conn, rc)));
+    Timestamp hs_done;
+    if (rc == 1) {
+	mSettings->tlshandshaketime = 1e3 * hs_done.subSec(hs_start);
+	if (SSL_session_reused(conn))
+	    mSettings->tlshandshakeflags |= TLSHS_RESUMED;
+	TLSKernelOffload();
+    } else {
+	ERR_print_errors_fp(stderr);
+	mSettings->tlshandshaketime = -1;
+    }
+    return (rc == 1);
+}
+
+// See Client::TLSKernelOffload, the server is the reader
+void Server::TLSKernelOffload () {
+    ktls_rx = false;
+#ifdef SSL_OP_ENABLE_KTLS
+    if (!isKTLS(mSettings) || (conn == 0))
+	return;
+    if (BIO_get_ktls_recv(SSL_get_rbio(conn))) {
+	ktls_rx = true;
+	mSettings->tlshandshakeflags |= TLSHS_KTLS_RX;
+    }
+    if (BIO_get_ktls_send(SSL_get_wbio(conn)))
+	mSettings->tlshandshakeflags |= TLSHS_KTLS_TX;
+    if (!ktls_rx)
+	fprintf(stderr, "WARN: kTLS receive offload not enabled (check the tls kernel module and cipher), using OpenSSL records\n");
+#endif
+}
+
 /* -------------------------------------------------------------------
  * Receive TCP data from the (connected) socket.
  * Sends termination flag several times at the end.
@@ -174,6 +421,9 @@ void Server::RunTCP () {
     struct TCP_burst_payload burst_info;
     Timestamp time1, time2;
     double tokens=0.000004;
+#if HAVE_SENDFILE_SPLICE
+    bool nullsink = false;
+#endif
 
     if (!InitTrafficLoop())
 	return;
@@ -184,6 +434,15 @@ void Server::RunTCP () {
 
     burst_info.send_tt.write_tv_sec = 0;
     burst_info.send_tt.write_tv_usec = 0;
+#if HAVE_IO_URING
+    // the burst headers, TLS and read rate limiting stay with the recv() loop
+    if (isIOUring(mSettings) && !isburst && !isSSL(mSettings) && !isBWSet(mSettings) && RunTCPUring())
+	goto Done;
+#endif
+#if HAVE_SENDFILE_SPLICE
+    // the burst headers and TLS records need the payload in mBuf
+    nullsink = (isNullSink(mSettings) && !isburst && !isSSL(mSettings) && InitNullSink());
+#endif
     now.setnow();
     reportstruct->packetTime.tv_sec = now.getSecs();
     reportstruct->packetTime.tv_usec = now.getUsecs();
@@ -205,7 +464,14 @@ void Server::RunTCP () {
 		readLen = (mSettings->mBufLen < burst_nleft) ? mSettings->mBufLen : burst_nleft;
 	    reportstruct->emptyreport=1;
 	    if (isburst && (burst_nleft == 0)) {
-		if ((n = recvn(mSettings->mSock, conn, reinterpret_cast<char *>(&burst_info), sizeof(struct TCP_burst_payload), 0)) == sizeof(struct TCP_burst_payload)) {
+#if HAVE_BUSY_POLL
+		BusyPollSpin(mSettings->mSock);
+#endif
+		n = recvn(mSettings->mSock, conn, reinterpret_cast<char *>(&burst_info), sizeof(struct TCP_burst_payload), 0);
+#if HAVE_BUSY_POLL
+		BusyPollDone();
+#endif
+		if (n == sizeof(struct TCP_burst_payload)) {
 		    // burst_info.typelen.type = ntohl(burst_info.typelen.type);
 		    // burst_info.typelen.length = ntohl(burst_info.typelen.length);
 		    burst_info.flags = ntohl(burst_info.flags);
@@ -246,7 +512,30 @@ void Server::RunTCP () {
 		}
 	    }
 	    if (!reportstruct->transit_ready) {
-		n = recvTCP(mSettings->mSock, mSettings->mBuf, readLen, 0);
+#if HAVE_SENDFILE_SPLICE
+		if (nullsink) {
+#if HAVE_BUSY_POLL
+		    BusyPollSpin(mSettings->mSock);
+#endif
+		    n = recvNullSink(mSettings->mSock, readLen);
+		} else
+#endif
+		{
+#if HAVE_BUSY_POLL
+		    if (isSSL(mSettings) && !ktls_rx)
+			BusyPollSpin(mSettings->mSock);
+		    else
+			BusyPollStart();
+		    do {
+#endif
+		    n = recvTCP(mSettings->mSock, mSettings->mBuf, readLen, busypoll_flags);
+#if HAVE_BUSY_POLL
+		    } while (BusyPollAgain(n));
+#endif
+		}
+#if HAVE_BUSY_POLL
+		BusyPollDone();
+#endif
 		if (n > 0) {
 		    reportstruct->emptyreport = 0;
 		    if (isburst) {
@@ -289,12 +578,29 @@ void Server::RunTCP () {
 	}
     }
   Done:
+    FinishTCP();
+}
+
+// The end of a TCP stream, the final report and the close
+void Server::FinishTCP () {
     disarm_itimer();
     // stop timing
     now.setnow();
     reportstruct->packetTime.tv_sec = now.getSecs();
     reportstruct->packetTime.tv_usec = now.getUsecs();
     reportstruct->packetLen = 0;
+    // Answer the peer's close_notify, otherwise OpenSSL drops the
+    // session from the server cache and it can't be resumed
+    if (isSSL(mSettings) && (conn != 0) && peerclose)
+	SSL_shutdown(conn);
+    // A TLS handshake rate test, i.e. --tls-handshake on the server or a
+    // resumed or 0-RTT handshake, drops the active host entry before the
+    // final report so a back-to-back connection from the same peer can't
+    // pick up a sum report the reporter is about to free
+    bool hsrate = isSSL(mSettings) && ((mSettings->mTLSHandshakeMode != kTLSHandshake_Full) || \
+					(mSettings->tlshandshakeflags & (TLSHS_RESUMED | TLSHS_EARLYDATA)));
+    if (hsrate)
+	Iperf_remove_host(mSettings);
     if (EndJob(myJob, reportstruct)) {
 #if HAVE_THREAD_DEBUG
 	thread_debug("tcp close sock=%d", mySocket);
@@ -302,13 +608,197 @@ void Server::RunTCP () {
 	int rc = close(mySocket);
 	WARN_errno(rc == SOCKET_ERROR, "server close");
     }
-    Iperf_remove_host(mSettings);
+    if (!hsrate)
+	Iperf_remove_host(mSettings);
     FreeReport(myJob);
 
     if (isSSL(mSettings) && conn != 0)
         SSL_free(conn);
 }
 
+#if HAVE_WORKER_POOL
+// --worker-pool, the setup of RunTCP() for a stream whose reads are
+// driven by a worker's epoll loop. The listener only hands over the
+// plain TCP streams, i.e. no burst headers, TLS or read rate limit.
+bool Server::PollStart () {
+    if (!InitTrafficLoop())
+	return false;
+    myReport->info.ts.prevsendTime = myReport->info.ts.startTime;
+    now.setnow();
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    return InProgress();
+}
+
+// Read what the socket has queued, up to a budget so one busy stream
+// can't starve the others on the same worker. Each read is reported
+// just as in RunTCP()
+bool Server::PollRead () {
+    for (int ix = 0; ix < WORKERREADBUDGET; ix++) {
+	int n = static_cast<int>(recvTCP(mySocket, mSettings->mBuf, mSettings->mBufLen, MSG_DONTWAIT));
+	reportstruct->emptyreport = 1;
+	reportstruct->transit_ready = 0;
+	if (n > 0) {
+	    reportstruct->emptyreport = 0;
+	} else if (n == 0) {
+	    peerclose = true;
+#ifdef HAVE_THREAD_DEBUG
+	    thread_debug("Server worker detected EOF on socket %d", mySocket);
+#endif
+	} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+	    break;
+	} else {
+	    if (FATALTCPREADERR(errno)) {
+		WARN_errno(1, "recv");
+		peerclose = true;
+	    }
+	    n = 0;
+	}
+	now.setnow();
+	reportstruct->packetTime.tv_sec = now.getSecs();
+	reportstruct->packetTime.tv_usec = now.getUsecs();
+	reportstruct->packetLen = n;
+	ReportPacket(myReport, reportstruct);
+	// a short read most likely emptied the socket, save the EAGAIN
+	if (!InProgress() || (n < mSettings->mBufLen))
+	    break;
+    }
+    return InProgress();
+}
+
+// An idle stream still needs its interval reports and the end of test
+// check, i.e. what the receive timeout does for RunTCP()
+bool Server::PollTick () {
+    now.setnow();
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    reportstruct->emptyreport = 1;
+    reportstruct->packetLen = 0;
+    ReportPacket(myReport, reportstruct);
+    return InProgress();
+}
+#endif
+
+#if HAVE_IO_URING
+// TCP reads on io_uring, --io-uring. One multishot receive stays armed on
+// the registered socket and the kernel picks the buffer for each read from
+// a provided buffer ring, i.e. no recv() per read and one io_uring_enter()
+// can reap many reads. Each completion is reported as a read. Returns
+// false if the ring can't be set up so the caller runs the recv() loop.
+bool Server::RunTCPUring () {
+    unsigned count = 1;
+    while (count < static_cast<unsigned>(mSettings->mIOUringDepth))
+	count <<= 1;
+    struct iouring *ring = iouring_init(count);
+    if (!ring) {
+	WARN_errno(1, "io_uring_setup, using the recv() loop");
+	return false;
+    }
+    // Without a timed wait an idle socket would block the interval
+    // reports and the -t end check in io_uring_enter()
+    if (!ring->ext_arg) {
+	fprintf(stderr, "WARN: io_uring timed waits (IORING_FEAT_EXT_ARG) not supported by the kernel, using the recv() loop\n");
+	iouring_free(ring);
+	return false;
+    }
+    // an older kernel would fail the armed receive, i.e. end the stream
+    if (!iouring_probe_recv_multishot(ring)) {
+	fprintf(stderr, "WARN: io_uring multishot receive not supported by the kernel, using the recv() loop\n");
+	iouring_free(ring);
+	return false;
+    }
+    char *pool = new char[static_cast<size_t>(count) * mSettings->mBufLen];
+    int rc = iouring_buf_ring_init(ring, 0, pool, count, mSettings->mBufLen);
+    if (rc < 0) {
+	errno = -rc;
+	WARN_errno(1, "io_uring buffer ring, using the recv() loop");
+	iouring_free(ring);
+	DELETE_ARRAY(pool);
+	return false;
+    }
+    bool fixedfile = (iouring_register_files(ring, &mySocket, 1) == 0);
+    bool armed = false;
+    intmax_t totLen = 0;
+    now.setnow();
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    while (InProgress()) {
+	if (!armed) {
+	    struct io_uring_sqe *sqe = iouring_get_sqe(ring);
+	    assert(sqe != NULL);
+	    sqe->opcode = IORING_OP_RECV;
+	    sqe->fd = (fixedfile ? 0 : mySocket);
+	    sqe->flags = IOSQE_BUFFER_SELECT | (fixedfile ? IOSQE_FIXED_FILE : 0);
+	    sqe->ioprio = IORING_RECV_MULTISHOT;
+	    sqe->buf_group = 0;
+	    armed = true;
+	}
+	rc = iouring_submit(ring, 1, IOURINGWAITUSEC);
+	if (rc == -ETIME) {
+	    // like a recv() timeout, move the reporter's time forward
+	    now.setnow();
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+	    reportstruct->emptyreport = 1;
+	    reportstruct->packetLen = 0;
+	    ReportPacket(myReport, reportstruct);
+	} else if ((rc < 0) && (rc != -EINTR) && (rc != -EAGAIN) && (rc != -EBUSY)) {
+	    errno = -rc;
+	    WARN_errno(1, "io_uring_enter");
+	    break;
+	}
+	struct io_uring_cqe *cqe;
+	while ((cqe = iouring_peek_cqe(ring)) != NULL) {
+	    int res = cqe->res;
+	    unsigned flags = cqe->flags;
+	    iouring_cqe_seen(ring);
+	    // the kernel disarms the receive on errors and ENOBUFS
+	    if (!(flags & IORING_CQE_F_MORE))
+		armed = false;
+	    if (flags & IORING_CQE_F_BUFFER)
+		iouring_buf_ring_recycle(ring, static_cast<unsigned short>(flags >> IORING_CQE_BUFFER_SHIFT));
+	    if (res > 0)
+		totLen += res;
+	    if (!UringRecv(res))
+		break;
+	}
+	// Check for reverse and amount where the server stops after
+	// receiving the expected byte count
+	if (isReverse(mSettings) && !isModeTime(mSettings) && (totLen >= static_cast<intmax_t>(mSettings->mAmount))) {
+	    break;
+	}
+    }
+    iouring_free(ring);
+    DELETE_ARRAY(pool);
+    return true;
+}
+
+// A multishot receive completion, reported as a read. Returns false
+// when the stream is done, e.g. the peer closed or a fatal error
+bool Server::UringRecv (int res) {
+    reportstruct->emptyreport = 1;
+    reportstruct->packetLen = 0;
+    if (res > 0) {
+	reportstruct->emptyreport = 0;
+	reportstruct->packetLen = res;
+    } else if (res == 0) {
+	peerclose = true;
+#ifdef HAVE_THREAD_DEBUG
+	thread_debug("Server thread detected EOF on socket %d", mSettings->mSock);
+#endif
+    } else if ((res != -ENOBUFS) && (res != -ECANCELED) && FATALTCPREADERR(-res)) {
+	errno = -res;
+	WARN_errno(1, "recv");
+	peerclose = true;
+    }
+    now.setnow();
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    ReportPacket(myReport, reportstruct);
+    return InProgress();
+}
+#endif
+
 void Server::RunTcpBounceBack () {
 }
 
@@ -410,7 +900,7 @@ void Server::ClientReverseFirstRead (void) {
 		FAIL_errno(1, "recvn-reverse", mSettings);
 		break;
 	    default :
-		struct client_udp_testhdr *udp_pkt = reinterpret_cast<struct client_udp_testhdr *>(mSettings->mBuf);
+		struct client_udp_testhdr *udp_pkt = reinterpret_cast<struct client_udp_testhdr *>(rxbuf);
 		flags = ntohl(udp_pkt->base.flags);
 		if (isTripTime(mSettings)) {
 		    mSettings->sent_time.tv_sec = ntohl(udp_pkt->start_fq.start_tv_sec);
@@ -497,8 +987,19 @@ bool Server::InitTrafficLoop (void) {
 	    mSettings->accept_time.tv_usec = now.getUsecs();
 	}
     }
+    if (isSSL(mSettings) && !isFullDuplex(mSettings)) {
+	// Keep the TLS (or DTLS) handshake out of the traffic intervals
+	if (TLSHandshake() && TimeZero(mSettings->sent_time)) {
+	    now.setnow();
+	    mSettings->accept_time.tv_sec = now.getSecs();
+	    mSettings->accept_time.tv_usec = now.getUsecs();
+	}
+    }
     SetReportStartTime();
     reportstruct->prevPacketTime = myReport->info.ts.startTime;
+    if (isCPUStats(mSettings) && !isUDP(mSettings)) {
+	InitCPUStats(myReport);
+    }
 
     if (setfullduplexflag)
 	SetFullDuplexReportStartTime();
@@ -543,20 +1044,26 @@ inline int Server::ReadWithRxTimestamp () {
     long currLen;
     int tsdone = 0;
 
+    if (conn != 0) {
+	// DTLS, the rx time is taken after the record is decrypted so
+	// the one way delay and jitter include the crypto
+	currLen = SSL_read(conn, mSettings->mBuf, mSettings->mBufLen);
+    } else {
 #if HAVE_DECL_SO_TIMESTAMP
-    cmsg = reinterpret_cast<struct cmsghdr *>(&ctrl);
-    currLen = recvmsg(mSettings->mSock, &message, mSettings->recvflags);
-    if (currLen > 0) {
-	if (cmsg->cmsg_level == SOL_SOCKET &&
-	    cmsg->cmsg_type  == SCM_TIMESTAMP &&
-	    cmsg->cmsg_len   == CMSG_LEN(sizeof(struct timeval))) {
-	    memcpy(&(reportstruct->packetTime), CMSG_DATA(cmsg), sizeof(struct timeval));
-	    tsdone = 1;
+	cmsg = reinterpret_cast<struct cmsghdr *>(&ctrl);
+	currLen = recvmsg(mSettings->mSock, &message, (mSettings->recvflags | busypoll_flags));
+	if (currLen > 0) {
+	    if (cmsg->cmsg_level == SOL_SOCKET &&
+		cmsg->cmsg_type  == SCM_TIMESTAMP &&
+		cmsg->cmsg_len   == CMSG_LEN(sizeof(struct timeval))) {
+		memcpy(&(reportstruct->packetTime), CMSG_DATA(cmsg), sizeof(struct timeval));
+		tsdone = 1;
+	    }
 	}
-    }
 #else
-    currLen = recv(mSettings->mSock, mSettings->mBuf, mSettings->mBufLen, mSettings->recvflags);
+	currLen = recv(mSettings->mSock, mSettings->mBuf, mSettings->mBufLen, (mSettings->recvflags | busypoll_flags));
 #endif
+    }
     if (currLen <=0) {
 	// Socket read timeout or read error
 	reportstruct->emptyreport=1;
@@ -578,10 +1085,220 @@ inline int Server::ReadWithRxTimestamp () {
     return currLen;
 }
 
+#if defined(__linux__)
+// Per message control space, the rx timestamp and the GRO segment size
+#define RXBATCHCTRLLEN (CMSG_SPACE(sizeof(struct timeval)) + CMSG_SPACE(sizeof(int)))
+
+void Server::InitReadBatch () {
+    int batch = mSettings->mUDPBatch;
+    // a GRO read can carry up to 64KB of coalesced datagrams
+    rxb_slotsize = (isUDPGRO(mSettings) ? UDPGSOMAXPAYLOAD : mSettings->mBufLen);
+    rxb_msgs = new struct mmsghdr[batch];
+    rxb_iov = new struct iovec[batch];
+    rxb_buf = new char[batch * rxb_slotsize];
+    rxb_ctrl = new char[batch * RXBATCHCTRLLEN];
+    memset(rxb_msgs, 0, sizeof(struct mmsghdr) * batch);
+    for (int ix = 0; ix < batch; ix++) {
+	rxb_iov[ix].iov_base = rxb_buf + (ix * rxb_slotsize);
+	rxb_iov[ix].iov_len = rxb_slotsize;
+	rxb_msgs[ix].msg_hdr.msg_iov = &rxb_iov[ix];
+	rxb_msgs[ix].msg_hdr.msg_iovlen = 1;
+    }
+#ifdef UDP_GRO
+    if (isUDPGRO(mSettings)) {
+	int one = 1;
+	int rc = setsockopt(mySocket, IPPROTO_UDP, UDP_GRO, &one, sizeof(one));
+	WARN_errno(rc == SOCKET_ERROR, "setsockopt UDP_GRO");
+    }
+#endif
+    rxb_count = 0;
+    rxb_next = 0;
+    rxb_offset = 0;
+}
+
+void Server::FreeReadBatch () {
+    DELETE_ARRAY(rxb_msgs);
+    DELETE_ARRAY(rxb_iov);
+    DELETE_ARRAY(rxb_buf);
+    DELETE_ARRAY(rxb_ctrl);
+    rxbuf = mSettings->mBuf;
+}
+
+// The recvmmsg() version of ReadWithRxTimestamp. One system call fills
+// up to mUDPBatch slots, each with its own SCM_TIMESTAMP, and the calls
+// that follow hand back one datagram at a time so the packet processing
+// and the packet ring are the same as the single read. A GRO slot holds
+// several datagrams of gso_size bytes (the last may be short) that share
+// the one rx timestamp.
+inline int Server::ReadBatchWithRxTimestamp () {
+    long currLen;
+    int tsdone = 0;
+
+    if (rxb_next >= rxb_count) {
+	for (int ix = 0; ix < mSettings->mUDPBatch; ix++) {
+	    rxb_msgs[ix].msg_hdr.msg_control = rxb_ctrl + (ix * RXBATCHCTRLLEN);
+	    rxb_msgs[ix].msg_hdr.msg_controllen = RXBATCHCTRLLEN;
+	    rxb_msgs[ix].msg_hdr.msg_flags = 0;
+	}
+	rxb_count = recvmmsg(mySocket, rxb_msgs, mSettings->mUDPBatch, (mSettings->recvflags | MSG_WAITFORONE | busypoll_flags), NULL);
+	rxb_next = 0;
+	rxb_offset = 0;
+	if (rxb_count <= 0) {
+	    currLen = rxb_count;
+	    rxb_count = 0;
+	    // Socket read timeout or read error
+	    reportstruct->emptyreport=1;
+	    if (currLen == 0) {
+		peerclose = true;
+	    } else if (FATALUDPREADERR(errno)) {
+		WARN_errno(1, "recvmmsg");
+		currLen = 0;
+		peerclose = true;
+	    }
+	    now.setnow();
+	    reportstruct->packetTime.tv_sec = now.getSecs();
+	    reportstruct->packetTime.tv_usec = now.getUsecs();
+	    return currLen;
+	}
+    }
+    struct msghdr *msg = &rxb_msgs[rxb_next].msg_hdr;
+    char *slot = rxb_buf + (rxb_next * rxb_slotsize);
+    int total = rxb_msgs[rxb_next].msg_len;
+    int gso_size = 0;
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(msg); cm != NULL; cm = CMSG_NXTHDR(msg, cm)) {
+	if ((cm->cmsg_level == SOL_SOCKET) && (cm->cmsg_type == SCM_TIMESTAMP) && \
+	    (cm->cmsg_len == CMSG_LEN(sizeof(struct timeval)))) {
+	    memcpy(&(reportstruct->packetTime), CMSG_DATA(cm), sizeof(struct timeval));
+	    tsdone = 1;
+	}
+#ifdef UDP_GRO
+	if ((cm->cmsg_level == IPPROTO_UDP) && (cm->cmsg_type == UDP_GRO)) {
+	    memcpy(&gso_size, CMSG_DATA(cm), sizeof(int));
+	}
+#endif
+    }
+    if ((gso_size > 0) && (total > gso_size)) {
+	// split the coalesced read, the bytes past the slot were truncated
+	int avail = (total < rxb_slotsize) ? total : rxb_slotsize;
+	rxbuf = slot + rxb_offset;
+	currLen = ((avail - rxb_offset) < gso_size) ? (avail - rxb_offset) : gso_size;
+	rxb_offset += currLen;
+	if (rxb_offset >= avail) {
+	    rxb_next++;
+	    rxb_offset = 0;
+	}
+    } else {
+	rxbuf = slot;
+	currLen = total;
+	rxb_next++;
+    }
+    if (TimeZero(myReport->info.ts.prevpacketTime)) {
+	myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+    }
+    if (!tsdone) {
+	now.setnow();
+	reportstruct->packetTime.tv_sec = now.getSecs();
+	reportstruct->packetTime.tv_usec = now.getUsecs();
+    }
+    return currLen;
+}
+#endif
+
+#if HAVE_AF_XDP
+// The listener took the flow's first datagram from the stack, from here
+// on a program on the interface redirects the rest of the flow, i.e. the
+// peer's address and port to the local port, to the XSK on the queue.
+// Any failure, e.g. the interface already has a program, leaves the
+// traffic on the socket
+void Server::XdpInit () {
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    char ifname[IFNAMSIZ];
+    int ifindex = 0;
+    if ((getsockname(mySocket, reinterpret_cast<struct sockaddr *>(&local), &len) == 0) && (local.sin_family == AF_INET)) {
+	len = sizeof(xdp_peer);
+	if (getpeername(mySocket, reinterpret_cast<struct sockaddr *>(&xdp_peer), &len) == 0)
+	    ifindex = xdpsock_ifindex(&local, ifname);
+    }
+    if (!ifindex) {
+	WARN(1, "af-xdp: no interface holds the local address, using the socket");
+	return;
+    }
+    if (!(xdp = xdpsock_init(ifindex, mSettings->mXdpQueue, true))) {
+	WARN_errno(1, "af-xdp socket, using the socket");
+	return;
+    }
+    int rc = xdpsock_redirect(xdp, &local, &xdp_peer);
+    if (rc < 0) {
+	errno = -rc;
+	WARN_errno(1, "af-xdp redirect program, using the socket");
+	xdpsock_free(xdp);
+	xdp = NULL;
+    } else {
+	xdp_draining = true;
+    }
+}
+
+// The XSK version of ReadWithRxTimestamp. A batch of frames is taken off
+// the rx ring and handed back one datagram at a time, the frames return
+// to the fill ring with the next batch. Datagrams that beat the redirect,
+// i.e. queued before the program was attached, are read from the socket
+// first, which keeps them in order. There are no kernel rx timestamps in
+// copy mode
+inline int Server::ReadXdpWithRxTimestamp () {
+    int currLen = -1;
+    if (xdp_draining) {
+	struct pollfd pfd;
+	pfd.fd = mySocket;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, 0) > 0) {
+	    rxbuf = mSettings->mBuf;
+	    return ReadWithRxTimestamp();
+	}
+	xdp_draining = false;
+    }
+    if (xdp_next >= xdp_count) {
+	xdpsock_rx_release(xdp, xdp_count);
+	xdp_next = 0;
+	if (!(xdp_count = xdpsock_rx_peek(xdp, XDPSOCK_BATCH))) {
+	    struct pollfd fds[2];
+	    fds[0].fd = mySocket;
+	    fds[0].events = POLLIN;
+	    fds[1].fd = xdp->fd;
+	    fds[1].events = POLLIN;
+	    if ((poll(fds, 2, xdp_pollms) > 0) && (fds[0].revents & POLLIN)) {
+		rxbuf = mSettings->mBuf;
+		return ReadWithRxTimestamp();
+	    }
+	    xdp_count = xdpsock_rx_peek(xdp, XDPSOCK_BATCH);
+	}
+    }
+    if (xdp_next < xdp_count) {
+	char *payload = xdpsock_udp4_rx(xdp, xdp_next++, &xdp_peer, &currLen);
+	if (payload) {
+	    rxbuf = payload;
+	} else {
+	    // not a datagram of the flow, e.g. a truncated frame
+	    currLen = -1;
+	}
+    }
+    now.setnow();
+    reportstruct->packetTime.tv_sec = now.getSecs();
+    reportstruct->packetTime.tv_usec = now.getUsecs();
+    if (currLen < 0) {
+	// the XSK wait timed out
+	reportstruct->emptyreport=1;
+    } else if (TimeZero(myReport->info.ts.prevpacketTime)) {
+	myReport->info.ts.prevpacketTime = reportstruct->packetTime;
+    }
+    return currLen;
+}
+#endif
+
 // Returns true if the client has indicated this is the final packet
 inline bool Server::ReadPacketID () {
     bool terminate = false;
-    struct UDP_datagram* mBuf_UDP  = reinterpret_cast<struct UDP_datagram*>(mSettings->mBuf + mSettings->l4payloadoffset);
+    struct UDP_datagram* mBuf_UDP  = reinterpret_cast<struct UDP_datagram*>(rxbuf + mSettings->l4payloadoffset);
 
     // terminate when datagram begins with negative index
     // the datagram ID should be correct, just negated
@@ -736,7 +1453,7 @@ inline void Server::udp_isoch_processing (int rxlen) {
 	reportstruct->remaining = 0;
 	reportstruct->frameID = 0;
     } else {
-	struct client_udp_testhdr *udp_pkt = reinterpret_cast<struct client_udp_testhdr *>(mSettings->mBuf);
+	struct client_udp_testhdr *udp_pkt = reinterpret_cast<struct client_udp_testhdr *>(rxbuf);
 	reportstruct->isochStartTime.tv_sec = ntohl(udp_pkt->isoch.start_tv_sec);
 	reportstruct->isochStartTime.tv_usec = ntohl(udp_pkt->isoch.start_tv_usec);
 	reportstruct->frameID = ntohl(udp_pkt->isoch.frameid);
@@ -761,6 +1478,16 @@ void Server::RunUDP () {
 
     if (!InitTrafficLoop())
 	return;
+#if defined(__linux__)
+    // batched reads don't apply to the L2 (AF_PACKET) length checks
+    bool readbatch = (isUDPBatch(mSettings) && !isL2LengthCheck(mSettings) && (conn == 0));
+    if (readbatch)
+	InitReadBatch();
+#endif
+#if HAVE_AF_XDP
+    if (isAFXDP(mSettings) && (conn == 0) && !isL2LengthCheck(mSettings))
+	XdpInit();
+#endif
 
     // Exit loop on three conditions
     // 1) Fatal read error
@@ -777,7 +1504,33 @@ void Server::RunUDP () {
 	reportstruct->packetLen=0;
 	// read the next packet with timestamp
 	// will also set empty report or not
+#if HAVE_BUSY_POLL
+	// a batch still holding datagrams doesn't touch the socket, the
+	// DTLS and AF_XDP reads can't take MSG_DONTWAIT
+	bool spin = (!readbatch || (rxb_next >= rxb_count));
+	if (spin) {
+	    if (conn || xdp)
+		BusyPollSpin(mSettings->mSock);
+	    else
+		BusyPollStart();
+	}
+	do {
+#endif
+#if HAVE_AF_XDP
+	if (xdp)
+	    rxlen = ReadXdpWithRxTimestamp();
+	else
+#endif
+#if defined(__linux__)
+	rxlen = (readbatch ? ReadBatchWithRxTimestamp() : ReadWithRxTimestamp());
+#else
 	rxlen=ReadWithRxTimestamp();
+#endif
+#if HAVE_BUSY_POLL
+	} while (BusyPollAgain(rxlen));
+	if (spin)
+	    BusyPollDone();
+#endif
 	if (!peerclose && (rxlen > 0)) {
 	    reportstruct->emptyreport = 0;
 	    reportstruct->packetLen = rxlen;
@@ -805,13 +1558,17 @@ void Server::RunUDP () {
 	ReportPacket(myReport, reportstruct);
     }
     disarm_itimer();
+#if defined(__linux__)
+    if (readbatch)
+	FreeReadBatch();
+#endif
     int do_close = EndJob(myJob, reportstruct);
     if (!isMulticast(mSettings) && !isNoUDPfin(mSettings)) {
 	// send a UDP acknowledgement back except when:
 	// 1) we're NOT receiving multicast
 	// 2) the user requested no final exchange
 	// 3) this is a full duplex test
-	write_UDP_AckFIN(&myReport->info, mSettings->mBufLen);
+	write_UDP_AckFIN(&myReport->info, conn, mSettings->mBufLen);
     }
     if (do_close) {
 #if HAVE_THREAD_DEBUG
@@ -822,6 +1579,9 @@ void Server::RunUDP () {
     }
     Iperf_remove_host(mSettings);
     FreeReport(myJob);
+
+    if (isSSL(mSettings) && conn != 0)
+        SSL_free(conn);
 }
 
 // end Recv
@@ -109,6 +109,33 @@ static int hideips = 0;
 static int bounceback = 0;
 static int tcpdrain;
 static int overridetos;
+static int tlsasync;
+static int tlshandshake;
+static int tlsciphers;
+static int tlsciphersuites;
+static int tlsgroups;
+static int tlscert;
+static int tlskey;
+static int tlsciphersweep;
+static int tlsengine;
+static int tlsengineab;
+static int cpustats;
+static int tlscoalesce;
+static int tlsrekey;
+static int udpbatch;
+static int udpgso;
+static int udpgro;
+static int zerocopy;
+static int iouring;
+static int workerpool;
+static int listenshards;
+static int sendfilex;
+static int nullsink;
+static int txtime;
+static int busypoll;
+static int afxdp;
+static int reporterthreads;
+static int reporterstats;
 
 void Settings_Interpret(char option, const char *optarg, struct thread_Settings *mExtSettings);
 // apply compound settings after the command line has been fully parsed
@@ -241,6 +268,33 @@ const struct option long_options[] =
 #endif
 {"tls",        optional_argument, NULL, 'E'},
 {"ktls",             no_argument, NULL, 'K'},
+{"tls-async", optional_argument, &tlsasync, 1},
+{"tls-handshake", required_argument, &tlshandshake, 1},
+{"tls-ciphers", required_argument, &tlsciphers, 1},
+{"tls-ciphersuites", required_argument, &tlsciphersuites, 1},
+{"tls-groups", required_argument, &tlsgroups, 1},
+{"tls-cert", required_argument, &tlscert, 1},
+{"tls-key", required_argument, &tlskey, 1},
+{"tls-cipher-sweep", required_argument, &tlsciphersweep, 1},
+{"tls-engine", required_argument, &tlsengine, 1},
+{"tls-engine-ab", no_argument, &tlsengineab, 1},
+{"cpu-stats", optional_argument, &cpustats, 1},
+{"tls-coalesce", optional_argument, &tlscoalesce, 1},
+{"tls-rekey", optional_argument, &tlsrekey, 1},
+{"udp-batch", optional_argument, &udpbatch, 1},
+{"udp-gso", no_argument, &udpgso, 1},
+{"udp-gro", no_argument, &udpgro, 1},
+{"zerocopy", no_argument, &zerocopy, 1},
+{"io-uring", optional_argument, &iouring, 1},
+{"worker-pool", optional_argument, &workerpool, 1},
+{"listen-shards", optional_argument, &listenshards, 1},
+{"sendfile", no_argument, &sendfilex, 1},
+{"null-sink", no_argument, &nullsink, 1},
+{"txtime", optional_argument, &txtime, 1},
+{"busy-poll", optional_argument, &busypoll, 1},
+{"af-xdp", optional_argument, &afxdp, 1},
+{"reporter-threads", optional_argument, &reporterthreads, 1},
+{"reporter-stats", no_argument, &reporterstats, 1},
 {0, 0, 0, 0}
 };
 
@@ -303,6 +357,10 @@ const int  kDefault_UDPBufLen = 1470;      // -u  if set, read/write 1470 bytes
 
 // v4: 1470 bytes UDP payload will fill one and only one ethernet datagram (IPv4 overhead is 20 bytes)
 const int  kDefault_UDPBufLenV6 = 1450;      // -u  if set, read/write 1470 bytes
+const int  kDefault_UDPBatch = 32;           // --udp-batch datagrams per send call
+const int  kDefault_IOUringDepth = 32;       // --io-uring operations in flight
+const int  kDefault_TxTimeLead = 2000;       // --txtime launch window, usecs
+const int  kDefault_BusyPoll = 50;           // --busy-poll spin per read, usecs
 // v6: 1450 bytes UDP payload will fill one and only one ethernet datagram (IPv6 overhead is 40 bytes)
 const int kDefault_TCPBufLen = 128 * 1024; // TCP default read/write size
 
@@ -320,6 +378,7 @@ void Settings_Initialize (struct thread_Settings *main) {
     main->flags         = FLAG_MODETIME | FLAG_STDOUT; // Default time and stdout
     main->flags_extend  = 0x0;           // Default all extend flags to off
     main->flags_extend2 = 0x0;           // Default all extend flags to off
+    main->flags_extend3 = 0x0;           // Default all extend flags to off
     //main->mAppRate      = 0;           // -b,  offered (or rate limited) load (both UDP and TCP)
     main->mAppRateUnits = kRate_BW;
     //main->mHost         = NULL;        // -c,  none, required for client
@@ -371,6 +430,14 @@ void Settings_Copy (struct thread_Settings *from, struct thread_Settings **into,
     memcpy(*into, from, sizeof(struct thread_Settings));
     (*into)->mSumReport = NULL;
     (*into)->mTransferIDStr = NULL;
+    // The TLS strings are only used to set up the shared ssl_ctx
+    (*into)->mTLSCipherList = NULL;
+    (*into)->mTLSCipherSuites = NULL;
+    (*into)->mTLSGroups = NULL;
+    (*into)->mTLSCertFile = NULL;
+    (*into)->mTLSKeyFile = NULL;
+    (*into)->mTLSCipherSweep = NULL;
+    (*into)->mTLSEngine = NULL;
 
 #ifdef HAVE_THREAD_DEBUG
     thread_debug("Copy thread settings (malloc) from/to=%p/%p report/sum/fullduplex %p/%p/%p", \
@@ -484,6 +551,13 @@ void Settings_Destroy (struct thread_Settings *mSettings) {
     FREE_ARRAY(mSettings->mIfrnametx);
     FREE_ARRAY(mSettings->mTransferIDStr);
     DELETE_ARRAY(mSettings->mIsochronousStr);
+    DELETE_ARRAY(mSettings->mTLSCipherList);
+    DELETE_ARRAY(mSettings->mTLSCipherSuites);
+    DELETE_ARRAY(mSettings->mTLSGroups);
+    DELETE_ARRAY(mSettings->mTLSCertFile);
+    DELETE_ARRAY(mSettings->mTLSKeyFile);
+    DELETE_ARRAY(mSettings->mTLSCipherSweep);
+    DELETE_ARRAY(mSettings->mTLSEngine);
     DELETE_ARRAY(mSettings->mBuf);
     DELETE_PTR(mSettings);
 } // end ~Settings
@@ -525,39 +599,141 @@ void Settings_ParseCommandLine (int argc, char **argv, struct thread_Settings *m
 
 } // end ParseCommandLine
 
-static void Setup_TLS(thread_Settings *mExtSettings, int version)
-{
+/* -------------------------------------------------------------------
+ * Create the shared TLS context once all of the options are known.
+ * --tls-engine selects the crypto engine, e.g. qatengine, and falls
+ * back to the OpenSSL default provider (software) if it can't be used.
+ * Returns true if the engine is in use.
+ * ------------------------------------------------------------------- */
+bool Settings_SetupTLS (struct thread_Settings *mExtSettings) {
+    bool engine_active = false;
     SSL_library_init();
     OpenSSL_add_all_algorithms();
     SSL_load_error_strings();
-	//
-	// NP Adds the QAT Engine Ciphers and loads as default provider
-	fprintf(stdout, "Setting up Engine\n");
-    ENGINE     *engine;
-    engine = ENGINE_by_id("qatengine");
-    if (engine == NULL) {
-        fprintf(stderr, "QTLS offload is not available\n");
-        exit(1);
-	}
-    if (ENGINE_set_default(engine, ENGINE_METHOD_ALL) == 0) {
-        fprintf(stderr, "QTLS Ciphers unset\n");
-        ENGINE_free(engine);
-        exit(1);
 
+    const char *engine_id = (mExtSettings->mTLSEngine ? mExtSettings->mTLSEngine : "auto");
+    bool isauto = (strcmp(engine_id, "auto") == 0);
+    if (strcmp(engine_id, "none") != 0) {
+	// NP Adds the QAT Engine Ciphers and loads as default provider
+	if (isauto)
+	    engine_id = TLS_DEFAULT_ENGINE;
+	ENGINE *engine = ENGINE_by_id(engine_id);
+	// the auto fallback is the normal case so it's only noted with -e,
+	// an engine asked for by name which can't be used warns
+	if (engine == NULL) {
+	    if (!isauto) {
+		fprintf(stderr, "WARN: TLS engine %s is not available, using the OpenSSL default provider\n", engine_id);
+	    } else if (isEnhanced(mExtSettings)) {
+		fprintf(stdout, "TLS engine %s is not available, using the OpenSSL default provider\n", engine_id);
+	    }
+	} else if (ENGINE_set_default(engine, ENGINE_METHOD_ALL) == 0) {
+	    fprintf(stderr, "WARN: TLS engine %s ciphers unset, using the OpenSSL default provider\n", engine_id);
+	} else {
+	    if (isEnhanced(mExtSettings))
+		fprintf(stdout, "TLS crypto engine %s\n", engine_id);
+	    engine_active = true;
+	}
+	if (engine)
+	    ENGINE_free(engine);
+	ERR_clear_error();
+    } else if (isEnhanced(mExtSettings)) {
+	fprintf(stdout, "TLS crypto using the OpenSSL default provider\n");
     }
-    ENGINE_free(engine);
 
-    if (version == 13) {
+    if (mExtSettings->ssl_ctx)
+	SSL_CTX_free(mExtSettings->ssl_ctx);
+    if (isUDP(mExtSettings)) {
+	// DTLS for the UDP tests, one record per datagram
+	mExtSettings->ssl_ctx = SSL_CTX_new(DTLS_method());
+	SSL_CTX_set_min_proto_version(mExtSettings->ssl_ctx, DTLS1_2_VERSION);
+#ifdef DTLS1_3_VERSION
+	if (isSSL13(mExtSettings)) {
+	    SSL_CTX_set_min_proto_version(mExtSettings->ssl_ctx, DTLS1_3_VERSION);
+	} else
+#else
+	if (isSSL13(mExtSettings)) {
+	    fprintf(stderr, "WARN: DTLS 1.3 not supported by this OpenSSL version, using DTLS 1.2\n");
+	}
+#endif
+	{
+	    SSL_CTX_set_max_proto_version(mExtSettings->ssl_ctx, DTLS1_2_VERSION);
+	}
+	SSL_CTX_set_cipher_list(mExtSettings->ssl_ctx, "ECDHE-RSA-AES128-GCM-SHA256");
+    } else if (isSSL13(mExtSettings)) {
         mExtSettings->ssl_ctx = SSL_CTX_new(TLS_method());
-        SSL_CTX_set_cipher_list(mExtSettings->ssl_ctx, "TLS1_3_RFC_AES_128_GCM_SHA256");
+        SSL_CTX_set_ciphersuites(mExtSettings->ssl_ctx, "TLS_AES_128_GCM_SHA256");
     } else {
         mExtSettings->ssl_ctx = SSL_CTX_new(TLSv1_2_method());
         SSL_CTX_set_cipher_list(mExtSettings->ssl_ctx, "ECDHE-RSA-AES128-GCM-SHA256");
     }
+    ERR_clear_error();
 
     SSL_CTX_set_ecdh_auto(mExtSettings->ssl_ctx, 1);
     EVP_add_cipher(EVP_aes_128_gcm());
-    LoadCertificates(mExtSettings->ssl_ctx, "newreq.pem", "key.pem");
+
+    // Session resumption needs the server to keep a session cache (session ids
+    // and stateful tickets) on the shared context. Stateless tickets are the
+    // OpenSSL default so the id mode disables them on both sides.
+    if (mExtSettings->mThreadMode != kMode_Client) {
+	SSL_CTX_set_session_cache_mode(mExtSettings->ssl_ctx, SSL_SESS_CACHE_SERVER);
+	SSL_CTX_set_session_id_context(mExtSettings->ssl_ctx, reinterpret_cast<const unsigned char *>("iperf"), 5);
+	if (mExtSettings->mTLSHandshakeMode == kTLSHandshake_EarlyData) {
+	    SSL_CTX_set_max_early_data(mExtSettings->ssl_ctx, TLSMAXEARLYDATA);
+	}
+#ifdef SSL_OP_ALLOW_CLIENT_RENEGOTIATION
+	// OpenSSL 3 refuses client renegotiation by default, --tls-rekey on
+	// the listener allows it for the TLS 1.2 clients running --tls-rekey
+	if (isTLSRekey(mExtSettings)) {
+	    SSL_CTX_set_options(mExtSettings->ssl_ctx, SSL_OP_ALLOW_CLIENT_RENEGOTIATION);
+	}
+#endif
+    }
+    if (mExtSettings->mTLSHandshakeMode == kTLSHandshake_SessionID) {
+	SSL_CTX_set_options(mExtSettings->ssl_ctx, SSL_OP_NO_TICKET);
+    }
+    LoadCertificates(mExtSettings->ssl_ctx, (mExtSettings->mTLSCertFile ? mExtSettings->mTLSCertFile : "newreq.pem"), \
+		     (mExtSettings->mTLSKeyFile ? mExtSettings->mTLSKeyFile : "key.pem"));
+    if (mExtSettings->mTLSCipherList && !SSL_CTX_set_cipher_list(mExtSettings->ssl_ctx, mExtSettings->mTLSCipherList)) {
+	fprintf(stderr, "ERROR: --tls-ciphers '%s' not supported\n", mExtSettings->mTLSCipherList);
+	exit(1);
+    }
+    if (mExtSettings->mTLSCipherSuites && !SSL_CTX_set_ciphersuites(mExtSettings->ssl_ctx, mExtSettings->mTLSCipherSuites)) {
+	fprintf(stderr, "ERROR: --tls-ciphersuites '%s' not supported\n", mExtSettings->mTLSCipherSuites);
+	exit(1);
+    }
+    if (mExtSettings->mTLSGroups && !SSL_CTX_set1_groups_list(mExtSettings->ssl_ctx, mExtSettings->mTLSGroups)) {
+	fprintf(stderr, "ERROR: --tls-groups '%s' not supported\n", mExtSettings->mTLSGroups);
+	exit(1);
+    }
+#ifdef SSL_MODE_ASYNC
+    if (isTLSAsync(mExtSettings)) {
+	SSL_CTX_set_mode(mExtSettings->ssl_ctx, SSL_MODE_ASYNC);
+	if (mExtSettings->mTLSPipelines > 1) {
+	    SSL_CTX_set_max_pipelines(mExtSettings->ssl_ctx, mExtSettings->mTLSPipelines);
+	    SSL_CTX_set_read_ahead(mExtSettings->ssl_ctx, 1);
+	}
+    }
+#endif
+    // Record coalescing, the writes are staged into full size records and,
+    // with --tls-async pipelines, split across the pipelines per record
+    if (isTLSCoalesce(mExtSettings)) {
+	SSL_CTX_set_max_send_fragment(mExtSettings->ssl_ctx, mExtSettings->mTLSRecordSize);
+	if (isTLSAsync(mExtSettings) && (mExtSettings->mTLSPipelines > 1)) {
+	    SSL_CTX_set_split_send_fragment(mExtSettings->ssl_ctx, mExtSettings->mTLSRecordSize);
+	}
+    }
+    // Kernel TLS, OpenSSL installs the negotiated keys on the socket, i.e.
+    // setsockopt(SOL_TLS, TLS_TX/TLS_RX), when the handshake completes.
+    // This requires the tls kernel module and a cipher it supports
+    if (isKTLS(mExtSettings)) {
+#ifdef SSL_OP_ENABLE_KTLS
+	SSL_CTX_set_options(mExtSettings->ssl_ctx, SSL_OP_ENABLE_KTLS);
+#else
+	fprintf(stderr, "WARN: option --ktls not supported by this OpenSSL version\n");
+	unsetKTLS(mExtSettings);
+#endif
+    }
+    return engine_active;
 }
 
 /* -------------------------------------------------------------------
@@ -832,26 +1008,12 @@ void Settings_Interpret (char option, const char *optarg, struct thread_Settings
                 fprintf( stderr, "The -E option should only be specified once (ignored)\n");
             } else if (optarg == NULL || strcmp(optarg, "v1.2") == 0) {
                 setSSL12( mExtSettings );
-                Setup_TLS( mExtSettings , 12);
             } else if (strcmp(optarg, "v1.3") == 0) {
                 setSSL13( mExtSettings );
-                Setup_TLS( mExtSettings , 13);
             } else {
                 fprintf( stderr, "Invalid -E option argument (TLS not enabled)\n");
             }
-			ENGINE     *engine;
-			engine = ENGINE_by_id("qatengine");
-			if (engine == NULL) {
-				fprintf(stderr, "QTLS offload is not available\n");
-				exit(1);
-			}
-			if (ENGINE_set_default(engine, ENGINE_METHOD_ALL) == 0) {
-				fprintf(stderr, "QTLS Ciphers unset\n");
-				ENGINE_free(engine);
-				exit(1);
-
-			}
-			ENGINE_free(engine);
+            // The TLS context is set up once all the options are known, see Settings_SetupTLS
             break;
 
         case 'F' : // Get the input for the data stream from a file
@@ -1121,6 +1283,185 @@ void Settings_Interpret (char option, const char *optarg, struct thread_Settings
 		mExtSettings->mRTOS = strtol(optarg, NULL, 0);
 		setOverrideTOS(mExtSettings);
 	    }
+	    if (tlsasync) {
+		tlsasync = 0;
+#ifdef SSL_MODE_ASYNC
+		setTLSAsync(mExtSettings);
+		mExtSettings->mTLSPipelines = 1;
+		if (optarg) {
+		    // anything but a number is left to the range check in the modal options
+		    char *end;
+		    long pipelines = strtol(optarg, &end, 10);
+		    mExtSettings->mTLSPipelines = (((end == optarg) || (*end != '\0') || (pipelines > INT_MAX)) ? 0 : static_cast<int>(pipelines));
+		}
+#else
+		fprintf(stderr, "WARNING: The --tls-async option is not supported by this OpenSSL\n");
+#endif
+	    }
+	    if (tlshandshake) {
+		tlshandshake = 0;
+		if (strcmp(optarg, "full") == 0) {
+		    mExtSettings->mTLSHandshakeMode = kTLSHandshake_Full;
+		} else if (strcmp(optarg, "id") == 0) {
+		    mExtSettings->mTLSHandshakeMode = kTLSHandshake_SessionID;
+		} else if (strcmp(optarg, "ticket") == 0) {
+		    mExtSettings->mTLSHandshakeMode = kTLSHandshake_Ticket;
+		} else if (strcmp(optarg, "0rtt") == 0) {
+		    mExtSettings->mTLSHandshakeMode = kTLSHandshake_EarlyData;
+		} else {
+		    fprintf(stderr, "Invalid --tls-handshake value of '%s', use full, id, ticket or 0rtt\n", optarg);
+		    exit(1);
+		}
+	    }
+	    if (tlsciphers) {
+		tlsciphers = 0;
+		DELETE_ARRAY(mExtSettings->mTLSCipherList);
+		mExtSettings->mTLSCipherList = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTLSCipherList, optarg);
+	    }
+	    if (tlsciphersuites) {
+		tlsciphersuites = 0;
+		DELETE_ARRAY(mExtSettings->mTLSCipherSuites);
+		mExtSettings->mTLSCipherSuites = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTLSCipherSuites, optarg);
+	    }
+	    if (tlsgroups) {
+		tlsgroups = 0;
+		DELETE_ARRAY(mExtSettings->mTLSGroups);
+		mExtSettings->mTLSGroups = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTLSGroups, optarg);
+	    }
+	    if (tlscert) {
+		tlscert = 0;
+		DELETE_ARRAY(mExtSettings->mTLSCertFile);
+		mExtSettings->mTLSCertFile = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTLSCertFile, optarg);
+	    }
+	    if (tlskey) {
+		tlskey = 0;
+		DELETE_ARRAY(mExtSettings->mTLSKeyFile);
+		mExtSettings->mTLSKeyFile = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTLSKeyFile, optarg);
+	    }
+	    if (tlsciphersweep) {
+		tlsciphersweep = 0;
+		DELETE_ARRAY(mExtSettings->mTLSCipherSweep);
+		mExtSettings->mTLSCipherSweep = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTLSCipherSweep, optarg);
+	    }
+	    if (tlsengine) {
+		tlsengine = 0;
+		DELETE_ARRAY(mExtSettings->mTLSEngine);
+		mExtSettings->mTLSEngine = new char[strlen(optarg) + 1];
+		strcpy(mExtSettings->mTLSEngine, optarg);
+	    }
+	    if (tlsengineab) {
+		tlsengineab = 0;
+		setTLSEngineAB(mExtSettings);
+	    }
+	    if (tlscoalesce) {
+		tlscoalesce = 0;
+		setTLSCoalesce(mExtSettings);
+		mExtSettings->mTLSRecordSize = (optarg ? byte_atoi(optarg) : SSL3_RT_MAX_PLAIN_LENGTH);
+	    }
+	    if (tlsrekey) {
+		tlsrekey = 0;
+		setTLSRekey(mExtSettings);
+		// a trailing s means seconds, otherwise bytes with the usual KMG suffixes,
+		// a bare --tls-rekey is for the server, i.e. permit the client rekeys
+		if (optarg) {
+		    size_t len = strlen(optarg);
+		    if ((len > 0) && (optarg[len - 1] == 's')) {
+			mExtSettings->mTLSRekeyTime = atof(optarg);
+		    } else {
+			mExtSettings->mTLSRekeyBytes = byte_atoi(optarg);
+		    }
+		}
+	    }
+	    if (udpbatch) {
+		udpbatch = 0;
+		setUDPBatch(mExtSettings);
+		mExtSettings->mUDPBatch = (optarg ? atoi(optarg) : kDefault_UDPBatch);
+	    }
+	    if (udpgso || udpgro) {
+		if (udpgso)
+		    setUDPGSO(mExtSettings);
+		else
+		    setUDPGRO(mExtSettings);
+		udpgso = 0;
+		udpgro = 0;
+		if (!isUDPBatch(mExtSettings)) {
+		    setUDPBatch(mExtSettings);
+		    mExtSettings->mUDPBatch = kDefault_UDPBatch;
+		}
+	    }
+	    if (zerocopy) {
+		zerocopy = 0;
+		setZeroCopy(mExtSettings);
+		setEnhanced(mExtSettings);
+	    }
+	    if (iouring) {
+		iouring = 0;
+		setIOUring(mExtSettings);
+		mExtSettings->mIOUringDepth = (optarg ? atoi(optarg) : kDefault_IOUringDepth);
+	    }
+	    if (workerpool) {
+		workerpool = 0;
+		setWorkerPool(mExtSettings);
+		// zero is one worker per online cpu
+		mExtSettings->mWorkers = (optarg ? atoi(optarg) : 0);
+	    }
+	    if (listenshards) {
+		listenshards = 0;
+		setListenShards(mExtSettings);
+		// zero is one shard per online cpu
+		mExtSettings->mListenShards = (optarg ? atoi(optarg) : 0);
+	    }
+	    if (sendfilex) {
+		sendfilex = 0;
+		setSendfile(mExtSettings);
+	    }
+	    if (nullsink) {
+		nullsink = 0;
+		setNullSink(mExtSettings);
+	    }
+	    if (txtime) {
+		txtime = 0;
+		setTxTime(mExtSettings);
+		mExtSettings->mTxTimeLead = (optarg ? atoi(optarg) : kDefault_TxTimeLead);
+	    }
+	    if (busypoll) {
+		busypoll = 0;
+		setBusyPoll(mExtSettings);
+		mExtSettings->mBusyPoll = (optarg ? atoi(optarg) : kDefault_BusyPoll);
+	    }
+	    if (afxdp) {
+		afxdp = 0;
+		setAFXDP(mExtSettings);
+		mExtSettings->mXdpQueue = (optarg ? atoi(optarg) : 0);
+	    }
+	    if (reporterthreads) {
+		reporterthreads = 0;
+		setReporterThreads(mExtSettings);
+		// zero is one per online cpu
+		mExtSettings->mReporterThreads = (optarg ? atoi(optarg) : 0);
+	    }
+	    if (reporterstats) {
+		reporterstats = 0;
+		setReporterStats(mExtSettings);
+	    }
+	    if (cpustats) {
+		cpustats = 0;
+		setCPUStats(mExtSettings);
+		setEnhanced(mExtSettings);
+		if (optarg) {
+		    if (strcmp(optarg, "cycles") == 0) {
+			setCPUCycles(mExtSettings);
+		    } else {
+			fprintf(stderr, "WARN: unknown --cpu-stats value %s, expected cycles\n", optarg);
+		    }
+		}
+	    }
 	    if (fqrate) {
 #if defined(HAVE_DECL_SO_MAX_PACING_RATE)
 	        fqrate=0;
@@ -1386,6 +1727,338 @@ void Settings_ModalOptions (struct thread_Settings *mExtSettings) {
 	    }
 	}
     }
+    if (isTLSAsync(mExtSettings)) {
+	if (!isSSL(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tls-async requires -E (TLS)\n");
+	    unsetTLSAsync(mExtSettings);
+	} else if ((mExtSettings->mTLSPipelines < 1) || (mExtSettings->mTLSPipelines > SSL_MAX_PIPELINES)) {
+	    fprintf(stderr, "ERROR: value for --tls-async must be between 1 and %d\n", SSL_MAX_PIPELINES);
+	    bail = true;
+	}
+    }
+    if (isTLSCoalesce(mExtSettings)) {
+	if (!isSSL(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tls-coalesce requires -E (TLS)\n");
+	    unsetTLSCoalesce(mExtSettings);
+	} else if (isUDP(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tls-coalesce not supported with -u, DTLS sends a record per datagram\n");
+	    unsetTLSCoalesce(mExtSettings);
+	} else if ((mExtSettings->mTLSRecordSize < 512) || (mExtSettings->mTLSRecordSize > SSL3_RT_MAX_PLAIN_LENGTH)) {
+	    fprintf(stderr, "ERROR: value for --tls-coalesce must be between 512 and %d bytes\n", SSL3_RT_MAX_PLAIN_LENGTH);
+	    bail = true;
+	}
+    }
+    if (isTLSRekey(mExtSettings)) {
+	if (!isSSL(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tls-rekey requires -E (TLS)\n");
+	    unsetTLSRekey(mExtSettings);
+	} else if (isUDP(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tls-rekey not supported with -u (DTLS)\n");
+	    unsetTLSRekey(mExtSettings);
+	} else if (isKTLS(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tls-rekey not supported with --ktls, the kernel owns the record keys\n");
+	    unsetTLSRekey(mExtSettings);
+	} else if ((mExtSettings->mThreadMode == kMode_Client) && (mExtSettings->mTLSRekeyBytes <= 0) && (mExtSettings->mTLSRekeyTime <= 0)) {
+	    fprintf(stderr, "ERROR: value for --tls-rekey must be a positive number of bytes or seconds, e.g. 64M or 2s\n");
+	    bail = true;
+	}
+    }
+    if (isUDPBatch(mExtSettings)) {
+	if (isUDPGSO(mExtSettings) && (mExtSettings->mThreadMode != kMode_Client)) {
+	    fprintf(stderr, "WARN: option of --udp-gso is only supported on the client, use --udp-gro on the server\n");
+	    unsetUDPGSO(mExtSettings);
+	}
+	if (isUDPGRO(mExtSettings) && (mExtSettings->mThreadMode == kMode_Client)) {
+	    fprintf(stderr, "WARN: option of --udp-gro is only supported on the server, use --udp-gso on the client\n");
+	    unsetUDPGRO(mExtSettings);
+	}
+	if (!isUDP(mExtSettings)) {
+	    fprintf(stderr, "WARN: options of --udp-batch, --udp-gso and --udp-gro require -u\n");
+	    unsetUDPBatch(mExtSettings);
+	    unsetUDPGSO(mExtSettings);
+	    unsetUDPGRO(mExtSettings);
+	} else if (isSSL(mExtSettings) || ((mExtSettings->mThreadMode == kMode_Client) && isIsochronous(mExtSettings))) {
+	    fprintf(stderr, "WARN: options of --udp-batch, --udp-gso and --udp-gro not supported with -E (DTLS), nor --isochronous on the client\n");
+	    unsetUDPBatch(mExtSettings);
+	    unsetUDPGSO(mExtSettings);
+	    unsetUDPGRO(mExtSettings);
+	} else if ((mExtSettings->mUDPBatch < 1) || (mExtSettings->mUDPBatch > UDPBATCHMAX)) {
+	    fprintf(stderr, "ERROR: value for --udp-batch must be between 1 and %d\n", UDPBATCHMAX);
+	    bail = true;
+	}
+#if !defined(__linux__)
+	fprintf(stderr, "WARN: options of --udp-batch, --udp-gso and --udp-gro not supported on this platform\n");
+	unsetUDPBatch(mExtSettings);
+	unsetUDPGSO(mExtSettings);
+	unsetUDPGRO(mExtSettings);
+#else
+#if !defined(UDP_SEGMENT)
+	if (isUDPGSO(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --udp-gso not supported on this platform, using sendmmsg()\n");
+	    unsetUDPGSO(mExtSettings);
+	}
+#endif
+#if !defined(UDP_GRO)
+	if (isUDPGRO(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --udp-gro not supported on this platform, using recvmmsg()\n");
+	    unsetUDPGRO(mExtSettings);
+	}
+#endif
+#endif
+	// a GSO send is one UDP datagram to the stack, i.e. 64KB max, and
+	// the kernel caps the segment count
+	if (isUDPGSO(mExtSettings) && !bail) {
+	    int maxsegs = UDPGSOMAXPAYLOAD / mExtSettings->mBufLen;
+	    if (maxsegs > UDPGSOMAXSEGS)
+		maxsegs = UDPGSOMAXSEGS;
+	    if (mExtSettings->mUDPBatch > maxsegs) {
+		fprintf(stderr, "WARN: --udp-gso batch reduced from %d to %d datagrams of %d bytes\n", mExtSettings->mUDPBatch, maxsegs, mExtSettings->mBufLen);
+		mExtSettings->mUDPBatch = maxsegs;
+	    }
+	}
+    }
+    if (isZeroCopy(mExtSettings)) {
+#if !HAVE_MSG_ZEROCOPY
+	fprintf(stderr, "WARN: option of --zerocopy not supported on this platform\n");
+	unsetZeroCopy(mExtSettings);
+#else
+	if (mExtSettings->mThreadMode != kMode_Client) {
+	    fprintf(stderr, "WARN: option of --zerocopy is only supported on the client\n");
+	    unsetZeroCopy(mExtSettings);
+	} else if (isSSL(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --zerocopy not supported with -E (TLS), the records are encrypted into OpenSSL buffers\n");
+	    unsetZeroCopy(mExtSettings);
+	} else if (isFileInput(mExtSettings) || isUDPBatch(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --zerocopy not supported with -F, -I or --udp-batch\n");
+	    unsetZeroCopy(mExtSettings);
+	}
+#endif
+    }
+    if (isIOUring(mExtSettings)) {
+#if !HAVE_IO_URING
+	fprintf(stderr, "WARN: option of --io-uring not supported on this platform\n");
+	unsetIOUring(mExtSettings);
+#else
+	// the engine drives the plain TCP loops, the burst, rate limited and
+	// file based loops stay with the send()/recv() code
+	if (isUDP(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --io-uring not supported with -u\n");
+	    unsetIOUring(mExtSettings);
+	} else if (isSSL(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --io-uring not supported with -E (TLS)\n");
+	    unsetIOUring(mExtSettings);
+	} else if ((mExtSettings->mThreadMode == kMode_Client) && \
+		   (isFileInput(mExtSettings) || isIsochronous(mExtSettings) || isPeriodicBurst(mExtSettings) || \
+		    (isTripTime(mExtSettings) && !isWritePrefetch(mExtSettings)) || \
+		    isNearCongest(mExtSettings) || isTcpDrain(mExtSettings) || (mExtSettings->mAppRate > 0))) {
+	    // --tcp-write-prefetch has its own loop, one write in flight, so
+	    // its write headers, i.e. --trip-times, still work
+	    fprintf(stderr, "WARN: option of --io-uring not supported with -b, -F, -I, --isochronous, --burst-period, --trip-times (without --tcp-write-prefetch), --near-congestion or --tcp-drain\n");
+	    unsetIOUring(mExtSettings);
+	} else if ((mExtSettings->mIOUringDepth < 1) || (mExtSettings->mIOUringDepth > IOURINGDEPTHMAX)) {
+	    fprintf(stderr, "ERROR: value for --io-uring must be between 1 and %d\n", IOURINGDEPTHMAX);
+	    bail = true;
+	}
+#endif
+    }
+    if (isWorkerPool(mExtSettings)) {
+#if !HAVE_WORKER_POOL
+	fprintf(stderr, "WARN: option of --worker-pool not supported on this platform\n");
+	unsetWorkerPool(mExtSettings);
+#else
+	// connections the workers can't drive, e.g. -E or --full-duplex,
+	// still get their own thread per the listener's dispatch
+	if (mExtSettings->mThreadMode != kMode_Listener) {
+	    fprintf(stderr, "WARN: option of --worker-pool only supported on the server\n");
+	    unsetWorkerPool(mExtSettings);
+	} else if (isUDP(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --worker-pool not supported with -u\n");
+	    unsetWorkerPool(mExtSettings);
+	} else if ((mExtSettings->mWorkers < 0) || (mExtSettings->mWorkers > WORKERPOOLMAX)) {
+	    fprintf(stderr, "ERROR: value for --worker-pool must be between 0 (one per cpu) and %d\n", WORKERPOOLMAX);
+	    bail = true;
+	} else if (mExtSettings->mWorkers == 0) {
+	    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	    mExtSettings->mWorkers = ((ncpus < 1) ? 1 : ((ncpus > WORKERPOOLMAX) ? WORKERPOOLMAX : static_cast<int>(ncpus)));
+	}
+#endif
+    }
+    if (isListenShards(mExtSettings)) {
+#if !HAVE_LISTEN_SHARDS
+	fprintf(stderr, "WARN: option of --listen-shards not supported on this platform\n");
+	unsetListenShards(mExtSettings);
+#else
+	// -1 and -P count connections per listener, i.e. per shard
+	if (mExtSettings->mThreadMode != kMode_Listener) {
+	    fprintf(stderr, "WARN: option of --listen-shards only supported on the server\n");
+	    unsetListenShards(mExtSettings);
+	} else if (isUDP(mExtSettings) || isSingleClient(mExtSettings) || isMulticast(mExtSettings) || (mExtSettings->mThreads > 0)) {
+	    fprintf(stderr, "WARN: option of --listen-shards not supported with -u, -1, -B multicast or -P on the server\n");
+	    unsetListenShards(mExtSettings);
+	} else if ((mExtSettings->mListenShards < 0) || (mExtSettings->mListenShards > LISTENSHARDSMAX)) {
+	    fprintf(stderr, "ERROR: value for --listen-shards must be between 0 (one per cpu) and %d\n", LISTENSHARDSMAX);
+	    bail = true;
+	} else if (mExtSettings->mListenShards == 0) {
+	    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	    mExtSettings->mListenShards = ((ncpus < 1) ? 1 : ((ncpus > LISTENSHARDSMAX) ? LISTENSHARDSMAX : static_cast<int>(ncpus)));
+	}
+#endif
+    }
+    if (isSendfile(mExtSettings)) {
+#if !HAVE_SENDFILE_SPLICE
+	fprintf(stderr, "WARN: option of --sendfile not supported on this platform\n");
+	unsetSendfile(mExtSettings);
+#else
+	// kTLS already has the kernel send the -F file, see Client::RunTCP
+	if (mExtSettings->mThreadMode != kMode_Client) {
+	    fprintf(stderr, "WARN: option of --sendfile only supported on the client\n");
+	    unsetSendfile(mExtSettings);
+	} else if (!isFileInput(mExtSettings) || isUDP(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --sendfile requires TCP with -F or -I\n");
+	    unsetSendfile(mExtSettings);
+	} else if (isSSL(mExtSettings) || isIsochronous(mExtSettings) || isPeriodicBurst(mExtSettings) || isTripTime(mExtSettings) || isTcpDrain(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --sendfile not supported with -E, --isochronous, --burst-period, --trip-times or --tcp-drain\n");
+	    unsetSendfile(mExtSettings);
+	}
+#endif
+    }
+    if (isNullSink(mExtSettings)) {
+#if !HAVE_SENDFILE_SPLICE
+	fprintf(stderr, "WARN: option of --null-sink not supported on this platform\n");
+	unsetNullSink(mExtSettings);
+#else
+	// the burst headers and TLS records still need the recv() into mBuf,
+	// those streams ignore the sink per Server::RunTCP
+	if (mExtSettings->mThreadMode != kMode_Listener) {
+	    fprintf(stderr, "WARN: option of --null-sink only supported on the server\n");
+	    unsetNullSink(mExtSettings);
+	} else if (isUDP(mExtSettings) || isIOUring(mExtSettings) || isWorkerPool(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --null-sink not supported with -u, --io-uring or --worker-pool\n");
+	    unsetNullSink(mExtSettings);
+	}
+#endif
+    }
+    if (isTxTime(mExtSettings)) {
+#if !HAVE_SO_TXTIME
+	fprintf(stderr, "WARN: option of --txtime not supported on this platform\n");
+	unsetTxTime(mExtSettings);
+#else
+	// the kernel paces the datagrams of the UDP loops, the batched sends
+	// and the zerocopy completions compete for the same socket error queue
+	if ((mExtSettings->mThreadMode != kMode_Client) || !isUDP(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --txtime only supported on a UDP client\n");
+	    unsetTxTime(mExtSettings);
+	} else if (isSSL(mExtSettings) || isUDPBatch(mExtSettings) || isZeroCopy(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --txtime not supported with -E, --udp-batch or --zerocopy\n");
+	    unsetTxTime(mExtSettings);
+	} else if ((mExtSettings->mTxTimeLead < 1) || (mExtSettings->mTxTimeLead > TXTIMELEADMAX)) {
+	    fprintf(stderr, "ERROR: value for --txtime must be between 1 and %d usecs\n", TXTIMELEADMAX);
+	    bail = true;
+	}
+#endif
+    }
+    if (isBusyPoll(mExtSettings)) {
+#if !HAVE_BUSY_POLL
+	fprintf(stderr, "WARN: option of --busy-poll not supported on this platform\n");
+	unsetBusyPoll(mExtSettings);
+#else
+	// the spin is the traffic thread's own read, the epoll workers and
+	// the io_uring reads don't fit the model
+	if (mExtSettings->mThreadMode != kMode_Listener) {
+	    fprintf(stderr, "WARN: option of --busy-poll only supported on the server\n");
+	    unsetBusyPoll(mExtSettings);
+	} else if (isWorkerPool(mExtSettings) || isIOUring(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --busy-poll not supported with --worker-pool or --io-uring\n");
+	    unsetBusyPoll(mExtSettings);
+	} else if ((mExtSettings->mBusyPoll < 1) || (mExtSettings->mBusyPoll > BUSYPOLLMAX)) {
+	    fprintf(stderr, "ERROR: value for --busy-poll must be between 1 and %d usecs\n", BUSYPOLLMAX);
+	    bail = true;
+	}
+#endif
+    }
+    if (isAFXDP(mExtSettings)) {
+#if !HAVE_AF_XDP
+	fprintf(stderr, "WARN: option of --af-xdp not supported on this platform\n");
+	unsetAFXDP(mExtSettings);
+#else
+	// the frames are hand built ipv4 datagrams of one flow, so the other
+	// UDP send and read engines don't apply
+	if (!isUDP(mExtSettings) || isIPV6(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --af-xdp only supported with -u over IPv4\n");
+	    unsetAFXDP(mExtSettings);
+	} else if (isSSL(mExtSettings) || isUDPBatch(mExtSettings) || isTxTime(mExtSettings) || isBusyPoll(mExtSettings) || \
+		   isIsochronous(mExtSettings) || isL2LengthCheck(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --af-xdp not supported with -E, --udp-batch, --txtime, --busy-poll, --isochronous or --l2checks\n");
+	    unsetAFXDP(mExtSettings);
+	} else if (mExtSettings->mXdpQueue < 0) {
+	    fprintf(stderr, "ERROR: value for --af-xdp must be a queue index of zero or more\n");
+	    bail = true;
+	}
+#endif
+    }
+    if (isReporterThreads(mExtSettings)) {
+#if !HAVE_REPORTER_SHARDS
+	fprintf(stderr, "WARN: option of --reporter-threads not supported on this platform\n");
+	unsetReporterThreads(mExtSettings);
+#else
+	if ((mExtSettings->mReporterThreads < 0) || (mExtSettings->mReporterThreads > REPORTERTHREADSMAX)) {
+	    fprintf(stderr, "ERROR: value for --reporter-threads must be between 0 (one per cpu) and %d\n", REPORTERTHREADSMAX);
+	    bail = true;
+	} else if (mExtSettings->mReporterThreads == 0) {
+	    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	    mExtSettings->mReporterThreads = ((ncpus < 1) ? 1 : ((ncpus > REPORTERTHREADSMAX) ? REPORTERTHREADSMAX : static_cast<int>(ncpus)));
+	}
+#endif
+    }
+    // DTLS carries one UDP payload per record so the payload has to fit
+    if (isSSL(mExtSettings) && isUDP(mExtSettings)) {
+	if (mExtSettings->mBufLen > SSL3_RT_MAX_PLAIN_LENGTH) {
+	    fprintf(stderr, "ERROR: payload (-l) size of %d too large for DTLS, must be %d or less\n", mExtSettings->mBufLen, SSL3_RT_MAX_PLAIN_LENGTH);
+	    bail = true;
+	}
+	if (isKTLS(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --ktls not supported with -u (DTLS)\n");
+	    unsetKTLS(mExtSettings);
+	}
+	if (isFullDuplex(mExtSettings)) {
+	    fprintf(stderr, "ERROR: option of --full-duplex not supported with -u and -E (DTLS)\n");
+	    bail = true;
+	}
+    }
+    if (!isSSL(mExtSettings) && (mExtSettings->mTLSCipherList || mExtSettings->mTLSCipherSuites || mExtSettings->mTLSGroups || \
+				 mExtSettings->mTLSCertFile || mExtSettings->mTLSKeyFile || mExtSettings->mTLSCipherSweep || mExtSettings->mTLSEngine)) {
+	fprintf(stderr, "WARN: options of --tls-ciphers, --tls-ciphersuites, --tls-groups, --tls-cert, --tls-key, --tls-cipher-sweep and --tls-engine require -E (TLS)\n");
+    }
+    if (mExtSettings->mTLSCipherSweep) {
+	if (mExtSettings->mThreadMode != kMode_Client) {
+	    fprintf(stderr, "WARN: option of --tls-cipher-sweep is only supported on the client\n");
+	    DELETE_ARRAY(mExtSettings->mTLSCipherSweep);
+	} else if (isUDP(mExtSettings) || isConnectOnly(mExtSettings)) {
+	    fprintf(stderr, "ERROR: option of --tls-cipher-sweep requires a TCP traffic test\n");
+	    bail = true;
+	}
+    }
+    if (isTLSEngineAB(mExtSettings)) {
+	if (!isSSL(mExtSettings) || (mExtSettings->mThreadMode != kMode_Client)) {
+	    fprintf(stderr, "WARN: option of --tls-engine-ab requires -E (TLS) on the client\n");
+	    unsetTLSEngineAB(mExtSettings);
+	} else if (isUDP(mExtSettings) || isConnectOnly(mExtSettings)) {
+	    fprintf(stderr, "ERROR: option of --tls-engine-ab requires a TCP traffic test\n");
+	    bail = true;
+	} else if (mExtSettings->mTLSEngine && (strcmp(mExtSettings->mTLSEngine, "none") == 0)) {
+	    fprintf(stderr, "ERROR: option of --tls-engine-ab needs an engine, not --tls-engine=none\n");
+	    bail = true;
+	}
+    }
+    if (mExtSettings->mTLSHandshakeMode != kTLSHandshake_Full) {
+	if (!isSSL(mExtSettings)) {
+	    fprintf(stderr, "WARN: option of --tls-handshake requires -E (TLS)\n");
+	    mExtSettings->mTLSHandshakeMode = kTLSHandshake_Full;
+	} else if ((mExtSettings->mTLSHandshakeMode == kTLSHandshake_EarlyData) && !isSSL13(mExtSettings)) {
+	    fprintf(stderr, "ERROR: option of --tls-handshake=0rtt requires -E v1.3\n");
+	    bail = true;
+	}
+    }
     if (mExtSettings->mThreadMode == kMode_Client) {
 	if (isRemoveService(mExtSettings)) {
 	    // -R on the client is overloaded and is the
@@ -1676,6 +2349,10 @@ void Settings_ModalOptions (struct thread_Settings *mExtSettings) {
     }
     if (bail)
 	exit(1);
+    // A cipher sweep or engine A/B run sets up TLS per run (forked child), see main.cpp
+    if (isSSL(mExtSettings) && !mExtSettings->mTLSCipherSweep && !isTLSEngineAB(mExtSettings)) {
+	Settings_SetupTLS(mExtSettings);
+    }
 
     // UDP histogram optional settings
     if (isHistogram(mExtSettings)) {
@@ -110,6 +110,8 @@ static void active_table_update (iperf_sockaddr *host, struct thread_Settings *a
 	this_entry->host = *host;
 	this_entry->next = active_table.root;
 	this_entry->thread_count = 1;
+	this_entry->joined_count = 1;
+	this_entry->unused_count = 0;
 	this_entry->socket = agent->mSock;
 	active_table.count++;
 	active_table.groupid++;
@@ -121,6 +123,7 @@ static void active_table_update (iperf_sockaddr *host, struct thread_Settings *a
 	agent->mSumReport = this_entry->sum_report;
     } else {
 	this_entry->thread_count++;
+	this_entry->joined_count++;
 	agent->mSumReport = this_entry->sum_report;
 #if HAVE_THREAD_DEBUG
 	active_table_show_entry("incr entry", this_entry, 1);
@@ -194,6 +197,38 @@ void Iperf_remove_host (struct thread_Settings *agent) {
     Mutex_Unlock(&active_table.my_mutex);
 }
 
+/*
+ * Remove a host for an agent that never started a report, e.g. the
+ * listener rejecting a connection. The sum report is freed only when
+ * none of the entry's agents started a report, otherwise the reporter
+ * frees it per the report reference count. This keeps listeners, e.g.
+ * the --listen-shards, from freeing a sum report another agent of the
+ * same host still has.
+ */
+void Iperf_remove_unused_host (struct thread_Settings *agent) {
+    iperf_sockaddr *del = active_table_get_host_key(agent);
+    Mutex_Lock(&active_table.my_mutex);
+    Iperf_ListEntry **tmp = &active_table.root;
+    while ((*tmp) && !(SockAddr_Hostare_Equal(&(*tmp)->host, del))) {
+	tmp = &(*tmp)->next;
+    }
+    if (*tmp) {
+	(*tmp)->unused_count++;
+	if (--(*tmp)->thread_count == 0) {
+	    Iperf_ListEntry *remove = (*tmp);
+	    active_table.count--;
+#if HAVE_THREAD_DEBUG
+	    active_table_show_entry("delete unused", remove, 1);
+#endif
+	    *tmp = remove->next;
+	    if (remove->unused_count == remove->joined_count)
+		FreeSumReport(remove->sum_report);
+	    delete remove;
+	}
+    }
+    Mutex_Unlock(&active_table.my_mutex);
+}
+
 /*
  * Destroy the table
  */
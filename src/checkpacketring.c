@@ -0,0 +1,193 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2014
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * checkpacketring.c
+ * Measure the packet ring's enqueue/dequeue throughput between
+ * a producer thread and the consumer (main) thread
+ * ------------------------------------------------------------------- */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "headers.h"
+#include "packet_ring.h"
+#include "Condition.h"
+#include "Reporter.h"
+#include "util.h"
+#include <sched.h>
+
+#define BILLION 1000000000
+
+struct producer_args {
+    struct PacketRing *pr;
+    intmax_t count;
+    int cpu;
+};
+
+static double now_secs (void) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec + (t1.tv_nsec / (double) BILLION));
+}
+
+static void set_affinity (int cpu) {
+#if HAVE_DECL_CPU_SET
+    if (cpu >= 0) {
+	cpu_set_t myset;
+	CPU_ZERO(&myset);
+	CPU_SET(cpu, &myset);
+	int rc = pthread_setaffinity_np(pthread_self(), sizeof(myset), &myset);
+	if (rc) {
+	    errno = rc;
+	    WARN_errno(1, "set affinity");
+	}
+    }
+#endif
+}
+
+static void *producer (void *arg) {
+    struct producer_args *args = (struct producer_args *) arg;
+    struct ReportStruct packet;
+    memset(&packet, 0, sizeof(packet));
+    set_affinity(args->cpu);
+    for (intmax_t ix = 1; ix <= args->count; ix++) {
+	packet.packetID = ix;
+	packet.packetLen = 1470;
+	packetring_enqueue(args->pr, &packet);
+    }
+    // the final packet, same as EndJob
+    packet.packetID = -1;
+    packetring_enqueue(args->pr, &packet);
+    return NULL;
+}
+
+int main (int argc, char **argv) {
+    int c;
+    int batch = PACKETRING_BATCH;
+    int ringsize = NUM_REPORT_STRUCTS;
+    intmax_t loopcount = 10000000;
+    struct producer_args args;
+    args.cpu = -1;
+    int cpu = -1;
+
+    while ((c=getopt(argc, argv, "a:b:i:r:")) != -1)
+	switch (c) {
+	case 'a':
+	    // producer on cpu #, consumer on # + 1
+	    args.cpu = atoi(optarg);
+	    cpu = args.cpu + 1;
+	    break;
+	case 'b':
+	    batch = atoi(optarg);
+	    break;
+	case 'i':
+	    loopcount = atoll(optarg);
+	    break;
+	case 'r':
+	    ringsize = atoi(optarg);
+	    break;
+	case '?':
+	    fprintf(stderr,"Usage -i iterations, -b dequeue batch (max %d), -r ring size, -a producer cpu\n", PACKETRING_BATCH);
+	    return 1;
+	default:
+	    abort();
+	}
+    if ((batch < 1) || (batch > PACKETRING_BATCH) || (ringsize < 1) || (loopcount < 1)) {
+	fprintf(stderr, "ERROR: batch must be 1 to %d, ring size and iterations must be positive\n", PACKETRING_BATCH);
+	return 1;
+    }
+
+    struct Condition awake_consumer;
+    struct Condition awake_producer;
+    Condition_Initialize(&awake_consumer);
+    Condition_Initialize(&awake_producer);
+    struct PacketRing *pr = packetring_init(ringsize, &awake_consumer, &awake_producer);
+    args.pr = pr;
+    args.count = loopcount;
+    fprintf(stdout,"Measuring %d element ring (%d bytes) over %.0e packets using a dequeue batch of %d\n",
+	    pr->maxcount, pr->bytes, (double) loopcount, batch);
+    fflush(stdout);
+
+    set_affinity(cpu);
+    pthread_t thread;
+    double start = now_secs();
+    if (pthread_create(&thread, NULL, producer, &args) != 0) {
+	fprintf(stderr, "ERROR: producer thread create failed\n");
+	return 1;
+    }
+    struct ReportStruct *packets[PACKETRING_BATCH];
+    intmax_t expected = 1;
+    intmax_t empties = 0;
+    intmax_t dequeues = 0;
+    bool done = false;
+    while (!done) {
+	int count = packetring_dequeue_n(pr, packets, batch);
+	if (!count) {
+	    // the reporter would go idle here, let the producer run
+	    empties++;
+	    sched_yield();
+	    continue;
+	}
+	dequeues++;
+	for (int ix = 0; ix < count; ix++) {
+	    if (packets[ix]->packetID < 0) {
+		done = true;
+		break;
+	    }
+	    if (packets[ix]->packetID != expected) {
+		fprintf(stderr, "ERROR: packet id %" PRIdMAX " expected %" PRIdMAX "\n", packets[ix]->packetID, expected);
+		return 1;
+	    }
+	    expected++;
+	}
+    }
+    double elapsed = now_secs() - start;
+    pthread_join(thread, NULL);
+    fprintf(stdout,"%.2f Mpps (%.1f ns/packet), %.1f packets/dequeue, %" PRIdMAX " empty dequeues, %d producer awaits\n",
+	    (loopcount / elapsed) / 1e6, (elapsed * BILLION) / loopcount, (double) loopcount / dequeues, empties, pr->awaitcounter);
+    packetring_free(pr);
+    Condition_Destroy(&awake_consumer);
+    Condition_Destroy(&awake_producer);
+    return 0;
+}
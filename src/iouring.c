@@ -0,0 +1,286 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2026
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * iouring.c
+ * Minimal io_uring support for the traffic threads, see iouring.h
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "iouring.h"
+
+#if HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+static inline int sys_io_uring_setup (unsigned entries, struct io_uring_params *params) {
+    return (int) syscall(__NR_io_uring_setup, entries, params);
+}
+
+static inline int sys_io_uring_enter (int fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t argsz) {
+    return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static inline int sys_io_uring_register (int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+    return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// The completion queue is twice the submission queue as a zerocopy send
+// posts two completions, the send result and the buffer release
+struct iouring *iouring_init (unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = 2 * entries;
+    int fd = sys_io_uring_setup(entries, &params);
+    if (fd < 0)
+	return NULL;
+    struct iouring *ring = (struct iouring *) calloc(1, sizeof(struct iouring));
+    if (!ring) {
+	close(fd);
+	return NULL;
+    }
+    ring->fd = fd;
+    ring->sq_entries = params.sq_entries;
+    ring->cq_entries = params.cq_entries;
+    ring->ext_arg = ((params.features & IORING_FEAT_EXT_ARG) != 0);
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+	if (ring->cq_ring_size > ring->sq_ring_size)
+	    ring->sq_ring_size = ring->cq_ring_size;
+	ring->cq_ring_size = ring->sq_ring_size;
+    }
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+	ring->sq_ring = NULL;
+	iouring_free(ring);
+	return NULL;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+	ring->cq_ring = ring->sq_ring;
+    } else {
+	ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	if (ring->cq_ring == MAP_FAILED) {
+	    ring->cq_ring = NULL;
+	    iouring_free(ring);
+	    return NULL;
+	}
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *) mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+	ring->sqes = NULL;
+	iouring_free(ring);
+	return NULL;
+    }
+    char *sq = (char *) ring->sq_ring;
+    char *cq = (char *) ring->cq_ring;
+    ring->sq_head = (unsigned *) (sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+    ring->sq_mask = *(unsigned *) (sq + params.sq_off.ring_mask);
+    ring->sq_local_tail = *ring->sq_tail;
+    // the sqe slots map one to one to the index array
+    unsigned *array = (unsigned *) (sq + params.sq_off.array);
+    for (unsigned ix = 0; ix < params.sq_entries; ix++)
+	array[ix] = ix;
+    ring->cq_head = (unsigned *) (cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned *) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    return ring;
+}
+
+void iouring_free (struct iouring *ring) {
+    if (!ring)
+	return;
+    if (ring->br)
+	munmap(ring->br, ring->br_size);
+    if (ring->sqes)
+	munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ring && (ring->cq_ring != ring->sq_ring))
+	munmap(ring->cq_ring, ring->cq_ring_size);
+    if (ring->sq_ring)
+	munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+    free(ring);
+}
+
+// Returns NULL when the submission queue is full
+struct io_uring_sqe *iouring_get_sqe (struct iouring *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if ((ring->sq_local_tail - head) >= ring->sq_entries)
+	return NULL;
+    struct io_uring_sqe *sqe = &ring->sqes[ring->sq_local_tail & ring->sq_mask];
+    ring->sq_local_tail++;
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    return sqe;
+}
+
+// Submit all the queued sqes and, if wait_nr is non zero, wait for that
+// many completions, one system call for both. A non zero timeout bounds
+// the wait as the traffic threads don't get the signals, i.e. the wait
+// can't be interrupted (the callers require ext_arg for this). Returns the number of sqes submitted or -errno,
+// e.g. -ETIME when the wait timed out
+int iouring_submit (struct iouring *ring, unsigned wait_nr, long timeout_usec) {
+    unsigned to_submit = ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    if (!to_submit && !wait_nr)
+	return 0;
+    unsigned flags = (wait_nr ? IORING_ENTER_GETEVENTS : 0);
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    void *argp = NULL;
+    size_t argsz = 0;
+    if (wait_nr && (timeout_usec > 0) && ring->ext_arg) {
+	ts.tv_sec = timeout_usec / 1000000;
+	ts.tv_nsec = (timeout_usec % 1000000) * 1000;
+	memset(&arg, 0, sizeof(arg));
+	arg.ts = (unsigned long) &ts;
+	flags |= IORING_ENTER_EXT_ARG;
+	argp = &arg;
+	argsz = sizeof(arg);
+    }
+    int rc = sys_io_uring_enter(ring->fd, to_submit, wait_nr, flags, argp, argsz);
+    return ((rc < 0) ? -errno : rc);
+}
+
+struct io_uring_cqe *iouring_peek_cqe (struct iouring *ring) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+	return NULL;
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+void iouring_cqe_seen (struct iouring *ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// Registered files and buffers skip the per operation fd lookup and the
+// page pinning of the user buffer
+int iouring_register_files (struct iouring *ring, int *fds, unsigned count) {
+    return sys_io_uring_register(ring->fd, IORING_REGISTER_FILES, fds, count);
+}
+
+int iouring_register_buffers (struct iouring *ring, struct iovec *iovs, unsigned count) {
+    return sys_io_uring_register(ring->fd, IORING_REGISTER_BUFFERS, iovs, count);
+}
+
+// A sparse table, i.e. every slot -1, filled per socket with the update
+int iouring_update_file (struct iouring *ring, unsigned slot, int fd) {
+    struct io_uring_files_update update;
+    memset(&update, 0, sizeof(update));
+    update.offset = slot;
+    update.fds = (unsigned long) &fd;
+    return sys_io_uring_register(ring->fd, IORING_REGISTER_FILES_UPDATE, &update, 1);
+}
+
+// Multishot receives need Linux 6.0, older kernels reject the flag when
+// the request is prepared, i.e. a receive on a bad fd completes with
+// EINVAL there vs EBADF once the flag is known. Call it on a new ring,
+// the probe's completion is reaped here.
+bool iouring_probe_recv_multishot (struct iouring *ring) {
+    struct io_uring_sqe *sqe = iouring_get_sqe(ring);
+    if (!sqe)
+	return false;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = -1;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = 0;
+    if (iouring_submit(ring, 1, 0) < 0)
+	return false;
+    struct io_uring_cqe *cqe = iouring_peek_cqe(ring);
+    if (!cqe)
+	return false;
+    int res = cqe->res;
+    iouring_cqe_seen(ring);
+    return (res != -EINVAL);
+}
+
+bool iouring_probe_op (struct iouring *ring, int op) {
+    bool supported = false;
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = (struct io_uring_probe *) calloc(1, len);
+    if (probe) {
+	if ((sys_io_uring_register(ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0) && (op <= probe->last_op))
+	    supported = ((probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0);
+	free(probe);
+    }
+    return supported;
+}
+
+// A provided buffer ring of count (a power of two) buffers of bufsize
+// bytes carved from base. The kernel picks a buffer per receive and the
+// completion carries its id, which is handed back via the recycle
+int iouring_buf_ring_init (struct iouring *ring, unsigned short bgid, char *base, unsigned count, unsigned bufsize) {
+    ring->br_size = count * sizeof(struct io_uring_buf);
+    void *br = mmap(NULL, ring->br_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (br == MAP_FAILED)
+	return -errno;
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long) br;
+    reg.ring_entries = count;
+    reg.bgid = bgid;
+    if (sys_io_uring_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+	int err = errno;
+	munmap(br, ring->br_size);
+	return -err;
+    }
+    ring->br = (struct io_uring_buf_ring *) br;
+    ring->br_base = base;
+    ring->br_entries = count;
+    ring->br_bufsize = bufsize;
+    ring->br_tail = 0;
+    for (unsigned ix = 0; ix < count; ix++)
+	iouring_buf_ring_recycle(ring, (unsigned short) ix);
+    return 0;
+}
+
+void iouring_buf_ring_recycle (struct iouring *ring, unsigned short bid) {
+    struct io_uring_buf *buf = &ring->br->bufs[ring->br_tail & (ring->br_entries - 1)];
+    buf->addr = (unsigned long) (ring->br_base + ((size_t) bid * ring->br_bufsize));
+    buf->len = ring->br_bufsize;
+    buf->bid = bid;
+    ring->br_tail++;
+    __atomic_store_n(&ring->br->tail, ring->br_tail, __ATOMIC_RELEASE);
+}
+#endif // HAVE_IO_URING
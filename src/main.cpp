@@ -74,6 +74,13 @@
 
 #ifdef WIN32
 #include "service.h"
+#else
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 #endif
 
 /* -------------------------------------------------------------------
@@ -116,6 +123,19 @@ static thread_Settings* ext_gSettings;
 // The main thread uses this function to wait
 // for all other threads to complete
 void waitUntilQuit();
+#ifndef WIN32
+// What a --tls-cipher-sweep or --tls-engine-ab child returns to the parent
+struct TLSSweepResult {
+    struct FinalTally tally;
+    int engine;           // the crypto engine was in use
+    int cycles_valid;     // the cpu cycle counter was available
+    uint64_t cycles;
+};
+static struct TLSSweepResult tls_sweep_result;
+static int tls_sweep_fd = -1;
+static int tls_sweep_cyclesfd = -1;
+static bool tls_sweep(struct thread_Settings *inSettings);
+#endif
 
 /* -------------------------------------------------------------------
  * main()
@@ -225,6 +245,12 @@ int main(int argc, char **argv) {
 
     }
 
+#ifndef WIN32
+    // Only the sweep children continue on to run the test
+    if ((ext_gSettings->mTLSCipherSweep || isTLSEngineAB(ext_gSettings)) && !tls_sweep(ext_gSettings)) {
+	return 0;
+    }
+#endif
     int mbuflen = (ext_gSettings->mBufLen > MINMBUFALLOCSIZE) ? ext_gSettings->mBufLen : MINMBUFALLOCSIZE;
 #if (((HAVE_TUNTAP_TUN) || (HAVE_TUNTAP_TAP)) && (AF_PACKET))
     mbuflen += TAPBYTESSLOP;
@@ -272,6 +298,17 @@ int main(int argc, char **argv) {
 	if (ext_gSettings->mPortLast) {
 	    listeners_init(ext_gSettings);
 	}
+#if HAVE_LISTEN_SHARDS
+	if (isListenShards(ext_gSettings)) {
+	    listener_shards_init(ext_gSettings);
+	}
+#endif
+#if HAVE_WORKER_POOL
+	// one pool of epoll workers serves all the listeners
+	if (isWorkerPool(ext_gSettings)) {
+	    server_workers_init(ext_gSettings);
+	}
+#endif
 	break;
     default :
 	fprintf(stderr, "unknown mode");
@@ -301,10 +338,173 @@ int main(int argc, char **argv) {
 #endif
     // wait for other (client, server) threads to complete
     thread_joinall();
+#ifndef WIN32
+    if (tls_sweep_fd >= 0) {
+	tls_sweep_result.tally = reporter_final_tally;
+#if defined(__linux__) && defined(__NR_perf_event_open)
+	if (tls_sweep_cyclesfd >= 0) {
+	    // inherited counts of the (joined) traffic threads are included
+	    tls_sweep_result.cycles_valid = (read(tls_sweep_cyclesfd, &tls_sweep_result.cycles, sizeof(uint64_t)) == sizeof(uint64_t));
+	    close(tls_sweep_cyclesfd);
+	}
+#endif
+	if (write(tls_sweep_fd, &tls_sweep_result, sizeof(tls_sweep_result)) < 0)
+	    WARN_errno(1, "tls sweep write");
+	close(tls_sweep_fd);
+    }
+#endif
     // all done!
     return 0;
 } // end main
 
+#ifndef WIN32
+/* -------------------------------------------------------------------
+ * --tls-cipher-sweep runs the same client test once per cipher (comma
+ * separated) and --tls-engine-ab runs it with and without the crypto
+ * engine. Every run is a forked child, set up prior to any threads and
+ * before TLS is initialized, so the wait4() rusage is the cpu of just
+ * that run and each one loads (or doesn't load) the engine itself.
+ * The cpu cycles are counted per run when the kernel allows it.
+ *
+ * Returns true in the children, which go on to run the test,
+ * and false in the parent once the results are printed
+ * ------------------------------------------------------------------- */
+static bool tls_sweep (struct thread_Settings *inSettings) {
+    int cipher_count = 1;
+    if (inSettings->mTLSCipherSweep) {
+	for (char *c = inSettings->mTLSCipherSweep; *c; c++) {
+	    if (*c == ',')
+		cipher_count++;
+	}
+    }
+    int engines = (isTLSEngineAB(inSettings) ? 2 : 1);
+    int count = cipher_count * engines;
+    const char **ciphers = new const char *[count];
+    struct TLSSweepResult *result = new struct TLSSweepResult[count];
+    struct rusage *usage = new struct rusage[count];
+    bool *done = new bool[count];
+    const char *configured = (isSSL13(inSettings) ? inSettings->mTLSCipherSuites : inSettings->mTLSCipherList);
+    char *saveptr = NULL;
+    char *cipher = (inSettings->mTLSCipherSweep ? strtok_r(inSettings->mTLSCipherSweep, ",", &saveptr) : NULL);
+    int runs = 0;
+    while ((runs < count) && !sInterupted) {
+	ciphers[runs] = (cipher ? cipher : (configured ? configured : "default"));
+	done[runs] = false;
+	// the B run of an A/B pair is software only
+	bool software = (isTLSEngineAB(inSettings) && (runs % 2));
+	int fds[2];
+	if (pipe(fds) < 0) {
+	    WARN_errno(1, "tls sweep pipe");
+	    break;
+	}
+	fprintf(stdout, "TLS run %d/%d: cipher %s%s\n", runs + 1, count, ciphers[runs], (software ? " (software)" : ""));
+	fflush(stdout);
+	fflush(stderr);
+	pid_t pid = fork();
+	if (pid == 0) {
+	    close(fds[0]);
+	    tls_sweep_fd = fds[1];
+	    memset(&tls_sweep_result, 0, sizeof(tls_sweep_result));
+	    if (cipher) {
+		char **ciphersp = (isSSL13(inSettings) ? &inSettings->mTLSCipherSuites : &inSettings->mTLSCipherList);
+		DELETE_ARRAY(*ciphersp);
+		*ciphersp = new char[strlen(cipher) + 1];
+		strcpy(*ciphersp, cipher);
+	    }
+	    if (software) {
+		DELETE_ARRAY(inSettings->mTLSEngine);
+		inSettings->mTLSEngine = new char[strlen("none") + 1];
+		strcpy(inSettings->mTLSEngine, "none");
+	    }
+	    tls_sweep_result.engine = Settings_SetupTLS(inSettings);
+#if defined(__linux__) && defined(__NR_perf_event_open)
+	    struct perf_event_attr attr;
+	    memset(&attr, 0, sizeof(attr));
+	    attr.type = PERF_TYPE_HARDWARE;
+	    attr.size = sizeof(attr);
+	    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	    attr.inherit = 1;
+	    tls_sweep_cyclesfd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	    delete [] ciphers;
+	    delete [] result;
+	    delete [] usage;
+	    delete [] done;
+	    return true;
+	}
+	close(fds[1]);
+	if (pid < 0) {
+	    WARN_errno(1, "tls sweep fork");
+	    close(fds[0]);
+	    break;
+	}
+	int status;
+	if ((wait4(pid, &status, 0, &usage[runs]) == pid) && WIFEXITED(status) && (WEXITSTATUS(status) == 0) && \
+	    (read(fds[0], &result[runs], sizeof(struct TLSSweepResult)) == static_cast<ssize_t>(sizeof(struct TLSSweepResult)))) {
+	    done[runs] = (result[runs].tally.seconds > 0) && (result[runs].tally.bytes > 0);
+	}
+	close(fds[0]);
+	runs++;
+	if (!(runs % engines) && cipher)
+	    cipher = strtok_r(NULL, ",", &saveptr);
+    }
+    char transfer[64];
+    char bandwidth[64];
+    char cycles[32];
+    fprintf(stdout, "[TLS] results (cpu is the process total of each run)\n");
+    fprintf(stdout, "[TLS] %-30s %-10s %-14s %-18s %-26s %-11s %s\n", "Cipher", "Crypto", "Transfer", "Bandwidth", \
+	    "CPU user/sys (util)", "cpu ns/byte", "cycles/byte");
+    for (int ix = 0; ix < runs; ix++) {
+	const char *crypto = (result[ix].engine ? "engine" : "software");
+	if (!done[ix]) {
+	    fprintf(stdout, "[TLS] %-30s %-10s failed\n", ciphers[ix], "");
+	    continue;
+	}
+	double user = usage[ix].ru_utime.tv_sec + (usage[ix].ru_utime.tv_usec / 1e6);
+	double sys = usage[ix].ru_stime.tv_sec + (usage[ix].ru_stime.tv_usec / 1e6);
+	char cpu[64];
+	snprintf(cpu, sizeof(cpu), "%.2f/%.2f sec (%.0f%%)", user, sys, (100.0 * (user + sys) / result[ix].tally.seconds));
+	byte_snprintf(transfer, sizeof(transfer), static_cast<double>(result[ix].tally.bytes), toupper(static_cast<int>(inSettings->mFormat)));
+	byte_snprintf(bandwidth, sizeof(bandwidth), result[ix].tally.bytes / result[ix].tally.seconds, inSettings->mFormat);
+	strncat(bandwidth, "/sec", sizeof(bandwidth) - strlen(bandwidth) - 1);
+	if (result[ix].cycles_valid) {
+	    snprintf(cycles, sizeof(cycles), "%.2f", static_cast<double>(result[ix].cycles) / result[ix].tally.bytes);
+	} else {
+	    snprintf(cycles, sizeof(cycles), "n/a");
+	}
+	fprintf(stdout, "[TLS] %-30s %-10s %-14s %-18s %-26s %-11.3f %s\n", ciphers[ix], crypto, transfer, bandwidth, cpu, \
+		(1e9 * (user + sys) / result[ix].tally.bytes), cycles);
+    }
+    // A/B deltas of the engine run relative to the software run
+    for (int ix = 0; isTLSEngineAB(inSettings) && ((ix + 1) < runs); ix += 2) {
+	struct TLSSweepResult *a = &result[ix];
+	struct TLSSweepResult *b = &result[ix + 1];
+	if (!done[ix] || !done[ix + 1])
+	    continue;
+	if (!a->engine) {
+	    fprintf(stdout, "[TLS] A/B %s: the engine wasn't available, both runs were software\n", ciphers[ix]);
+	    continue;
+	}
+	double cpu_a = usage[ix].ru_utime.tv_sec + usage[ix].ru_stime.tv_sec + ((usage[ix].ru_utime.tv_usec + usage[ix].ru_stime.tv_usec) / 1e6);
+	double cpu_b = usage[ix + 1].ru_utime.tv_sec + usage[ix + 1].ru_stime.tv_sec + ((usage[ix + 1].ru_utime.tv_usec + usage[ix + 1].ru_stime.tv_usec) / 1e6);
+	double bw_a = a->tally.bytes / a->tally.seconds;
+	double bw_b = b->tally.bytes / b->tally.seconds;
+	// cycles per byte if counted, otherwise cpu time per byte
+	double cost_a = (a->cycles_valid && b->cycles_valid) ? (static_cast<double>(a->cycles) / a->tally.bytes) : (cpu_a / a->tally.bytes);
+	double cost_b = (a->cycles_valid && b->cycles_valid) ? (static_cast<double>(b->cycles) / b->tally.bytes) : (cpu_b / b->tally.bytes);
+	fprintf(stdout, "[TLS] A/B %s engine vs software: bandwidth %+.1f%%, %s %+.1f%%\n", ciphers[ix], \
+		(bw_b > 0 ? (100.0 * (bw_a - bw_b) / bw_b) : 0.0), ((a->cycles_valid && b->cycles_valid) ? "cycles/byte" : "cpu/byte"), \
+		(cost_b > 0 ? (100.0 * (cost_a - cost_b) / cost_b) : 0.0));
+    }
+    fflush(stdout);
+    delete [] ciphers;
+    delete [] result;
+    delete [] usage;
+    delete [] done;
+    return false;
+}
+#endif
+
 /* -------------------------------------------------------------------
  * Signal handler sets the sInterupted flag, so the object can
  * respond appropriately.. [static]
@@ -44,10 +44,14 @@
  * by Robert J. McMahon (rjmcmahon@rjmcmahon.com, bob.mcmahon@broadcom.com)
  * -------------------------------------------------------------------
  */
+#include <stddef.h>
 #include "headers.h"
 #include "packet_ring.h"
 #include "Condition.h"
 #include "Thread.h"
+#if HAVE_SCHED_YIELD
+#include <sched.h>
+#endif
 
 #ifdef HAVE_THREAD_DEBUG
 #include "Mutex.h"
@@ -55,21 +59,53 @@ static int totalpacketringcount = 0;
 Mutex packetringdebug_mutex;
 #endif
 
+#define PR_BILLION 1000000000LL
+
+static inline int64_t pr_timeval_ns (struct timeval *t) {
+    return (((int64_t) t->tv_sec * PR_BILLION) + ((int64_t) t->tv_usec * 1000));
+}
+
+static inline void pr_ns_timeval (int64_t ns, struct timeval *t) {
+    t->tv_sec = ns / PR_BILLION;
+    t->tv_usec = (ns % PR_BILLION) / 1000;
+}
+
+// A packet needs the full side record when its sampled stats are
+// valid or any of the cold fields were set
+static const struct ReportStruct pr_zero_report;
+
+static inline bool pr_isfull (struct ReportStruct *packet) {
+    return (packet->tcpstats.isValid || packet->cpustats.isValid || \
+	    memcmp(&packet->l2len, &pr_zero_report.l2len, \
+		   sizeof(struct ReportStruct) - offsetof(struct ReportStruct, l2len)));
+}
+
 struct PacketRing * packetring_init (int count, struct Condition *awake_consumer, struct Condition *awake_producer) {
     assert(awake_consumer != NULL);
     struct PacketRing *pr = NULL;
+    // round up to a power of two so the indices can be masked
+    int size = 2;
+    while ((size < count) && (size < (INT_MAX / 2)))
+	size <<= 1;
     if ((pr = (struct PacketRing *) calloc(1, sizeof(struct PacketRing)))) {
         pr->bytes = sizeof(struct PacketRing);
-	pr->data = (struct ReportStruct *) calloc(count, sizeof(struct ReportStruct));
-        pr->bytes += count * sizeof(struct ReportStruct);
+	pr->data = (struct ReportRecord *) calloc(size, sizeof(struct ReportRecord));
+        pr->bytes += size * sizeof(struct ReportRecord);
+	pr->full = (struct ReportStruct *) calloc(size, sizeof(struct ReportStruct));
+	pr->expand = (struct ReportStruct *) calloc(PACKETRING_BATCH, sizeof(struct ReportStruct));
+        pr->bytes += PACKETRING_BATCH * sizeof(struct ReportStruct);
     }
-    if (!pr || !pr->data) {
-        fprintf(stderr, "ERROR: no memory for packet ring of size %d count, try to reduce with option --NUM_REPORT_STRUCTS\n", count);
+    if (!pr || !pr->data || !pr->full || !pr->expand) {
+        fprintf(stderr, "ERROR: no memory for packet ring of size %d count, try to reduce with option --NUM_REPORT_STRUCTS\n", size);
 	exit(1);
     }
     pr->producer = 0;
+    pr->consumer_cache = 0;
     pr->consumer = 0;
-    pr->maxcount = count;
+    pr->consumer_next = 0;
+    pr->producer_cache = 0;
+    pr->maxcount = size;
+    pr->mask = size - 1;
     pr->awake_producer = awake_producer;
     pr->awake_consumer = awake_consumer;
     if (!awake_producer)
@@ -77,11 +113,12 @@ struct PacketRing * packetring_init (int count, struct Condition *awake_consumer
     else
 	pr->mutex_enable=1;
     pr->consumerdone = 0;
+    pr->producerwaiting = 0;
     pr->awaitcounter = 0;
 #ifdef HAVE_THREAD_DEBUG
     Mutex_Lock(&packetringdebug_mutex);
     totalpacketringcount++;
-    thread_debug("Init %d element packet ring=%p consumer=%p producer=%p total rings=%d enable=%d", count, \
+    thread_debug("Init %d element packet ring=%p consumer=%p producer=%p total rings=%d enable=%d", size, \
 		 (void *)pr, (void *) pr->awake_consumer, (void *) pr->awake_producer, totalpacketringcount, pr->mutex_enable);
     Mutex_Unlock(&packetringdebug_mutex);
 #endif
@@ -89,66 +126,151 @@ struct PacketRing * packetring_init (int count, struct Condition *awake_consumer
 }
 
 inline void packetring_enqueue (struct PacketRing *pr, struct ReportStruct *metapacket) {
-    while (((pr->producer == pr->maxcount) && (pr->consumer == 0)) || \
-	   ((pr->producer + 1) == pr->consumer)) {
-	// Signal the consumer thread to process a full queue
-	if (pr->mutex_enable) {
-	    assert(pr->awake_consumer != NULL);
-	    Condition_Signal(pr->awake_consumer);
-	    // Wait for the consumer to create some queue space
-	    assert(pr->awake_producer != NULL);
-	    Condition_Lock((*(pr->awake_producer)));
-	    pr->awaitcounter++;
+    unsigned int producer = pr->producer;
+    if ((producer - pr->consumer_cache) == (unsigned int) pr->maxcount) {
+	pr->consumer_cache = PR_LOAD_ACQUIRE(pr->consumer);
+	int rests = 0;
+	while ((producer - pr->consumer_cache) == (unsigned int) pr->maxcount) {
+	    // Signal the consumer thread to process a full queue
+	    if (pr->mutex_enable) {
+		assert(pr->awake_consumer != NULL);
+		Condition_Signal(pr->awake_consumer);
+		// Yield a few times first, a running consumer will
+		// usually make space well before a wait and wakeup
+		if (rests++ < PACKETRING_RESTS) {
+#if HAVE_SCHED_YIELD
+		    sched_yield();
+#endif
+		    pr->consumer_cache = PR_LOAD_ACQUIRE(pr->consumer);
+		    continue;
+		}
+		// Wait for the consumer to create some queue space,
+		// recheck after the await flag is visible as the
+		// consumer may have released in between
+		assert(pr->awake_producer != NULL);
+		Condition_Lock((*(pr->awake_producer)));
+		PR_STORE_SEQCST(pr->producerwaiting, 1);
+		pr->consumer_cache = PR_LOAD_SEQCST(pr->consumer);
+		if ((producer - pr->consumer_cache) == (unsigned int) pr->maxcount) {
+		    pr->awaitcounter++;
 #ifdef HAVE_THREAD_DEBUG_PERF
-	    {
-		struct timeval now;
-		static struct timeval prev={0, 0};
-		gettimeofday( &now, NULL );
-		if (!prev.tv_sec || (TimeDifference(now, prev) > 1.0)) {
-		    prev = now;
-		    thread_debug( "Not good, traffic's packet ring %p stalled per %p", (void *)pr, (void *)&pr->awake_producer);
+		    {
+			struct timeval now;
+			static struct timeval prev={0, 0};
+			gettimeofday( &now, NULL );
+			if (!prev.tv_sec || (TimeDifference(now, prev) > 1.0)) {
+			    prev = now;
+			    thread_debug( "Not good, traffic's packet ring %p stalled per %p", (void *)pr, (void *)&pr->awake_producer);
+			}
+		    }
+#endif
+		    Condition_TimedWait(pr->awake_producer, 1);
 		}
+		PR_STORE_RELEASE(pr->producerwaiting, 0);
+		Condition_Unlock((*(pr->awake_producer)));
 	    }
-#endif
-	    Condition_TimedWait(pr->awake_producer, 1);
-	    Condition_Unlock((*(pr->awake_producer)));
+	    pr->consumer_cache = PR_LOAD_ACQUIRE(pr->consumer);
 	}
     }
-    int writeindex;
-    if ((pr->producer + 1) == pr->maxcount)
-	writeindex = 0;
-    else
-	writeindex = (pr->producer  + 1);
-
-    /* Next two lines must be maintained as is */
-    memcpy((pr->data + writeindex), metapacket, sizeof(struct ReportStruct));
-    pr->producer = writeindex;
+    unsigned int slot = producer & pr->mask;
+    struct ReportRecord *record = &pr->data[slot];
+    record->packetID = metapacket->packetID;
+    record->packetLen = metapacket->packetLen;
+    record->packetTime = pr_timeval_ns(&metapacket->packetTime);
+    record->prevPacketTime = pr_timeval_ns(&metapacket->prevPacketTime);
+    record->sentTime = pr_timeval_ns(&metapacket->sentTime);
+    record->prevSentTime = pr_timeval_ns(&metapacket->prevSentTime);
+    record->errwrite = metapacket->errwrite;
+    record->writecnt = metapacket->writecnt;
+    record->l2errors = metapacket->l2errors;
+    record->flags = (metapacket->emptyreport ? REPORTRECORD_EMPTY : 0) | \
+	(metapacket->transit_ready ? REPORTRECORD_TRANSIT : 0);
+    if (pr_isfull(metapacket)) {
+	record->flags |= REPORTRECORD_FULL;
+	pr->full[slot] = *metapacket;
+    }
+    // publish the slot last
+    PR_STORE_RELEASE(pr->producer, producer + 1);
 }
 
-inline struct ReportStruct *packetring_dequeue (struct PacketRing *pr) {
-    struct ReportStruct *packet = NULL;
-    if (pr->producer == pr->consumer)
-	return NULL;
-
-    int readindex;
-    if ((pr->consumer + 1) == pr->maxcount)
-	readindex = 0;
-    else
-	readindex = (pr->consumer + 1);
-    packet = (pr->data + readindex);
-    // advance the consumer pointer last
-    pr->consumer = readindex;
-    if (pr->mutex_enable) {
-	// Signal the traffic thread assigned to this ring
-	// when the ring goes from having something to empty
-	if (pr->producer == pr->consumer) {
+// Hand out up to max packets, full records in place and the compact
+// ones expanded into the consumer's scratch structs. Either stays owned
+// by the consumer until its next dequeue call, which is when the
+// consumer index is published back to the producer.
+inline int packetring_dequeue_n (struct PacketRing *pr, struct ReportStruct **packets, int max) {
+    unsigned int next = pr->consumer_next;
+    bool released = false;
+    if (next != pr->consumer) {
+	released = true;
+	if (pr->mutex_enable) {
+	    PR_STORE_SEQCST(pr->consumer, next);
+	    // Wake a producer blocked on a full ring
+	    if (PR_LOAD_SEQCST(pr->producerwaiting)) {
+		Condition_Lock((*(pr->awake_producer)));
+		Condition_Signal(pr->awake_producer);
+		Condition_Unlock((*(pr->awake_producer)));
+		released = false;
+	    }
+	} else {
+	    PR_STORE_RELEASE(pr->consumer, next);
+	}
+    }
+    unsigned int avail = pr->producer_cache - next;
+    if (!avail) {
+	pr->producer_cache = PR_LOAD_ACQUIRE(pr->producer);
+	avail = pr->producer_cache - next;
+	if (!avail) {
+	    // Signal the traffic thread assigned to this ring
+	    // when the ring goes from having something to empty
+	    if (released && pr->mutex_enable) {
 #ifdef HAVE_THREAD_DEBUG
-	    // thread_debug( "Consumer signal packet ring %p empty per %p", (void *)pr, (void *)&pr->awake_producer);
+		// thread_debug( "Consumer signal packet ring %p empty per %p", (void *)pr, (void *)&pr->awake_producer);
 #endif
-	    assert(pr->awake_producer);
-	    Condition_Signal(pr->awake_producer);
+		assert(pr->awake_producer);
+		Condition_Signal(pr->awake_producer);
+	    }
+	    return 0;
+	}
+    }
+    if (avail > (unsigned int) max)
+	avail = max;
+    if (avail > PACKETRING_BATCH)
+	avail = PACKETRING_BATCH;
+    for (unsigned int ix = 0; ix < avail; ix++) {
+	unsigned int slot = (next + ix) & pr->mask;
+	struct ReportRecord *record = &pr->data[slot];
+	if (record->flags & REPORTRECORD_FULL) {
+	    packets[ix] = &pr->full[slot];
+	} else {
+	    // the scratch cold fields are never written so stay zero
+	    struct ReportStruct *packet = &pr->expand[ix];
+	    packet->packetID = record->packetID;
+	    packet->packetLen = record->packetLen;
+	    pr_ns_timeval(record->packetTime, &packet->packetTime);
+	    pr_ns_timeval(record->prevPacketTime, &packet->prevPacketTime);
+	    pr_ns_timeval(record->sentTime, &packet->sentTime);
+	    pr_ns_timeval(record->prevSentTime, &packet->prevSentTime);
+	    packet->errwrite = record->errwrite;
+	    packet->writecnt = record->writecnt;
+	    packet->l2errors = record->l2errors;
+	    packet->emptyreport = (record->flags & REPORTRECORD_EMPTY) ? 1 : 0;
+	    packet->transit_ready = (record->flags & REPORTRECORD_TRANSIT) ? 1 : 0;
+	    packets[ix] = packet;
 	}
     }
+    pr->consumer_next = next + avail;
+    return (int) avail;
+}
+
+// Give back the unprocessed tail of the last dequeue_n
+inline void packetring_unget (struct PacketRing *pr, int count) {
+    assert((pr->consumer_next - pr->consumer) >= (unsigned int) count);
+    pr->consumer_next -= count;
+}
+
+inline struct ReportStruct *packetring_dequeue (struct PacketRing *pr) {
+    struct ReportStruct *packet = NULL;
+    packetring_dequeue_n(pr, &packet, 1);
     return packet;
 }
 
@@ -191,6 +313,10 @@ void packetring_free (struct PacketRing *pr) {
 #endif
 	    free(pr->data);
 	}
+	if (pr->full)
+	    free(pr->full);
+	if (pr->expand)
+	    free(pr->expand);
 	free(pr);
     }
 }
@@ -205,15 +331,6 @@ void free_ackring(struct PacketRing *pr) {
  * done like this is not thread safe.  Use with care as there
  * is no guarantee the return value is accurate
  */
-#ifdef HAVE_THREAD_DEBUG
 inline int packetring_getcount (struct PacketRing *pr) {
-    int depth = 0;
-    if (pr->producer != pr->consumer) {
-        depth = (pr->producer > pr->consumer) ? \
-	    (pr->producer - pr->consumer) :  \
-	    ((pr->maxcount - pr->consumer) + pr->producer);
-        // printf("DEBUG: Depth=%d for packet ring %p\n", depth, (void *)pr);
-    }
-    return depth;
+    return (int) (PR_LOAD_ACQUIRE(pr->producer) - PR_LOAD_ACQUIRE(pr->consumer));
 }
-#endif
@@ -55,6 +55,9 @@
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#ifdef SSL_MODE_ASYNC
+#include <poll.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -175,9 +178,11 @@ int recvn (int inSock, void *conn, char *outBuf, int inLen, int flags) {
 #if (HAVE_DECL_MSG_PEEK)
     if (flags & MSG_PEEK) {
 	while (nleft != nread) {
-	    if (conn != NULL)
-		nread = SSL_read(conn, ptr, nleft);
-	    else
+	    if (conn != NULL) {
+		do {
+		    nread = SSL_read(conn, ptr, nleft);
+		} while ((nread <= 0) && tls_async_wait(inSock, conn, nread));
+	    } else
 	        nread = recv(inSock, ptr, nleft, flags);
 	    switch (nread) {
 	    case SOCKET_ERROR :
@@ -206,7 +211,9 @@ int recvn (int inSock, void *conn, char *outBuf, int inLen, int flags) {
     {
 	while (nleft >  0) {
 	    if (conn != NULL) {
-		nread = SSL_read(conn, ptr, nleft);
+		do {
+		    nread = SSL_read(conn, ptr, nleft);
+		} while ((nread <= 0) && tls_async_wait(inSock, conn, nread));
 	    } else {
 #if (HAVE_DECL_MSG_WAITALL)
 		nread = recv(inSock, ptr, nleft, MSG_WAITALL);
@@ -268,9 +275,11 @@ int writen (int inSock, void *conn, const void *inBuf, int inLen, int *count) {
     *count = 0;
 
     while (nleft > 0) {
-	if (conn != NULL)
+	if (conn != NULL) {
+	    do {
 		nwritten = SSL_write(conn, ptr, nleft);
-	else
+	    } while ((nwritten <= 0) && tls_async_wait(inSock, conn, nwritten));
+	} else
 	        nwritten = write(inSock, ptr, nleft);
 	(*count)++;
 	switch (nwritten) {
@@ -295,6 +304,134 @@ int writen (int inSock, void *conn, const void *inBuf, int inLen, int *count) {
     return (nwritten);
 } /* end writen */
 
+/* -------------------------------------------------------------------
+ * Wait for a paused TLS operation to become ready to resume.
+ * Only applies to connections with SSL_MODE_ASYNC set, i.e. --tls-async,
+ * where the crypto may be in flight on an offload engine.
+ * The engine's async wait fds and the socket are waited on
+ * from the same poll() so the traffic thread sleeps rather than spins,
+ * and a peer close or a socket error still ends the wait.
+ *
+ * Returns 1 if the caller should retry the same SSL call, 0 otherwise
+ * ------------------------------------------------------------------- */
+#define TLSASYNC_MAXFDS 16
+#ifdef POLLRDHUP
+#define TLSASYNC_SOCKEVENTS POLLRDHUP
+#else
+#define TLSASYNC_SOCKEVENTS 0
+#endif
+int tls_async_wait (int inSock, void *conn, int rc) {
+#ifdef SSL_MODE_ASYNC
+    SSL *ssl = (SSL *) conn;
+    struct pollfd pfds[TLSASYNC_MAXFDS + 1];
+    nfds_t npfds = 0;
+
+    if (!ssl || !(SSL_get_mode(ssl) & SSL_MODE_ASYNC))
+	return 0;
+    switch (SSL_get_error(ssl, rc)) {
+    case SSL_ERROR_WANT_ASYNC :
+    {
+	OSSL_ASYNC_FD fds[TLSASYNC_MAXFDS];
+	size_t numfds = 0;
+	size_t ix;
+	if (!SSL_get_all_async_fds(ssl, NULL, &numfds) || (numfds > TLSASYNC_MAXFDS))
+	    return 1;
+	if (numfds == 0)
+	    return 1; // engine paused w/o a wait fd, just resume the job
+	SSL_get_all_async_fds(ssl, fds, &numfds);
+	for (ix = 0; ix < numfds; ix++) {
+	    pfds[npfds].fd = fds[ix];
+	    pfds[npfds++].events = POLLIN;
+	}
+	// only its close or error, pending data, e.g. a session ticket,
+	// would end every wait
+	pfds[npfds].fd = inSock;
+	pfds[npfds++].events = TLSASYNC_SOCKEVENTS;
+	break;
+    }
+    case SSL_ERROR_WANT_ASYNC_JOB :
+	// async job pool is exhausted, retry
+	return 1;
+    case SSL_ERROR_WANT_READ :
+	pfds[npfds].fd = inSock;
+	pfds[npfds++].events = POLLIN;
+	break;
+    case SSL_ERROR_WANT_WRITE :
+	pfds[npfds].fd = inSock;
+	pfds[npfds++].events = POLLOUT;
+	break;
+    default :
+	return 0;
+    }
+    rc = poll(pfds, npfds, 1000);
+    if (rc < 0) {
+	WARN_errno((errno != EINTR), "tls async poll");
+	return (errno == EINTR);
+    }
+    // a timeout on the async fds still means retry, the job may have
+    // completed without a notification, but not so for the socket alone
+    return ((rc > 0) || (npfds > 1));
+#else
+    return 0;
+#endif
+} /* end tls_async_wait */
+
+/* -------------------------------------------------------------------
+ * Wait out the DTLS retransmit timer during a handshake, i.e. UDP
+ * with -E where a lost flight is only recovered by a retransmit.
+ * The socket is waited on until the timer expires, then
+ * DTLSv1_handle_timeout() resends the last flight.
+ *
+ * Returns 1 if the caller should retry the same SSL call, 0 otherwise
+ * ------------------------------------------------------------------- */
+#define DTLSIDLETIMEOUT 4 // units is seconds
+int dtls_timer_wait (int inSock, void *conn, int rc) {
+    SSL *ssl = (SSL *) conn;
+    fd_set readSet;
+    struct timeval timeout;
+
+    if (!ssl || !SSL_is_dtls(ssl) || SSL_is_init_finished(ssl))
+	return 0;
+    if (SSL_get_error(ssl, rc) != SSL_ERROR_WANT_READ)
+	return 0;
+    int timer = DTLSv1_get_timeout(ssl, &timeout);
+    if (!timer) {
+	// nothing in flight, e.g. the server awaiting the ClientHello
+	timeout.tv_sec = DTLSIDLETIMEOUT;
+	timeout.tv_usec = 0;
+    }
+    FD_ZERO(&readSet);
+    FD_SET(inSock, &readSet);
+    rc = select(inSock + 1, &readSet, NULL, NULL, &timeout);
+    if (rc < 0) {
+	WARN_errno((errno != EINTR), "dtls select");
+	return (errno == EINTR);
+    }
+    if (rc > 0)
+	return 1;
+    // the retransmit limit fails the handshake
+    return (timer && (DTLSv1_handle_timeout(ssl) >= 0));
+} /* end dtls_timer_wait */
+
+/* -------------------------------------------------------------------
+ * Attach a DTLS connection to a connected UDP socket. Every payload
+ * is sent as a single record in a single datagram so the link mtu
+ * is set to fit the payload (-l) and the record overhead rather
+ * than the path mtu, i.e. a large -l relies on IP fragmentation
+ * as it does in the clear
+ * ------------------------------------------------------------------- */
+#define DTLSMTUSLOP 256 // record header, explicit nonce, tag and padding
+void dtls_set_socket (void *conn, int inSock, void *peer, int payloadlen) {
+    SSL *ssl = (SSL *) conn;
+    BIO *bio = BIO_new_dgram(inSock, BIO_NOCLOSE);
+    long mtu = payloadlen + DTLSMTUSLOP;
+    if (mtu < 1500)
+	mtu = 1500;
+    BIO_ctrl_set_connected(bio, peer);
+    SSL_set_bio(ssl, bio, bio);
+    SSL_set_options(ssl, SSL_OP_NO_QUERY_MTU);
+    DTLS_set_link_mtu(ssl, mtu);
+} /* end dtls_set_socket */
 
 /*
  * Set a socket to blocking or non-blocking
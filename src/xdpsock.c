@@ -0,0 +1,453 @@
+/*---------------------------------------------------------------
+ * Copyright (c) 2026
+ * Broadcom Corporation
+ * All Rights Reserved.
+ *---------------------------------------------------------------
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute,
+ * sublicense, and/or sell copies of the Software, and to permit
+ * persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and
+ * the following disclaimers.
+ *
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimers in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ *
+ * Neither the name of Broadcom Coporation,
+ * nor the names of its contributors may be used to endorse
+ * or promote products derived from this Software without
+ * specific prior written permission.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE CONTIBUTORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ________________________________________________________________
+ *
+ * xdpsock.c
+ * Minimal AF_XDP support for the UDP traffic threads, see xdpsock.h
+ * -------------------------------------------------------------------
+ */
+#include "headers.h"
+#include "xdpsock.h"
+
+#if HAVE_AF_XDP
+#include "checksums.h"
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <net/if_arp.h>
+#include <ifaddrs.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+
+static inline int sys_bpf (int cmd, union bpf_attr *attr) {
+    return (int) syscall(__NR_bpf, cmd, attr, sizeof(union bpf_attr));
+}
+
+// The interface holding the local address, i.e. the one a connected
+// socket sends on for an on-link peer
+int xdpsock_ifindex (const struct sockaddr_in *local, char *ifname) {
+    struct ifaddrs *ifap, *ifa;
+    int ifindex = 0;
+    if (getifaddrs(&ifap) < 0)
+	return 0;
+    for (ifa = ifap; ifa != NULL; ifa = ifa->ifa_next) {
+	if (ifa->ifa_addr && (ifa->ifa_addr->sa_family == AF_INET) && \
+	    (((struct sockaddr_in *) ifa->ifa_addr)->sin_addr.s_addr == local->sin_addr.s_addr)) {
+	    ifindex = (int) if_nametoindex(ifa->ifa_name);
+	    strncpy(ifname, ifa->ifa_name, IFNAMSIZ - 1);
+	    ifname[IFNAMSIZ - 1] = '\0';
+	    break;
+	}
+    }
+    freeifaddrs(ifap);
+    return ifindex;
+}
+
+// The peer's MAC from the neighbor table, only a complete entry counts
+bool xdpsock_neighbor (const char *ifname, const struct sockaddr_in *peer, unsigned char *mac) {
+    struct arpreq req;
+    bool found = false;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+	return false;
+    memset(&req, 0, sizeof(req));
+    memcpy(&req.arp_pa, peer, sizeof(struct sockaddr_in));
+    strncpy(req.arp_dev, ifname, sizeof(req.arp_dev) - 1);
+    if ((ioctl(fd, SIOCGARP, &req) == 0) && (req.arp_flags & ATF_COM)) {
+	memcpy(mac, req.arp_ha.sa_data, ETHER_ADDR_LEN);
+	found = true;
+    }
+    close(fd);
+    return found;
+}
+
+int xdpsock_mtu (const char *ifname) {
+    struct ifreq ifr;
+    int mtu = -1;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+	return -1;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFMTU, &ifr) == 0)
+	mtu = ifr.ifr_mtu;
+    close(fd);
+    return mtu;
+}
+
+static int xdpsock_ring_map (struct xdpsock *xsk, struct xdpsock_ring *ring, const struct xdp_ring_offset *off, size_t descsize, off_t pgoff) {
+    ring->map_size = off->desc + (XDPSOCK_RING * descsize);
+    ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, xsk->fd, pgoff);
+    if (ring->map == MAP_FAILED) {
+	ring->map = NULL;
+	return -1;
+    }
+    ring->producer = (uint32_t *) ((char *) ring->map + off->producer);
+    ring->consumer = (uint32_t *) ((char *) ring->map + off->consumer);
+    ring->desc = (char *) ring->map + off->desc;
+    ring->size = XDPSOCK_RING;
+    ring->mask = XDPSOCK_RING - 1;
+    return 0;
+}
+
+// A socket bound to one queue of the interface in generic (SKB) copy
+// mode, which any driver supports, e.g. veth. A receive socket gets its
+// fill ring stocked with half the frames, a transmit socket keeps all of
+// them on its free list. Returns NULL with errno set on failure
+struct xdpsock *xdpsock_init (int ifindex, int queue, bool rx) {
+    int size = XDPSOCK_RING;
+    struct xdpsock *xsk = (struct xdpsock *) calloc(1, sizeof(struct xdpsock));
+    if (!xsk)
+	return NULL;
+    xsk->ifindex = ifindex;
+    xsk->queue = queue;
+    xsk->map_fd = -1;
+    xsk->prog_fd = -1;
+    xsk->link_fd = -1;
+    if ((xsk->fd = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0)) < 0)
+	goto Fail;
+    xsk->umem_size = (size_t) XDPSOCK_FRAMES * XDPSOCK_FRAMESIZE;
+    xsk->umem = (char *) mmap(NULL, xsk->umem_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (xsk->umem == MAP_FAILED) {
+	xsk->umem = NULL;
+	goto Fail;
+    }
+    struct xdp_umem_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.addr = (unsigned long) xsk->umem;
+    reg.len = xsk->umem_size;
+    reg.chunk_size = XDPSOCK_FRAMESIZE;
+    if ((setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0) || \
+	(setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING, &size, sizeof(size)) < 0) || \
+	(setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &size, sizeof(size)) < 0) || \
+	(setsockopt(xsk->fd, SOL_XDP, (rx ? XDP_RX_RING : XDP_TX_RING), &size, sizeof(size)) < 0))
+	goto Fail;
+    struct xdp_mmap_offsets off;
+    socklen_t optlen = sizeof(off);
+    if ((getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0) || \
+	(xdpsock_ring_map(xsk, &xsk->fill, &off.fr, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) < 0) || \
+	(xdpsock_ring_map(xsk, &xsk->comp, &off.cr, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) < 0))
+	goto Fail;
+    if (rx) {
+	if (xdpsock_ring_map(xsk, &xsk->rx, &off.rx, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) < 0)
+	    goto Fail;
+	uint64_t *fill = (uint64_t *) xsk->fill.desc;
+	for (unsigned ix = 0; ix < xsk->fill.size; ix++)
+	    fill[ix] = (uint64_t) ix * XDPSOCK_FRAMESIZE;
+	xsk->fill.local = xsk->fill.size;
+	__atomic_store_n(xsk->fill.producer, xsk->fill.local, __ATOMIC_RELEASE);
+    } else {
+	if (xdpsock_ring_map(xsk, &xsk->tx, &off.tx, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) < 0)
+	    goto Fail;
+	if (!(xsk->free_frames = (uint64_t *) malloc(XDPSOCK_FRAMES * sizeof(uint64_t))))
+	    goto Fail;
+	for (unsigned ix = 0; ix < XDPSOCK_FRAMES; ix++)
+	    xsk->free_frames[ix] = (uint64_t) ix * XDPSOCK_FRAMESIZE;
+	xsk->free_count = XDPSOCK_FRAMES;
+    }
+    struct sockaddr_xdp sxdp;
+    memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = ifindex;
+    sxdp.sxdp_queue_id = queue;
+    sxdp.sxdp_flags = XDP_COPY;
+    if (bind(xsk->fd, (struct sockaddr *) &sxdp, sizeof(sxdp)) < 0)
+	goto Fail;
+    return xsk;
+  Fail:
+    {
+	int err = errno;
+	xdpsock_free(xsk);
+	errno = err;
+    }
+    return NULL;
+}
+
+void xdpsock_free (struct xdpsock *xsk) {
+    if (!xsk)
+	return;
+    // the link goes first so the program stops redirecting to the socket
+    if (xsk->link_fd >= 0)
+	close(xsk->link_fd);
+    if (xsk->prog_fd >= 0)
+	close(xsk->prog_fd);
+    if (xsk->map_fd >= 0)
+	close(xsk->map_fd);
+    if (xsk->fill.map)
+	munmap(xsk->fill.map, xsk->fill.map_size);
+    if (xsk->comp.map)
+	munmap(xsk->comp.map, xsk->comp.map_size);
+    if (xsk->rx.map)
+	munmap(xsk->rx.map, xsk->rx.map_size);
+    if (xsk->tx.map)
+	munmap(xsk->tx.map, xsk->tx.map_size);
+    if (xsk->fd >= 0)
+	close(xsk->fd);
+    if (xsk->umem)
+	munmap(xsk->umem, xsk->umem_size);
+    free(xsk->free_frames);
+    free(xsk);
+}
+
+#define XDPINSN(c, d, s, o, i) {(uint8_t) (c), (uint8_t) (d), (uint8_t) (s), (int16_t) (o), (int32_t) (i)}
+#define XDPPASS_PC 24
+
+// Load and attach (as a bpf link in generic mode) an XDP program which
+// redirects the one flow, peer address and port to the local port, to
+// the socket and passes everything else to the stack. Closing the link,
+// i.e. xdpsock_free(), or the process exiting, detaches it. Returns zero
+// or -errno, e.g. -EBUSY when the interface already has a program
+int xdpsock_redirect (struct xdpsock *xsk, const struct sockaddr_in *local, const struct sockaddr_in *peer) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(int);
+    attr.value_size = sizeof(int);
+    attr.max_entries = xsk->queue + 1;
+    if ((xsk->map_fd = sys_bpf(BPF_MAP_CREATE, &attr)) < 0)
+	return -errno;
+    // the compares of the loaded values (host order loads of network
+    // order fields) use the raw field values, i.e. no byte swaps
+    struct bpf_insn prog[] = {
+	XDPINSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, data), 0),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_6, offsetof(struct xdp_md, data_end), 0),
+	XDPINSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),
+	XDPINSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, XDPSOCK_UDP4HDRLEN),
+	XDPINSN(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, XDPPASS_PC - 6, 0),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 12, 0), // ether type
+	XDPINSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, XDPPASS_PC - 8, htons(ETHERTYPE_IP)),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 14, 0), // version and ihl
+	XDPINSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, XDPPASS_PC - 10, 0x45),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_2, 23, 0), // protocol
+	XDPINSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, XDPPASS_PC - 12, IPPROTO_UDP),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_5, BPF_REG_2, 26, 0), // source address
+	XDPINSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, XDPPASS_PC - 14, peer->sin_addr.s_addr),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 34, 0), // source port
+	XDPINSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, XDPPASS_PC - 16, peer->sin_port),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, 36, 0), // destination port
+	XDPINSN(BPF_JMP32 | BPF_JNE | BPF_K, BPF_REG_5, 0, XDPPASS_PC - 18, local->sin_port),
+	XDPINSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, rx_queue_index), 0),
+	XDPINSN(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, xsk->map_fd),
+	XDPINSN(0, 0, 0, 0, 0),
+	// a queue without a socket falls back to the stack
+	XDPINSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS),
+	XDPINSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+	XDPINSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+	XDPINSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS), // XDPPASS_PC
+	XDPINSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+    };
+    char license[] = "GPL";
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insn_cnt = sizeof(prog) / sizeof(struct bpf_insn);
+    attr.insns = (unsigned long) prog;
+    attr.license = (unsigned long) license;
+    attr.expected_attach_type = BPF_XDP;
+    strncpy(attr.prog_name, "iperf_xsk", sizeof(attr.prog_name) - 1);
+    if ((xsk->prog_fd = sys_bpf(BPF_PROG_LOAD, &attr)) < 0)
+	return -errno;
+    int key = xsk->queue;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = xsk->map_fd;
+    attr.key = (unsigned long) &key;
+    attr.value = (unsigned long) &xsk->fd;
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0)
+	return -errno;
+    memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = xsk->prog_fd;
+    attr.link_create.target_ifindex = xsk->ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+    if ((xsk->link_fd = sys_bpf(BPF_LINK_CREATE, &attr)) < 0)
+	return -errno;
+    return 0;
+}
+
+static inline uint16_t ipv4_checksum (const void *iphdr) {
+    const uint16_t *data = (const uint16_t *) iphdr;
+    uint32_t sum = 0;
+    for (int ix = 0; ix < 10; ix++)
+	sum += data[ix];
+    while (sum >> 16)
+	sum = (sum & 0xffff) + (sum >> 16);
+    return (uint16_t) ~sum;
+}
+
+// The per frame headers, the lengths and checksums are set per frame
+bool xdpsock_udp4_flow (struct xdpsock *xsk, const char *ifname, const struct sockaddr_in *local, const struct sockaddr_in *peer, const unsigned char *dstmac, int ttl, int tos) {
+    struct ifreq ifr;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+	return false;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    int rc = ioctl(fd, SIOCGIFHWADDR, &ifr);
+    close(fd);
+    if ((rc < 0) || (ifr.ifr_hwaddr.sa_family != ARPHRD_ETHER))
+	return false;
+    memset(xsk->hdr, 0, sizeof(xsk->hdr));
+    struct ether_header *eth = (struct ether_header *) xsk->hdr;
+    struct iphdr *ip = (struct iphdr *) (xsk->hdr + sizeof(struct ether_header));
+    struct udphdr *udp = (struct udphdr *) ((char *) ip + sizeof(struct iphdr));
+    memcpy(eth->ether_dhost, dstmac, ETHER_ADDR_LEN);
+    memcpy(eth->ether_shost, ifr.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+    eth->ether_type = htons(ETHERTYPE_IP);
+    ip->version = 4;
+    ip->ihl = 5;
+    ip->tos = (uint8_t) tos;
+    ip->frag_off = htons(0x4000); // don't fragment
+    ip->ttl = (uint8_t) ttl;
+    ip->protocol = IPPROTO_UDP;
+    ip->saddr = local->sin_addr.s_addr;
+    ip->daddr = peer->sin_addr.s_addr;
+    udp->source = local->sin_port;
+    udp->dest = peer->sin_port;
+    return true;
+}
+
+// A free frame for the next datagram, the pointer is to its payload.
+// Returns NULL when every frame is in flight or the tx ring is full
+char *xdpsock_udp4_alloc (struct xdpsock *xsk, uint64_t *addr) {
+    if (!xsk->free_count && !xdpsock_tx_complete(xsk))
+	return NULL;
+    if ((xsk->tx.local - __atomic_load_n(xsk->tx.consumer, __ATOMIC_ACQUIRE)) >= xsk->tx.size)
+	return NULL;
+    *addr = xsk->free_frames[--xsk->free_count];
+    return (xsk->umem + *addr + XDPSOCK_UDP4HDRLEN);
+}
+
+// Frame the payload of len bytes and queue it, the kick publishes it
+void xdpsock_udp4_queue (struct xdpsock *xsk, uint64_t addr, int len) {
+    char *frame = xsk->umem + addr;
+    memcpy(frame, xsk->hdr, XDPSOCK_UDP4HDRLEN);
+    struct iphdr *ip = (struct iphdr *) (frame + sizeof(struct ether_header));
+    struct udphdr *udp = (struct udphdr *) ((char *) ip + sizeof(struct iphdr));
+    int udplen = len + (int) sizeof(struct udphdr);
+    ip->tot_len = htons((uint16_t) (udplen + sizeof(struct iphdr)));
+    ip->check = ipv4_checksum(ip);
+    udp->len = htons((uint16_t) udplen);
+    // udpchecksum() verifies, i.e. it returns the complement of the sum
+    // over the datagram. With the checksum field all ones, which is zero
+    // in one's complement, that's the checksum to send
+    udp->check = 0xffff;
+    uint16_t csum = (uint16_t) udpchecksum(ip, udp, udplen, 0);
+    udp->check = (csum ? csum : 0xffff);
+    struct xdp_desc *desc = &((struct xdp_desc *) xsk->tx.desc)[xsk->tx.local & xsk->tx.mask];
+    desc->addr = addr;
+    desc->len = (uint32_t) (XDPSOCK_UDP4HDRLEN + len);
+    desc->options = 0;
+    xsk->tx.local++;
+}
+
+// In copy mode the frames go out from within the sendto(), returns its
+// result, a transient EAGAIN, EBUSY or ENOBUFS leaves frames queued
+int xdpsock_tx_kick (struct xdpsock *xsk) {
+    __atomic_store_n(xsk->tx.producer, xsk->tx.local, __ATOMIC_RELEASE);
+    int rc = (int) sendto(xsk->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+    xdpsock_tx_complete(xsk);
+    return rc;
+}
+
+// Sent frames back to the free list, returns the number reaped
+unsigned xdpsock_tx_complete (struct xdpsock *xsk) {
+    uint32_t producer = __atomic_load_n(xsk->comp.producer, __ATOMIC_ACQUIRE);
+    unsigned count = producer - xsk->comp.local;
+    uint64_t *comp = (uint64_t *) xsk->comp.desc;
+    for (unsigned ix = 0; ix < count; ix++)
+	xsk->free_frames[xsk->free_count++] = comp[(xsk->comp.local + ix) & xsk->comp.mask];
+    xsk->comp.local = producer;
+    __atomic_store_n(xsk->comp.consumer, xsk->comp.local, __ATOMIC_RELEASE);
+    return count;
+}
+
+// Kick until every queued frame has completed or the timeout, returns
+// the number of frames still in flight
+unsigned xdpsock_tx_drain (struct xdpsock *xsk, int timeout_ms) {
+    xdpsock_tx_complete(xsk);
+    while ((xsk->free_count < XDPSOCK_FRAMES) && (timeout_ms-- > 0)) {
+	xdpsock_tx_kick(xsk);
+	if (xsk->free_count < XDPSOCK_FRAMES)
+	    poll(NULL, 0, 1);
+    }
+    return (XDPSOCK_FRAMES - xsk->free_count);
+}
+
+// The number of received frames ready, up to max, which stay owned by
+// the caller until xdpsock_rx_release()
+unsigned xdpsock_rx_peek (struct xdpsock *xsk, unsigned max) {
+    unsigned count = __atomic_load_n(xsk->rx.producer, __ATOMIC_ACQUIRE) - xsk->rx.local;
+    return ((count < max) ? count : max);
+}
+
+// The payload of the ix'th peeked frame, or NULL when it isn't a valid
+// datagram of the peer's flow. The checksum isn't verified, a locally
+// sent datagram, e.g. over veth, carries only the partial (pseudo header)
+// sum as the stack left the rest to an offload the copy never ran
+char *xdpsock_udp4_rx (struct xdpsock *xsk, unsigned ix, const struct sockaddr_in *peer, int *len) {
+    struct xdp_desc *desc = &((struct xdp_desc *) xsk->rx.desc)[(xsk->rx.local + ix) & xsk->rx.mask];
+    char *frame = xsk->umem + desc->addr;
+    if (desc->len < XDPSOCK_UDP4HDRLEN)
+	return NULL;
+    struct iphdr *ip = (struct iphdr *) (frame + sizeof(struct ether_header));
+    struct udphdr *udp = (struct udphdr *) ((char *) ip + sizeof(struct iphdr));
+    int udplen = ntohs(udp->len);
+    if ((ip->saddr != peer->sin_addr.s_addr) || (udp->source != peer->sin_port) || \
+	(udplen < (int) sizeof(struct udphdr)) || ((udplen + XDPSOCK_UDP4HDRLEN - (int) sizeof(struct udphdr)) > (int) desc->len))
+	return NULL;
+    *len = udplen - (int) sizeof(struct udphdr);
+    return (frame + XDPSOCK_UDP4HDRLEN);
+}
+
+// Hand count frames back to the kernel via the fill ring
+void xdpsock_rx_release (struct xdpsock *xsk, unsigned count) {
+    uint64_t *fill = (uint64_t *) xsk->fill.desc;
+    for (unsigned ix = 0; ix < count; ix++) {
+	struct xdp_desc *desc = &((struct xdp_desc *) xsk->rx.desc)[(xsk->rx.local + ix) & xsk->rx.mask];
+	// aligned chunks, the frame address is the chunk start
+	fill[(xsk->fill.local + ix) & xsk->fill.mask] = desc->addr & ~((uint64_t) XDPSOCK_FRAMESIZE - 1);
+    }
+    xsk->rx.local += count;
+    __atomic_store_n(xsk->rx.consumer, xsk->rx.local, __ATOMIC_RELEASE);
+    xsk->fill.local += count;
+    __atomic_store_n(xsk->fill.producer, xsk->fill.local, __ATOMIC_RELEASE);
+}
+#endif // HAVE_AF_XDP
@@ -0,0 +1,33 @@
+#!/bin/bash -e
+. $(dirname $0)/base.sh
+
+# usage:
+# run_iperf -s server args   -c client args
+#
+# client args should contain $ip or -V $ip6
+# results returned in $results
+
+run_iperf    \
+    -s --parallel 4 -t 4     \
+    -c $ip -P 4 -i 0.5 -t 3 --reporter-threads=2
+
+# The client's report, through its [SUM] total
+report=$(echo "$results" | sed -n '1,/^\[SUM\] *0\.00-[1-9]/p')
+
+# Every interval of the streams, and their totals, has to have a [SUM]
+# line, and it has to follow the last of the streams' lines for it
+sum_follows() {
+    local span=${1//./\\.}
+    local last=$(echo "$report" | grep -n "^\[ *[0-9]*\] *$span sec" | tail -1 | cut -d: -f1)
+    local sum=$(echo "$report" | grep -n "^\[SUM\] *$span sec" | head -1 | cut -d: -f1)
+    if [ -z "$sum" ] || [ "$sum" -lt "$last" ]; then
+	echo "[SUM] $1 missing or ahead of its streams"
+	return 1
+    fi
+}
+
+spans=$(echo "$report" | sed -n -E 's/^\[ *[0-9]+\] +([0-9.]+-[0-9.]+) sec .*/\1/p' | sort -u)
+[ -n "$spans" ]
+for span in $spans; do
+    sum_follows $span
+done